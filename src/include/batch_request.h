@@ -146,6 +146,13 @@ struct rq_manage {
 	pbs_list_head    rq_attr;	/* svrattrlist */
 };
 
+/* ModifyJobs - a Manage structure for each job to modify */
+
+struct rq_modifyjobs {
+	int		  rq_count;	/* number of entries in rq_jobs */
+	struct rq_manage *rq_jobs;
+};
+
 /* HoldJob -  plus preference flag */
 
 struct rq_hold {
@@ -193,6 +200,14 @@ struct rq_runjob {
 };
 
 
+/* AsyrunJobs - a RunJob structure for each job to run */
+
+struct rq_runjobs {
+	int		  rq_count;	/* number of entries in rq_jobs */
+	struct rq_runjob *rq_jobs;
+};
+
+
 /* SignalJob */
 
 struct rq_signal {
@@ -345,12 +360,14 @@ struct batch_request {
 		struct rq_message	rq_message;
 		struct rq_py_spawn	rq_py_spawn;
 		struct rq_manage	rq_modify;
+		struct rq_modifyjobs	rq_modifyjobs;
 		struct rq_move		rq_move;
 		struct rq_register	rq_register;
 		struct rq_manage	rq_release;
 		char		        rq_rerun[PBS_MAXSVRJOBID+1];
 		struct rq_rescq		rq_rescq;
 		struct rq_runjob        rq_run;
+		struct rq_runjobs	rq_runjobs;
 		struct rq_selstat       rq_select;
 		int			rq_shutdown;
 		struct rq_signal	rq_signal;
@@ -404,6 +421,7 @@ extern void  req_register(struct batch_request *req);
 extern void  req_releasejob(struct batch_request *req);
 extern void  req_rescq(struct batch_request *req);
 extern void  req_runjob(struct batch_request *req);
+extern void  req_asyrunjobs(struct batch_request *req);
 extern void  req_selectjobs(struct batch_request *req);
 extern void  req_stat_que(struct batch_request *req);
 extern void  req_stat_svr(struct batch_request *req);
@@ -431,6 +449,7 @@ extern int decode_DIS_CopyHookFile(int socket, struct batch_request *);
 extern int decode_DIS_DelHookFile(int socket, struct batch_request *);
 extern int decode_DIS_JobObit(int socket, struct batch_request *);
 extern int decode_DIS_Manage(int socket, struct batch_request *);
+extern int decode_DIS_ModifyJobs(int socket, struct batch_request *);
 extern int decode_DIS_MoveJob(int socket, struct batch_request *);
 extern int decode_DIS_MessageJob(int socket, struct batch_request *);
 extern int decode_DIS_PySpawn(int socket, struct batch_request *);
@@ -441,6 +460,7 @@ extern int decode_DIS_ReqHdr(int socket, struct batch_request *, int *tp, int *p
 extern int decode_DIS_Rescl(int socket, struct batch_request *);
 extern int decode_DIS_Rescq(int socket, struct batch_request *);
 extern int decode_DIS_Run(int socket, struct batch_request *);
+extern int decode_DIS_RunJobs(int socket, struct batch_request *);
 extern int decode_DIS_ShutDown(int socket, struct batch_request *);
 extern int decode_DIS_SignalJob(int socket, struct batch_request *);
 extern int decode_DIS_Status(int socket, struct batch_request *);
@@ -479,6 +479,7 @@ struct job {
 	pbs_list_link       ji_jobque;	/* SVR: links to jobs in same queue */
 	/* MOM: links to polled jobs */
 	pbs_list_link	ji_unlicjobs;	/* links to unlicensed jobs */
+	pbs_list_link	ji_ownerjobs;	/* SVR: links to jobs of same owner */
 	time_t		ji_momstat;	/* SVR: time of last status from MOM */
 	/* MOM: time job suspend (Cray)	*/
 	int		ji_modified;	/* struct changed, needs to be saved */
@@ -566,6 +567,16 @@ struct job {
 	 */
 	int             ji_newjob;
 
+	/*
+	 *	Saves of a job to the database may be deferred and written with
+	 *	the saves of other jobs in one transaction (see job_save_db).
+	 *	A job with a deferred save is linked into the list of pending
+	 *	saves by ji_dbsavelink, and ji_dbsavetype holds the type of the
+	 *	update to write.  ji_dbsavetype is -1 when no save is pending.
+	 */
+	pbs_list_link	ji_dbsavelink;
+	int		ji_dbsavetype;
+
 	/*
 	 *	This variable is used to temporarily hold the script for a new job
 	 *	in memory instead of immediately saving it to the database in the
@@ -1095,7 +1106,10 @@ void*	job_or_resv_recov_fs(char *, int);
 extern job  *job_recov_db(char *, int);
 extern void *job_or_resv_recov_db(char *, int);
 extern int  job_save_db(job *, int);
+extern int  job_save_db_sync(job *, int);
 extern int   job_or_resv_save_db(void *, int, int);
+extern void  flush_job_saves(void);
+extern void  cancel_job_save(job *);
 #define job_recov job_recov_db
 #define job_save job_save_db
 #define job_or_resv_save job_or_resv_save_db
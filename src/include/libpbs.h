@@ -278,6 +278,8 @@ struct batch_reply {
 #define PBS_BATCH_DelHookFile	86
 #define PBS_BATCH_MomRestart	87
 #define PBS_BATCH_AuthExternal	88
+#define PBS_BATCH_ModifyJobs	89
+#define PBS_BATCH_AsyrunJobs	90
 
 #define PBS_BATCH_FileOpt_Default	0
 #define PBS_BATCH_FileOpt_OFlg		1
@@ -336,6 +338,7 @@ extern struct batch_status *PBSD_status(int c, int function,
 	char *id, struct attrl *attrib, char *extend);
 
 extern struct batch_status *PBSD_status_get(int c);
+extern struct batch_status *PBSD_status_list(struct batch_reply *);
 extern char * PBSD_queuejob(int c, char *j, char *d,
 	struct attropl *a, char *ex, int rpp, char **msgid);
 extern int decode_DIS_svrattrl(int sock, pbs_list_head *phead);
@@ -350,6 +353,7 @@ extern int encode_DIS_JobFile(int socket, int, char *, int, char *, int);
 extern int encode_DIS_JobId(int socket, char *);
 extern int encode_DIS_Manage(int socket, int cmd, int objt,
 	char *, struct attropl *);
+extern int encode_DIS_ModifyJobs(int socket, struct batch_status *jobs);
 extern int encode_DIS_MoveJob(int socket, char *jid, char *dest);
 extern int encode_DIS_MessageJob(int socket, char *jid, int fopt, char *m);
 extern int encode_DIS_PySpawn(int socket, char *jid, char **argv, char **envp);
@@ -362,6 +366,7 @@ extern int encode_DIS_ReqHdr(int socket, int reqt, char *user);
 extern int encode_DIS_Rescq(int socket, char **rlist, int num);
 extern int encode_DIS_Run(int socket, char *jid, char *where,
 	unsigned long resch);
+extern int encode_DIS_RunJobs(int socket, struct attrl *jobs);
 extern int encode_DIS_ShutDown(int socket, int manner);
 extern int encode_DIS_SignalJob(int socket, char *jid, char *sig);
 extern int encode_DIS_Status(int socket, char *objid, struct attrl *);
@@ -99,6 +99,18 @@ extern int	has_hardlimits(void *);
  */
 extern int	has_softlimits(void *);
 
+/**	@fn unsigned long long lim_signature(void *p, unsigned long long sig)
+ *	@brief	fold the limits set in limit storage into a signature
+ *
+ *	@param p	the limit storage
+ *	@param sig	the signature so far
+ *
+ *	@return		the new signature
+ *
+ *	@par MT-safe:	No
+ */
+extern unsigned long long	lim_signature(void *, unsigned long long);
+
 /**	@fn int is_reslimattr(const struct attrl *a)
  *	@brief	is the given attribute a new-style resource limit attribute?
  *
@@ -222,6 +222,7 @@ extern "C" {
 #define ATTR_count	"state_count"
 #define ATTR_number	"number_jobs"
 #define ATTR_jobscript_max_size "jobscript_max_size"
+#define ATTR_nodestatmaxage "node_status_max_age"
 #ifdef NAS
 /* localmod 046 */
 #define	ATTR_maxstarve	"max_starve"
@@ -299,6 +300,7 @@ extern "C" {
 #define ATTR_job_sort_formula_threshold "job_sort_formula_threshold"
 #define ATTR_throughput_mode "throughput_mode"
 #define ATTR_opt_backfill_fuzzy "opt_backfill_fuzzy"
+#define ATTR_sched_cycle_profile "sched_cycle_profile"
 
 
 /* additional node "attributes" names */
@@ -329,6 +331,10 @@ extern "C" {
 #define ATTR_RESC_TYPE		"type"
 #define ATTR_RESC_FLAG		"flag"
 
+/* per job status of the jobs pbs_alterjobs() or pbs_asyrunjobs() failed for */
+#define ATTR_JOBS_ERRCODE	"error_code"
+#define ATTR_JOBS_ERRTEXT	"error_text"
+
 /* various attribute values */
 
 #define CHECKPOINT_UNSPECIFIED "u"
@@ -514,8 +520,12 @@ DECLDIR char *__pbs_server_location(void);
 
 DECLDIR int pbs_asyrunjob(int, char *, char *, char *);
 
+DECLDIR int pbs_asyrunjobs(int, struct attrl *, struct batch_status **, char *);
+
 DECLDIR int pbs_alterjob(int, char *, struct attrl *, char *);
 
+DECLDIR int pbs_alterjobs(int, struct batch_status *, struct batch_status **, char *);
+
 DECLDIR int pbs_connect(char *);
 
 DECLDIR int pbs_connect_extend(char *, char *);
@@ -601,8 +611,12 @@ extern char *__pbs_server_location(void);
 
 extern int pbs_asyrunjob(int, char *, char *, char *);
 
+extern int pbs_asyrunjobs(int, struct attrl *, struct batch_status **, char *);
+
 extern int pbs_alterjob(int, char *, struct attrl *, char *);
 
+extern int pbs_alterjobs(int, struct batch_status *, struct batch_status **, char *);
+
 extern int pbs_connect(char *);
 
 extern int pbs_connect_extend(char *, char *);
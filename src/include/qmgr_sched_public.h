@@ -56,3 +56,4 @@ ATTR_preempt_targets_enable,
 ATTR_job_sort_formula_threshold,
 ATTR_throughput_mode,
 ATTR_opt_backfill_fuzzy,
+ATTR_sched_cycle_profile,
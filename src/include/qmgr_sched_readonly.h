@@ -49,3 +49,4 @@
 
 ATTR_version,
 ATTR_SchedHost,
+ATTR_sched_cycle_profile,
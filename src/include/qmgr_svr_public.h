@@ -127,4 +127,5 @@ ATTR_resv_post_processing,
 ATTR_backfill_depth,
 ATTR_job_requeue_timeout,
 ATTR_jobscript_max_size,
+ATTR_nodestatmaxage,
 #endif	/* _QMGR_SVR_PUBLIC_H */
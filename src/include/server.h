@@ -146,6 +146,7 @@ enum srv_atr {
 	SRV_ATR_queued_jobs_threshold,
 	SRV_ATR_queued_jobs_threshold_res,
 	SVR_ATR_jobscript_max_size,
+	SVR_ATR_node_status_max_age,
 	/* This must be last */
 	SRV_ATR_LAST
 };
@@ -191,6 +192,7 @@ enum sched_atr {
 	SCHED_ATR_job_sort_formula_threshold,
 	SCHED_ATR_throughput_mode,
 	SCHED_ATR_opt_backfill_fuzzy,
+	SCHED_ATR_sched_cycle_profile,
 #include "site_sched_attr_enum.h"
 	/* This must be last */
 	SCHED_ATR_LAST
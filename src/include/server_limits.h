@@ -73,6 +73,8 @@ extern "C" {
 #define PBS_RESTAT_JOB	       30 /* ask mom for status only once in 30 sec  */
 #define PBS_STAGEFAIL_WAIT   1800 /* retry time after stage in failuere */
 #define PBS_MAX_ARRAY_JOB_DFL 10000 /* default max size of an array job */
+#define PBS_JOB_SAVE_DELAY      1 /* most secs a deferred job save waits   */
+#define PBS_JOB_SAVE_MAX_PENDING 1000 /* deferred job saves forcing a flush */
 
 /* Server Database information - path names */
 
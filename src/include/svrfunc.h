@@ -138,6 +138,7 @@ extern int find_prov_vnode_list(job *pjob, exec_vnode_listtype *prov_vnodes, cha
 
 #if !defined(PBS_MOM) && defined(_AVLTREE_H)
 extern AVL_IX_DESC *AVL_jctx;
+extern AVL_IX_DESC *AVL_jowner;
 extern AVL_IX_REC  *svr_avlkey_create(const char *keystr);
 #endif
 
@@ -230,6 +231,8 @@ extern int   get_credential(char *, job *, int, char **, size_t *);
 #endif  /* _TICKET_H */
 extern int   local_move(job *, struct batch_request *);
 extern int   user_read_password(char *user, char **cred, size_t *len);
+extern void  svr_ownerjob_oper(job *pjob, int delkey);
+extern pbs_list_head *find_ownerjobs(char *user, int *pnumjobs);
 
 #endif	/* _PBS_JOB_H */
 
@@ -247,6 +250,7 @@ extern void  req_holdjob(struct batch_request *preq);
 extern void  req_messagejob(struct batch_request *preq);
 extern void  req_py_spawn(struct batch_request *preq);
 extern void  req_modifyjob(struct batch_request *preq);
+extern void  req_modifyjobs(struct batch_request *preq);
 extern void  req_orderjob(struct batch_request *req);
 extern void  req_rescreserve(struct batch_request *preq);
 extern void  req_rescfree(struct batch_request *preq);
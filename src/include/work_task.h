@@ -67,8 +67,18 @@ enum work_type {
 	                        */
 };
 
+/*
+ * Timed tasks due within WORK_WHEEL_SIZE seconds are kept on a wheel of
+ * one second slots, later ones on task_list_timed until they come in
+ * range.  Event tasks are also hashed on their event id into one of
+ * WORK_EVENT_HASH lists through wt_linkevent, see find_work_task().
+ */
+#define WORK_WHEEL_SIZE	4096
+#define WORK_EVENT_HASH	1024
+
 struct work_task  {
 	pbs_list_link	 wt_linkall;	/* link to event type work list */
+	pbs_list_link	 wt_linkevent;	/* link to event tasks of same hash */
 	pbs_list_link	 wt_linkobj;	/* link to others of same object */
 	pbs_list_link	 wt_linkobj2;   /* link to another set of similarity */
 	long		 wt_event;	/* event id: time, pid, socket, ... */
@@ -88,6 +98,7 @@ extern void dispatch_task(struct work_task *);
 extern void delete_task(struct work_task *);
 extern void delete_task_by_parm1(void *parm1);
 extern int  has_task_by_parm1(void *parm1);
+extern struct work_task *find_work_task(enum work_type, long event, void *parm1);
 extern time_t default_next_task(void);
 
 #ifdef	__cplusplus
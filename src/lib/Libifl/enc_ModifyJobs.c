@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+
+/**
+ * @file	enc_ModifyJobs.c
+ * @brief
+ * encode_DIS_ModifyJobs() - encode a Modify Jobs Batch Request
+ *
+ *	This request carries the attribute changes for several jobs so they
+ *	can be altered with a single round trip to the server.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include "libpbs.h"
+#include "pbs_error.h"
+#include "dis.h"
+
+/**
+ * @brief
+ *	-encode a Modify Jobs Batch Request
+ *
+ * @par	Data items are:\n
+ *		unsigned int	number of jobs\n
+ *	and for each job:\n
+ *		string		job id\n
+ *		attrl		attributes to set
+ *
+ * @param[in] sock - socket descriptor
+ * @param[in] jobs - list of jobs, the name of each is the job id and its
+ *		     attribs are the attributes to set
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+encode_DIS_ModifyJobs(int sock, struct batch_status *jobs)
+{
+	unsigned int ct = 0;
+	struct batch_status *pbs;
+	int rc;
+
+	for (pbs = jobs; pbs; pbs = pbs->next)
+		++ct;
+
+	if ((rc = diswui(sock, ct)) != 0)
+		return rc;
+
+	for (pbs = jobs; pbs; pbs = pbs->next) {
+		if ((rc = diswst(sock, pbs->name)) != 0)
+			return rc;
+		if ((rc = encode_DIS_attrl(sock, pbs->attribs)) != 0)
+			return rc;
+	}
+
+	return rc;
+}
@@ -100,11 +100,8 @@ PBSD_status(int c, int function, char *id, struct attrl *attrib, char *extend)
  */
 struct batch_status *PBSD_status_get(int c)
 {
-	struct brp_cmdstat  *stp; /* pointer to a returned status record */
-	struct batch_status *bsp  = (struct batch_status *)NULL;
 	struct batch_status *rbsp = (struct batch_status *)NULL;
 	struct batch_reply  *reply;
-	int i;
 
 	/* read reply from stream into presentation element */
 
@@ -116,41 +113,68 @@ struct batch_status *PBSD_status_get(int c)
 		reply->brp_choice != BATCH_REPLY_CHOICE_Status) {
 		pbs_errno = PBSE_PROTOCOL;
 	} else if (connection[c].ch_errno == 0) {
-		/* have zero or more attrl structs to decode here */
-		stp = reply->brp_un.brp_statc;
-		i = 0;
 		pbs_errno = 0;
-		while (stp != (struct brp_cmdstat *)NULL) {
-			if (i++ == 0) {
-				rbsp = bsp = alloc_bs();
-				if (bsp == (struct batch_status *)NULL) {
-					pbs_errno = PBSE_SYSTEM;
-					break;
-				}
-			} else {
-				bsp->next = alloc_bs();
-				bsp = bsp->next;
-				if (bsp == (struct batch_status *)NULL) {
-					pbs_errno = PBSE_SYSTEM;
-					break;
-				}
+		rbsp = PBSD_status_list(reply);
+	}
+	PBSD_FreeReply(reply);
+	return rbsp;
+}
+
+/**
+ * @brief
+ *	Move the status records of a reply into a list of batch_status
+ *	structures
+ *
+ * @param[in,out] reply - the reply, its attribute lists are taken over
+ *
+ * @return returns a pointer to a batch_status structure
+ * @retval pointer to batch status on SUCCESS
+ * @retval NULL if no status record, or on failure with pbs_errno set
+ */
+struct batch_status *PBSD_status_list(struct batch_reply *reply)
+{
+	struct brp_cmdstat  *stp; /* pointer to a returned status record */
+	struct batch_status *bsp  = (struct batch_status *)NULL;
+	struct batch_status *rbsp = (struct batch_status *)NULL;
+	int i;
+	int rc = 0;
+
+	if (reply->brp_choice != BATCH_REPLY_CHOICE_Status)
+		return rbsp;
+
+	/* have zero or more attrl structs to decode here */
+	stp = reply->brp_un.brp_statc;
+	i = 0;
+	while (stp != (struct brp_cmdstat *)NULL) {
+		if (i++ == 0) {
+			rbsp = bsp = alloc_bs();
+			if (bsp == (struct batch_status *)NULL) {
+				rc = PBSE_SYSTEM;
+				break;
 			}
-			if ((bsp->name = strdup(stp->brp_objname)) == NULL) {
-				pbs_errno = PBSE_SYSTEM;
+		} else {
+			bsp->next = alloc_bs();
+			bsp = bsp->next;
+			if (bsp == (struct batch_status *)NULL) {
+				rc = PBSE_SYSTEM;
 				break;
 			}
-			bsp->attribs = stp->brp_attrl;
-			if (stp->brp_attrl)
-				stp->brp_attrl = 0;
-			bsp->next = (struct batch_status *)NULL;
-			stp = stp->brp_stlink;
 		}
-		if (pbs_errno) {
-			pbs_statfree(rbsp);
-			rbsp = (struct batch_status *)NULL;
+		if ((bsp->name = strdup(stp->brp_objname)) == NULL) {
+			rc = PBSE_SYSTEM;
+			break;
 		}
+		bsp->attribs = stp->brp_attrl;
+		if (stp->brp_attrl)
+			stp->brp_attrl = 0;
+		bsp->next = (struct batch_status *)NULL;
+		stp = stp->brp_stlink;
+	}
+	if (rc) {
+		pbs_errno = rc;
+		pbs_statfree(rbsp);
+		rbsp = (struct batch_status *)NULL;
 	}
-	PBSD_FreeReply(reply);
 	return rbsp;
 }
 
@@ -57,6 +57,9 @@
 #include <stdlib.h>
 #include <poll.h>
 #include <sys/resource.h>
+#ifdef PBS_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 #endif
 
 #include "portability.h"
@@ -97,10 +100,36 @@ static fd_set	selset;
 #else
 static int	maxfdx = 0; /* max index in pollfds[] */
 static struct	pollfd	*pollfds; /* for poll() on UNIX variants */
+#ifdef PBS_HAVE_EPOLL
+/*
+ * On Linux the sockets are also registered with epoll so that a wakeup
+ * only visits the ready sockets.  pollfds[] is kept in step all the time
+ * and poll() is used whenever epoll is unavailable: if epoll_create()
+ * or epoll_ctl() fail, or in a child process which inherited epoll_fd.
+ */
+static int	epoll_fd = -1;	/* epoll instance, -1 if not in use */
+static pid_t	epoll_pid;	/* process which created epoll_fd */
+static struct	epoll_event *epoll_evts; /* ready events, data.fd = index */
+static int	epoll_nevts = 0; /* number of events in epoll_evts[] */
+#endif
 #endif
 static void	(*read_func[2])(int);
 static char	logbuf[256];
 
+/*
+ * Client connections (FromClientDIS) in order of cn_lasttime, oldest
+ * first, linked by index into svr_conn[].  Only the oldest need to be
+ * looked at for the idle timeout, see connection_idlecheck().
+ */
+struct idle_link {
+	int	il_prev;	/* older entry or -1 */
+	int	il_next;	/* newer entry or -1 */
+	int	il_linked;	/* entry is on the idle list */
+};
+static struct idle_link *idle_links;
+static int	idle_head = -1;	/* oldest client connection */
+static int	idle_tail = -1;	/* most recently active */
+
 /* Private function within this file */
 
 static void 	 accept_conn();
@@ -109,6 +138,9 @@ static int 	 selpoll_init();
 static void 	 selpoll_fd_set(int condx);
 static void 	 selpoll_fd_clr(int condx);
 static int 	 selpoll_fd_isset(int condx);
+static void	 selpoll_dispatch(int condx);
+static void	 idle_link(int condx);
+static void	 idle_unlink(int condx);
 
 /**
  * @brief
@@ -210,6 +242,11 @@ connection_init(void)
 			log_err(errno, "connection_init", "Insufficient system memory for svr_conn");
 			return (-1);
 		}
+		idle_links = (struct idle_link *)malloc(sizeof(struct idle_link) * max_connection);
+		if (idle_links == (struct idle_link *)0) {
+			log_err(errno, "connection_init", "Insufficient system memory for idle_links");
+			return (-1);
+		}
 	}
 
 	for (i=0; i< max_connection; i++) {
@@ -218,7 +255,12 @@ connection_init(void)
 		svr_conn[i].cn_username[0] = '\0';
 		svr_conn[i].cn_hostname[0] = '\0';
 		svr_conn[i].cn_data = (void *)0;
+		idle_links[i].il_prev = -1;
+		idle_links[i].il_next = -1;
+		idle_links[i].il_linked = 0;
 	}
+	idle_head = -1;
+	idle_tail = -1;
 	return (0);
 
 }
@@ -342,23 +384,29 @@ init_network(unsigned int port, void (*readfunc)(int))
  * @brief
  *	checks for any connection timeout.
  *
+ * @par Functionality:
+ *	Client connections are kept on the idle list in order of their last
+ *	activity, so the walk stops at the first one which has not timed
+ *	out.  Connections marked PBS_NET_CONN_NOTIMEOUT are stepped over.
  */
 void
 connection_idlecheck(void)
 {
 	time_t          now;
 	int             i;
+	int		next;
 
 	/* have any connections timed out ?? */
 
 	now = time((time_t *)0);
-	for (i=0; i<max_connection; i++) {
+	for (i = idle_head; i != -1; i = next) {
 		struct connection *cp = &svr_conn[i];
 		u_long			ipaddr;
 
-		if (cp->cn_active != FromClientDIS)
-			continue;
+		next = idle_links[i].il_next;
 		if ((now - cp->cn_lasttime) <= PBS_NET_MAXCONNECTIDLE)
+			break;
+		if (cp->cn_active != FromClientDIS)
 			continue;
 		if (cp->cn_authen & PBS_NET_CONN_NOTIMEOUT)
 			continue;	/* do not time-out this connection */
@@ -451,6 +499,9 @@ wait_request(time_t waittime)
 #ifndef WIN32
 	extern sigset_t allsigs;
 	int timeout = (int)(waittime * 1000); /* milli seconds */
+#ifdef PBS_HAVE_EPOLL
+	int use_epoll = ((epoll_fd != -1) && (epoll_pid == getpid()));
+#endif
 #else
 	struct timeval timeout;
 
@@ -464,7 +515,12 @@ wait_request(time_t waittime)
 	if (sigprocmask(SIG_UNBLOCK, &allsigs, NULL) == -1)
 		log_err(errno, __func__, "sigprocmask(UNBLOCK)");
 
-	n = poll(pollfds, (maxfdx + 1), timeout);
+#ifdef PBS_HAVE_EPOLL
+	if (use_epoll)
+		n = epoll_wait(epoll_fd, epoll_evts, max_connection, timeout);
+	else
+#endif
+		n = poll(pollfds, (maxfdx + 1), timeout);
 
 	/* block signals again */
 	i = errno;
@@ -495,6 +551,8 @@ wait_request(time_t waittime)
 
 #ifdef WIN32
 			sprintf(logbuf, "%s", "select failed");
+#elif defined(PBS_HAVE_EPOLL)
+			sprintf(logbuf, "%s", use_epoll ? "epoll_wait failed" : "poll failed");
 #else
 			sprintf(logbuf, "%s", "poll failed");
 #endif
@@ -503,6 +561,24 @@ wait_request(time_t waittime)
 			return (-1);
 		}
 	}
+#ifdef PBS_HAVE_EPOLL
+	if (use_epoll) {
+		/*
+		 * Only the ready sockets are visited.  A connection closed
+		 * while dispatching has its remaining events voided by
+		 * selpoll_fd_clr(), so a reused index is never called early.
+		 */
+		epoll_nevts = (n > 0) ? n : 0;
+		for (i = 0; i < epoll_nevts; i++) {
+			int cndx = epoll_evts[i].data.fd;
+
+			if ((cndx >= 0) && (svr_conn[cndx].cn_sock >= 0))
+				selpoll_dispatch(cndx);
+		}
+		epoll_nevts = 0;
+		n = 0;
+	}
+#endif
 #ifdef WIN32
 	for (i = 0; (i <= max_connection) && (n > 0); i++) { /*  for select() in WIN32 */
 #else
@@ -511,42 +587,66 @@ wait_request(time_t waittime)
 		if (selpoll_fd_isset(i)) { /* this socket has data */
 
 			n--; /* decrement the no. of events */
+			selpoll_dispatch(i);
+		}
+	}
+
+#ifndef WIN32
+	connection_idlecheck();
+#endif
 
-			svr_conn[i].cn_lasttime = time((time_t *)0);
-			if (svr_conn[i].cn_active != Idle) {
+	return (0);
+}
 
-				if (svr_conn[i].cn_active != Primary &&
-					svr_conn[i].cn_active != RppComm &&
-					svr_conn[i].cn_active != Secondary) {
+/**
+ * @brief
+ *	Call the processing routine of a connection which has data ready,
+ *	authenticating it first if needed.
+ *
+ * @par Linkage scope:
+ *	static (local)
+ *
+ * @param[in]	cndx: index into svr_conn[] table.
+ *
+ * @return	void
+ */
+static void
+selpoll_dispatch(int cndx)
+{
+	svr_conn[cndx].cn_lasttime = time((time_t *)0);
+	if (svr_conn[cndx].cn_active != Idle) {
+
+		if (idle_links[cndx].il_linked) {
+			/* most recently active, move to the end of the idle list */
+			idle_unlink(cndx);
+			idle_link(cndx);
+		}
 
-					if (!(svr_conn[i].cn_authen & PBS_NET_CONN_AUTHENTICATED)) {
+		if (svr_conn[cndx].cn_active != Primary &&
+			svr_conn[cndx].cn_active != RppComm &&
+			svr_conn[cndx].cn_active != Secondary) {
 
-						if (engage_authentication(&svr_conn[i]) == -1) {
-							(void)close_conn(svr_conn[i].cn_sock);
-							continue;
-						}
-					}
+			if (!(svr_conn[cndx].cn_authen & PBS_NET_CONN_AUTHENTICATED)) {
+
+				if (engage_authentication(&svr_conn[cndx]) == -1) {
+					(void)close_conn(svr_conn[cndx].cn_sock);
+					return;
 				}
-				svr_conn[i].cn_func(svr_conn[i].cn_sock);
+			}
+		}
+		svr_conn[cndx].cn_func(svr_conn[cndx].cn_sock);
 
-			} else {
-				/* Force this idle connection closed. */
+	} else {
+		/* Force this idle connection closed. */
+		selpoll_fd_clr(cndx);
 #ifdef WIN32
-				(void)closesocket(svr_conn[i].cn_sock);
+		(void)closesocket(svr_conn[cndx].cn_sock);
 #else
-				(void)close(svr_conn[i].cn_sock);
+		(void)close(svr_conn[cndx].cn_sock);
 #endif
-				/* Force the svr_conn entry to be reset. */
-				cleanup_conn(i);
-			}
-		}
+		/* Force the svr_conn entry to be reset. */
+		cleanup_conn(cndx);
 	}
-
-#ifndef WIN32
-	connection_idlecheck();
-#endif
-
-	return (0);
 }
 
 /*
@@ -673,6 +773,9 @@ add_conn(int sock, enum conn_type type,pbs_net_t addr, unsigned int port, void (
 	if (port < IPPORT_RESERVED)
 		svr_conn[conn_idx].cn_authen |= PBS_NET_CONN_FROM_PRIVIL;
 
+	if (type == FromClientDIS)
+		idle_link(conn_idx);
+
 	selpoll_fd_set(conn_idx);
 	return (conn_idx);
 }
@@ -723,6 +826,9 @@ close_conn(int sd)
 	if (svr_conn[conn_idx].cn_active == Idle)
 		return;
 
+	/* stop polling before close(), epoll only forgets open descriptors */
+	selpoll_fd_clr(conn_idx);
+
 	if (svr_conn[conn_idx].cn_active != ChildPipe) {
 		if (CS_close_socket(sd) != CS_SUCCESS) {
 
@@ -769,6 +875,7 @@ void
 cleanup_conn(int cndx)
 {
 	selpoll_fd_clr(cndx);
+	idle_unlink(cndx);
 
 	svr_conn[cndx].cn_sock = -1;
 	svr_conn[cndx].cn_addr = 0;
@@ -817,6 +924,14 @@ net_close(int but)
 		free(pollfds);
 		pollfds = NULL;
 	}
+#ifdef PBS_HAVE_EPOLL
+	if ((but == -1) && (epoll_fd != -1)) {
+		(void)close(epoll_fd);
+		epoll_fd = -1;
+		free(epoll_evts);
+		epoll_evts = NULL;
+	}
+#endif
 #endif
 	if (but == -1)
 		net_is_initialized = 0;	/* closed everything */
@@ -946,6 +1061,26 @@ selpoll_init(void)
 		pollfds[idx].events = POLLIN;
 		pollfds[idx].revents = 0;
 	}
+
+#ifdef PBS_HAVE_EPOLL
+	/** Use epoll if it can be had, else stay with poll() */
+	epoll_evts = (struct epoll_event *)malloc(sizeof(struct epoll_event) * max_connection);
+	if (epoll_evts != NULL) {
+#ifdef EPOLL_CLOEXEC
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+#else
+		epoll_fd = epoll_create(max_connection);
+		if (epoll_fd != -1)
+			(void)fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+#endif
+	}
+	if (epoll_fd == -1) {
+		log_err(errno, "selpoll_init", "epoll not available, using poll");
+		free(epoll_evts);
+		epoll_evts = NULL;
+	} else
+		epoll_pid = getpid();
+#endif
 #endif
 	return 0;
 }
@@ -985,6 +1120,23 @@ selpoll_fd_set(int cndx)
 	pollfds[cndx].revents = 0;
 	if (cndx > maxfdx)
 		maxfdx = cndx;
+#ifdef PBS_HAVE_EPOLL
+	if ((epoll_fd != -1) && (epoll_pid == getpid())) {
+		struct epoll_event ev;
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = cndx;
+		if ((epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &ev) == -1) &&
+			((errno != EEXIST) ||
+			(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock, &ev) == -1))) {
+			/* pollfds[] is complete, fall back to poll() */
+			log_err(errno, "selpoll_fd_set", "epoll_ctl failed, using poll");
+			(void)close(epoll_fd);
+			epoll_fd = -1;
+		}
+	}
+#endif
 #endif
 }
 
@@ -1018,6 +1170,21 @@ selpoll_fd_clr(int cndx)
 	int sock = svr_conn[cndx].cn_sock;
 	FD_CLR(sock, &readset);
 #else
+#ifdef PBS_HAVE_EPOLL
+	if ((epoll_fd != -1) && (epoll_pid == getpid()) &&
+		(pollfds[cndx].fd != -1)) {
+		struct epoll_event ev;	/* needed by kernels before 2.6.9 */
+		int i;
+
+		(void)epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pollfds[cndx].fd, &ev);
+
+		/* void any event still to be dispatched for this index */
+		for (i = 0; i < epoll_nevts; i++) {
+			if (epoll_evts[i].data.fd == cndx)
+				epoll_evts[i].data.fd = -1;
+		}
+	}
+#endif
 	pollfds[cndx].fd = -1;
 	pollfds[cndx].revents = 0;
 	/**
@@ -1088,3 +1255,63 @@ selpoll_fd_isset(int cndx)
 #endif
 }
 
+
+/**
+ * @brief
+ *	Add a client connection to the end of the idle list, as the most
+ *	recently active.
+ *
+ * @par Linkage scope:
+ *	static (local)
+ *
+ * @param[in]	cndx: index into svr_conn[] table.
+ *
+ * @return	void
+ */
+static void
+idle_link(int cndx)
+{
+	if (idle_links[cndx].il_linked)
+		return;
+
+	idle_links[cndx].il_prev = idle_tail;
+	idle_links[cndx].il_next = -1;
+	if (idle_tail != -1)
+		idle_links[idle_tail].il_next = cndx;
+	else
+		idle_head = cndx;
+	idle_tail = cndx;
+	idle_links[cndx].il_linked = 1;
+}
+
+/**
+ * @brief
+ *	Remove a connection from the idle list.
+ *
+ * @par Linkage scope:
+ *	static (local)
+ *
+ * @param[in]	cndx: index into svr_conn[] table.
+ *
+ * @return	void
+ */
+static void
+idle_unlink(int cndx)
+{
+	struct idle_link *pl = &idle_links[cndx];
+
+	if (!pl->il_linked)
+		return;
+
+	if (pl->il_prev != -1)
+		idle_links[pl->il_prev].il_next = pl->il_next;
+	else
+		idle_head = pl->il_next;
+	if (pl->il_next != -1)
+		idle_links[pl->il_next].il_prev = pl->il_prev;
+	else
+		idle_tail = pl->il_prev;
+	pl->il_prev = -1;
+	pl->il_next = -1;
+	pl->il_linked = 0;
+}
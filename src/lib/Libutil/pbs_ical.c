@@ -69,6 +69,33 @@
 
 #define DATE_LIMIT (3*(60*60*24*365)) /* Limit to 3 years from now */
 
+#ifdef LIBICAL
+/**
+ * @brief
+ * 	The occurrences of the last recurrence rule expanded by get_occurrence().
+ *
+ * @par	Callers walk the occurrences of a standing reservation one index at a
+ * 	time.  Rather than restarting the libical iterator from dtstart for
+ * 	every index, the iterator is kept and the occurrences it returned are
+ * 	recorded, so walking all occurrences of a rule is linear rather than
+ * 	quadratic in the number of occurrences.
+ */
+static struct occr_cache {
+	char *rrule;			/* recurrence rule expanded */
+	time_t dtstart;			/* start time of the recurrence */
+	char *tz;			/* timezone of the recurrence */
+	icaltimezone *localzone;	/* the zone for tz */
+	struct icalrecur_iterator_impl *itr;	/* iterator positioned after occrs[num-1] */
+	time_t *occrs;			/* occurrences expanded so far */
+	int num;			/* number of occurrences in occrs */
+	int size;			/* allocated size of occrs */
+	int done;			/* the iterator reached the end of the rule */
+} occr_cache;
+
+static void clear_occr_cache(void);
+static int init_occr_cache(char *rrule, time_t dtstart, char *tz);
+#endif
+
 /**
  * @brief
  * 	Returns the number of occurrences defined by a recurrence rule.
@@ -153,9 +180,8 @@ get_num_occurrences(char *rrule, time_t dtstart, char *tz)
  * 	index, and start time. This function assumes that the
  * 	time dtsart passed in is the one to start the occurrence from.
  *
- * @par	NOTE: This function should be made reentrant such that
- * 	it can be looped over without having to loop over every occurrence
- * 	over and over again.
+ * @par	The occurrences of the last rule asked for are cached, so looping
+ * 	over the indices of a rule only walks the rule once.
  *
  * @param[in] rrule - The recurrence rule as defined by the user
  * @param[in] dtstart - The start time from which to start
@@ -173,13 +199,9 @@ get_occurrence(char *rrule, time_t dtstart, char *tz, int idx)
 
 
 #ifdef LIBICAL
-	struct icalrecurrencetype rt;
-	struct icaltimetype start;
-	icaltimezone *localzone;
 	struct icaltimetype next;
-	struct icalrecur_iterator_impl *itr;
-	int i;
-	time_t next_occr = dtstart;
+	time_t *tmp;
+	int size;
 
 	if (rrule == NULL)
 		return dtstart;
@@ -187,42 +209,117 @@ get_occurrence(char *rrule, time_t dtstart, char *tz, int idx)
 	if (tz == NULL)
 		return -1;
 
+	if (occr_cache.itr == NULL || occr_cache.dtstart != dtstart ||
+		strcmp(occr_cache.rrule, rrule) != 0 ||
+		strcmp(occr_cache.tz, tz) != 0) {
+		if (init_occr_cache(rrule, dtstart, tz) != 0)
+			return -1;
+	}
+
+	if (idx <= 0)
+		return dtstart;
+
+	/* Expand the rule up to idx, continuing from where we last stopped */
+	while (occr_cache.num < idx && !occr_cache.done) {
+		if (occr_cache.num == occr_cache.size) {
+			size = occr_cache.size ? occr_cache.size * 2 : 64;
+			tmp = realloc(occr_cache.occrs, size * sizeof(time_t));
+			if (tmp == NULL) {
+				clear_occr_cache();
+				return -1;
+			}
+			occr_cache.occrs = tmp;
+			occr_cache.size = size;
+		}
+		next = icalrecur_iterator_next(occr_cache.itr);
+		if (icaltime_is_null_time(next)) {
+			occr_cache.done = 1;
+			break;
+		}
+		icaltimezone_convert_time(&next, occr_cache.localzone,
+			icaltimezone_get_utc_timezone());
+		occr_cache.occrs[occr_cache.num++] = icaltime_as_timet(next);
+	}
+
+	/* If reached end of possible date-time return -1 */
+	if (idx > occr_cache.num)
+		return -1;
+
+	return occr_cache.occrs[idx - 1];
+
+#else
+
+	return dtstart;
+#endif
+}
+
+#ifdef LIBICAL
+/**
+ * @brief
+ * 	Free the cached occurrences of the last expanded recurrence rule.
+ */
+static void
+clear_occr_cache(void)
+{
+	if (occr_cache.itr != NULL)
+		icalrecur_iterator_free(occr_cache.itr);
+	free(occr_cache.rrule);
+	free(occr_cache.tz);
+	free(occr_cache.occrs);
+	memset(&occr_cache, 0, sizeof(occr_cache));
+}
+
+/**
+ * @brief
+ * 	Start caching the occurrences of a new recurrence rule.
+ *
+ * @param[in] rrule - The recurrence rule as defined by the user
+ * @param[in] dtstart - The start time of the recurrence
+ * @param[in] tz - The timezone associated to the recurrence rule
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	unknown timezone or out of memory
+ */
+static int
+init_occr_cache(char *rrule, time_t dtstart, char *tz)
+{
+	struct icalrecurrencetype rt;
+	struct icaltimetype start;
+
+	clear_occr_cache();
+
 	icalerror_clear_errno();
 
 	icalerror_set_error_state(ICAL_PARSE_ERROR, ICAL_ERROR_NONFATAL);
 	icalerror_errors_are_fatal = 0;
-	localzone = icaltimezone_get_builtin_timezone(tz);
+	occr_cache.localzone = icaltimezone_get_builtin_timezone(tz);
 
-	if (localzone == NULL)
+	if (occr_cache.localzone == NULL)
 		return -1;
 
+	if ((occr_cache.rrule = strdup(rrule)) == NULL ||
+		(occr_cache.tz = strdup(tz)) == NULL) {
+		clear_occr_cache();
+		return -1;
+	}
+	occr_cache.dtstart = dtstart;
+
 	rt = icalrecurrencetype_from_string(rrule);
 
 	start = icaltime_from_timet(dtstart, 0);
-	icaltimezone_convert_time(&start, icaltimezone_get_utc_timezone(), localzone);
-	next = start;
+	icaltimezone_convert_time(&start, icaltimezone_get_utc_timezone(),
+		occr_cache.localzone);
 
-	itr = (struct icalrecur_iterator_impl*) icalrecur_iterator_new(rt, start);
-	/* Skip as many occurrences as specified by idx */
-	for (i = 0; i < idx && !icaltime_is_null_time(next); i++)
-		next = icalrecur_iterator_next(itr);
-
-	if (!icaltime_is_null_time(next)) {
-		icaltimezone_convert_time(&next, localzone,
-			icaltimezone_get_utc_timezone());
-		next_occr = icaltime_as_timet(next);
+	occr_cache.itr = (struct icalrecur_iterator_impl*) icalrecur_iterator_new(rt, start);
+	if (occr_cache.itr == NULL) {
+		clear_occr_cache();
+		return -1;
 	}
-	else next_occr = -1; /* If reached end of possible date-time return -1 */
 
-		icalrecur_iterator_free(itr);
-
-	return next_occr;
-
-#else
-
-	return dtstart;
-#endif
+	return 0;
 }
+#endif
 
 /**
  * @brief
@@ -566,6 +663,8 @@ set_ical_zoneinfo(char *path)
 #ifdef LIBICAL
 	static int called = 0;
 	if (path != NULL) {
+		/* the cached occurrences refer to the old zones */
+		clear_occr_cache();
 		if(called)
 			free_zone_directory();
 		
@@ -60,13 +60,77 @@ extern pbs_list_head task_list_event; /* list of tasks responding to an event */
 extern int svr_delay_entry;
 extern time_t	time_now;
 
+/* Private Data Items: */
+
+static pbs_list_head timed_wheel[WORK_WHEEL_SIZE]; /* timed tasks by second */
+static pbs_list_head event_index[WORK_EVENT_HASH]; /* event tasks by event id */
+static time_t	wheel_now;	/* second of the slot being dispatched */
+static time_t	wheel_far;	/* earliest task on task_list_timed, 0 if none */
+static int	task_index_ready = 0;
+
+static void init_task_index(void);
+static void timed_cascade(void);
+static struct work_task *find_timed_by_parm1(void *parm1);
+
+#define WHEEL_SLOT(t)	(&timed_wheel[(unsigned long)(t) % WORK_WHEEL_SIZE])
+#define EVENT_SLOT(e)	(&event_index[(unsigned long)(e) % WORK_EVENT_HASH])
+
+/**
+ * @brief
+ *	Set up the timer wheel and the event index on first use.
+ */
+static void
+init_task_index(void)
+{
+	int i;
+
+	for (i = 0; i < WORK_WHEEL_SIZE; i++)
+		CLEAR_HEAD(timed_wheel[i]);
+	for (i = 0; i < WORK_EVENT_HASH; i++)
+		CLEAR_HEAD(event_index[i]);
+	wheel_now = (time_now != 0) ? time_now : time((time_t *)0);
+	wheel_far = 0;
+	task_index_ready = 1;
+}
+
+/**
+ * @brief
+ *	Move the tasks on task_list_timed which are now within range of the
+ *	timer wheel onto it.
+ *
+ * @par
+ *	Called whenever the wheel catches up with wheel_far, so each task
+ *	is moved once and the list is walked at most once per revolution.
+ */
+static void
+timed_cascade(void)
+{
+	struct work_task *ptask;
+	struct work_task *nxt;
+	time_t		  when;
+
+	wheel_far = 0;
+	ptask = (struct work_task *)GET_NEXT(task_list_timed);
+	while (ptask) {
+		nxt = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+		if (ptask->wt_event < wheel_now + WORK_WHEEL_SIZE) {
+			when = (ptask->wt_event < wheel_now) ? wheel_now : ptask->wt_event;
+			delete_link(&ptask->wt_linkall);
+			append_link(WHEEL_SLOT(when), &ptask->wt_linkall, ptask);
+		} else if ((wheel_far == 0) || (ptask->wt_event < wheel_far))
+			wheel_far = ptask->wt_event;
+		ptask = nxt;
+	}
+}
+
 /**
  *
  * @brief
  * 	Creates a task of type 'type', 'event_id', and when task is dispatched,
  *	execute func with argument 'parm'. The task is added to
- *	'task_list_immed' if 'type' is  WORK_Immed; otherwise, task is added
- *	'task_list_event'.
+ *	'task_list_immed' if 'type' is  WORK_Immed; to the timer wheel slot
+ *	of its second (or 'task_list_timed' if too far ahead) if WORK_Timed;
+ *	otherwise, task is added to 'task_list_event' and the event index.
  *
  * @param[in]	type - of task
  * @param[in]	event_id - event id of the task
@@ -81,12 +145,16 @@ extern time_t	time_now;
 struct work_task *set_task(enum work_type type, long event_id, void (*func)(struct work_task *) , void *parm)
 {
 	struct work_task *pnew;
-	struct work_task *pold;
+	time_t		  when;
+
+	if (!task_index_ready)
+		init_task_index();
 
 	pnew = (struct work_task *)malloc(sizeof(struct work_task));
 	if (pnew == (struct work_task *)0)
 		return ((struct work_task *)0);
 	CLEAR_LINK(pnew->wt_linkall);
+	CLEAR_LINK(pnew->wt_linkevent);
 	CLEAR_LINK(pnew->wt_linkobj);
 	CLEAR_LINK(pnew->wt_linkobj2);
 	pnew->wt_event = event_id;
@@ -102,19 +170,19 @@ struct work_task *set_task(enum work_type type, long event_id, void (*func)(stru
 	if (type == WORK_Immed)
 		append_link(&task_list_immed, &pnew->wt_linkall, pnew);
 	else if (type == WORK_Timed) {
-		pold = (struct work_task *)GET_NEXT(task_list_timed);
-		while (pold) {
-			if (pold->wt_event > pnew->wt_event)
-				break;
-			pold = (struct work_task *)GET_NEXT(pold->wt_linkall);
-		}
-		if (pold)
-			insert_link(&pold->wt_linkall, &pnew->wt_linkall, pnew,
-				LINK_INSET_BEFORE);
-		else
+		/* a time already past is due in the slot being dispatched */
+		if (event_id < wheel_now + WORK_WHEEL_SIZE) {
+			when = (event_id < wheel_now) ? wheel_now : event_id;
+			append_link(WHEEL_SLOT(when), &pnew->wt_linkall, pnew);
+		} else {
 			append_link(&task_list_timed, &pnew->wt_linkall, pnew);
-	} else
+			if ((wheel_far == 0) || (event_id < wheel_far))
+				wheel_far = event_id;
+		}
+	} else {
 		append_link(&task_list_event, &pnew->wt_linkall, pnew);
+		append_link(EVENT_SLOT(event_id), &pnew->wt_linkevent, pnew);
+	}
 	return (pnew);
 }
 
@@ -135,6 +203,7 @@ void
 dispatch_task(struct work_task *ptask)
 {
 	delete_link(&ptask->wt_linkall);
+	delete_link(&ptask->wt_linkevent);
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
 	if (ptask->wt_func)
@@ -156,9 +225,85 @@ delete_task(struct work_task *ptask)
 	delete_link(&ptask->wt_linkobj);
 	delete_link(&ptask->wt_linkobj2);
 	delete_link(&ptask->wt_linkall);
+	delete_link(&ptask->wt_linkevent);
 	(void)free(ptask);
 }
 
+/**
+ *
+ * @brief
+ *	Find a timed task, on the timer wheel or on task_list_timed, that
+ *	has a wt_parm1 field of value 'parm1'.
+ *
+ * @param[in]	parm1	- parameter being matched.
+ *
+ * @return struct work_task *
+ * @retval the task	- if 'parm1' was matched
+ * @retval NULL		- otherwise
+ */
+static struct work_task *
+find_timed_by_parm1(void *parm1)
+{
+	struct work_task  *ptask;
+	int		   i;
+
+	if ((parm1 == NULL) || !task_index_ready)
+		return NULL;
+
+	for (i = 0; i < WORK_WHEEL_SIZE; i++) {
+		ptask = (struct work_task *)GET_NEXT(timed_wheel[i]);
+		while (ptask) {
+			if (ptask->wt_parm1 == parm1)
+				return ptask;
+			ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+		}
+	}
+
+	ptask = (struct work_task *)GET_NEXT(task_list_timed);
+	while (ptask) {
+		if (ptask->wt_parm1 == parm1)
+			return ptask;
+		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+	}
+	return NULL;
+}
+
+/**
+ *
+ * @brief
+ *	Find the event task of type 'type' for event 'event_id' using the
+ *	event index instead of walking task_list_event.
+ *
+ * @param[in]	type	- type of task, e.g. WORK_Deferred_Reply
+ * @param[in]	event_id - event id of the task: handle, pid, ...
+ * @param[in]	parm1	- if not NULL, wt_parm1 must also match
+ *
+ * @return struct work_task *
+ * @retval the first such task set	- if found
+ * @retval NULL				- otherwise
+ *
+ * @note
+ *	A task taken off task_list_event by the caller must also be taken
+ *	off its wt_linkevent list, else it is still found here.
+ */
+struct work_task *
+find_work_task(enum work_type type, long event_id, void *parm1)
+{
+	struct work_task  *ptask;
+
+	if (!task_index_ready)
+		return NULL;
+
+	ptask = (struct work_task *)GET_NEXT(*EVENT_SLOT(event_id));
+	while (ptask) {
+		if ((ptask->wt_type == type) && (ptask->wt_event == event_id) &&
+			((parm1 == NULL) || (ptask->wt_parm1 == parm1)))
+			return ptask;
+		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkevent);
+	}
+	return NULL;
+}
+
 /**
  *
  * @brief
@@ -185,13 +330,9 @@ delete_task_by_parm1(void *parm1)
 		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
 	}
 
-	ptask = (struct work_task *)GET_NEXT(task_list_timed);
-	while (ptask) {
-		if ((ptask->wt_parm1 != NULL) && (ptask->wt_parm1 == parm1)) {
-			delete_task(ptask);
-			return;
-		}
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+	if ((ptask = find_timed_by_parm1(parm1)) != NULL) {
+		delete_task(ptask);
+		return;
 	}
 
 	ptask = (struct work_task *)GET_NEXT(task_list_immed);
@@ -231,13 +372,8 @@ has_task_by_parm1(void *parm1)
 		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
 	}
 
-	ptask = (struct work_task *)GET_NEXT(task_list_timed);
-	while (ptask) {
-		if ((ptask->wt_parm1 != NULL) && (ptask->wt_parm1 == parm1)) {
-			return 1;
-		}
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
+	if (find_timed_by_parm1(parm1) != NULL)
+		return 1;
 
 	ptask = (struct work_task *)GET_NEXT(task_list_immed);
 	while (ptask) {
@@ -256,7 +392,8 @@ has_task_by_parm1(void *parm1)
  *	1. If svr_delay_entry is set, then a delayed task in the
  *	   task_list_event is ready so find and process it.
  *	2. All items on the immediate list, then
- *	3. All items on the timed task list which have expired times
+ *	3. All items on the timer wheel in the slots of the seconds up to
+ *	   now; the wheel only moves forward.
  *
  * @return time_t
  * @retval The amount of time till next task
@@ -266,9 +403,9 @@ time_t
 default_next_task(void)
 {
 
-	time_t		   delay;
 	struct work_task  *nxt;
 	struct work_task  *ptask;
+	int		   i;
 
 	/*
 	 * tilwhen is the basic "idle" time if there is nothing pending sooner
@@ -282,6 +419,9 @@ default_next_task(void)
 
 	time_now = time((time_t *)0);
 
+	if (!task_index_ready)
+		init_task_index();
+
 	if (svr_delay_entry) {
 		ptask = (struct work_task *)GET_NEXT(task_list_event);
 		while (ptask) {
@@ -296,16 +436,29 @@ default_next_task(void)
 	while ((ptask=(struct work_task *)GET_NEXT(task_list_immed)) != NULL)
 		dispatch_task(ptask);
 
-	while ((ptask=(struct work_task *)GET_NEXT(task_list_timed))!=NULL) {
-		if ((delay = ptask->wt_event - time_now) > 0) {
-			if (tilwhen > delay)
-				tilwhen = delay;
-			break;
-		} else {
-			dispatch_task(ptask);	/* will delete link */
+	if (time_now - wheel_now >= WORK_WHEEL_SIZE) {
+		/* clock jumped ahead, everything on the wheel is due */
+		wheel_now = time_now;
+		for (i = 0; i < WORK_WHEEL_SIZE; i++) {
+			while ((ptask=(struct work_task *)GET_NEXT(timed_wheel[i])) != NULL)
+				dispatch_task(ptask);	/* will delete link */
 		}
+		timed_cascade();
+	}
 
+	while (wheel_now <= time_now) {
+		while ((ptask=(struct work_task *)GET_NEXT(*WHEEL_SLOT(wheel_now))) != NULL)
+			dispatch_task(ptask);	/* will delete link */
+		if (wheel_now == time_now)
+			break;
+		wheel_now++;
+		if ((wheel_far != 0) && (wheel_far < wheel_now + WORK_WHEEL_SIZE))
+			timed_cascade();
 	}
 
+	/* anything due in the next second shortens the basic cycle */
+	if ((tilwhen > 1) && (GET_NEXT(*WHEEL_SLOT(time_now + 1)) != NULL))
+		tilwhen = 1;
+
 	return (tilwhen);
 }
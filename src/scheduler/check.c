@@ -67,6 +67,8 @@
  *	unset_str_res()
  *	zero_res()
  *	find_correct_nodes()
+ *	begin_cant_run_cache()
+ *	free_cant_run_cache()
  *
  */
 #include <pbs_config.h>
@@ -79,6 +81,7 @@
 #include <pbs_internal.h>
 #include <log.h>
 #include <libutil.h>
+#include <pbs_entlim.h>
 #include "check.h"
 #include "config.h"
 #include "server_info.h"
@@ -102,6 +105,12 @@
 #include "simulate.h"
 #include "resource.h"
 
+static int check_limits_cached(server_info *sinfo, queue_info *qinfo,
+	resource_resv *resresv, schd_error *err, unsigned int flags);
+static nspec **check_nodes_cached(status *policy, resource_resv *resresv,
+	node_info **ninfo_arr, node_partition **nodepart, unsigned int flags,
+	schd_error *err);
+
 
 /**
  *
@@ -821,7 +830,7 @@ is_ok_to_run(status *policy, int pbs_sd, server_info *sinfo,
 		if (resresv->job == NULL || resresv->job->priority != NAS_HWY101)
 #endif /* localmod 032 */
 		if (resresv->is_job) {
-			if ((rc = check_limits(sinfo, qinfo, resresv, err, flags | CHECK_LIMIT))) {
+			if ((rc = check_limits_cached(sinfo, qinfo, resresv, err, flags | CHECK_LIMIT))) {
 
 				add_err(&prev_err, err);
 				if (rc == SCHD_ERROR)
@@ -1050,7 +1059,7 @@ is_ok_to_run(status *policy, int pbs_sd, server_info *sinfo,
 		}
 	}
 
-	ns_arr = check_nodes(policy, resresv, ninfo_arr, nodepart, flags, err);
+	ns_arr = check_nodes_cached(policy, resresv, ninfo_arr, nodepart, flags, err);
 	
 	if (err->error_code != SUCCESS)
 		add_err(&prev_err, err);
@@ -1119,6 +1128,7 @@ check_avail_resources(resource *reslist, resource_req *reqlist,
 	resource *fres = false_res();
 	resource *zres = zero_res();
 	resource *ustr = unset_str_res();
+	resource tmpres;
 	char resbuf1[MAX_LOG_SIZE];
 	char resbuf2[MAX_LOG_SIZE];
 	char resbuf3[MAX_LOG_SIZE];
@@ -1162,14 +1172,18 @@ check_avail_resources(resource *reslist, resource_req *reqlist,
 				 * reslist, then this means the boolean is false
 				 */
 				if (resreq->type.is_boolean)
-					res = fres;
+					tmpres = *fres;
 				else if (resreq->type.is_num && (flags & UNSET_RES_ZERO))
-					res = zres;
+					tmpres = *zres;
 				else if (resreq->type.is_string && (flags & UNSET_RES_ZERO))
-					res = ustr;
+					tmpres = *ustr;
 				else /* ignore check: effect is resource is infinite */
 					continue;
 
+				/* use a local copy so the shared resources are never written
+				 * and this function can be called from the node eval threads
+				 */
+				res = &tmpres;
 				res->name = resreq->name;
 				res->def = resreq->def;
 			}
@@ -1775,9 +1789,6 @@ false_res()
 			return NULL;
 	}
 
-        res->def = NULL;
-	res->name = NULL;
-
 	return res;
 }
 
@@ -1817,9 +1828,6 @@ unset_str_res()
 			return NULL;
 	}
 
-	res->name = NULL;
-	res->def = NULL;
-
 	return res;
 }
 /**
@@ -1847,9 +1855,6 @@ zero_res()
 			return NULL;
 	}
 
-	res->name = NULL;
-	res->def = NULL;
-
 	return res;
 }
 
@@ -1965,3 +1970,467 @@ find_correct_nodes(status *policy, server_info *sinfo, queue_info *qinfo, resour
 
 	return 1;
 }
+
+/**
+ *	The cannot-run cache remembers why a job could not run between cycles
+ *	for the checks which are the most expensive to repeat.  A job fails
+ *	them again until one of their inputs changes:
+ *	  - check_limits(): the limits on the server and queues, the job's
+ *	    request and the counts of the job's user, group and project.
+ *	  - check_nodes() finding the job can never run: the job's request and
+ *	    the configuration of the vnodes, server and queues.
+ *	Each failure is kept with a signature of its inputs and is only reused
+ *	while the signature is the same.
+ *
+ *	Entries are keyed by job name.  As entries are used, they are moved
+ *	from the previous generation (cant_run_cache_prev) into the current one
+ *	(cant_run_cache).  Entries still in the previous generation when the
+ *	next cycle begins belong to jobs which were not considered and are freed.
+ */
+struct cant_run_entry {
+	unsigned long long lim_sig;	/* signature of the check_limits() inputs */
+	int lim_rc;			/* what check_limits() returned */
+	schd_error *lim_err;		/* why check_limits() failed */
+	unsigned long long node_sig;	/* signature of the check_nodes() inputs */
+	schd_error *node_err;		/* why the job can never run */
+};
+
+static void *cant_run_cache = NULL;		/* current generation */
+static void *cant_run_cache_prev = NULL;	/* previous generation */
+static unsigned long long cant_run_lim_sig;	/* limits of this cycle */
+static unsigned long long cant_run_node_sig;	/* complex of this cycle */
+
+/**
+ * @brief
+ *		free a cannot-run cache entry
+ *
+ * @param[in]	entry	-	entry to free
+ *
+ * @return	void
+ */
+static void
+free_cant_run_entry(void *entry)
+{
+	struct cant_run_entry *ent = entry;
+
+	if (ent == NULL)
+		return;
+
+	free_schd_error(ent->lim_err);
+	free_schd_error(ent->node_err);
+	free(ent);
+}
+
+/**
+ * @brief
+ *		entlim free function used when an entry is moved between generations
+ *
+ * @param[in]	entry	-	entry being moved
+ *
+ * @return	void
+ */
+static void
+keep_cant_run_entry(void *entry)
+{
+	return;
+}
+
+/**
+ * @brief
+ *		find a job's entry in the cannot-run cache
+ *
+ * @param[in]	name	-	name of the job
+ * @param[in]	create	-	create the entry if the job has none
+ *
+ * @return	struct cant_run_entry *
+ * @retval	the job's entry
+ * @retval	NULL	: the job has no entry or on error
+ */
+static struct cant_run_entry *
+find_cant_run_entry(char *name, int create)
+{
+	struct cant_run_entry *ent;
+
+	if (cant_run_cache == NULL || name == NULL)
+		return NULL;
+
+	if ((ent = entlim_get(name, cant_run_cache)) != NULL)
+		return ent;
+
+	if (cant_run_cache_prev != NULL &&
+		(ent = entlim_get(name, cant_run_cache_prev)) != NULL)
+		entlim_delete(name, cant_run_cache_prev, keep_cant_run_entry);
+	else if (create) {
+		if ((ent = calloc(1, sizeof(struct cant_run_entry))) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return NULL;
+		}
+	}
+	else
+		return NULL;
+
+	if (entlim_add(name, ent, cant_run_cache) != 0) {
+		free_cant_run_entry(ent);
+		return NULL;
+	}
+
+	return ent;
+}
+
+/**
+ * @brief
+ *		copy a cached reason why a job could not run into err
+ *
+ * @param[out]	err	-	error to copy into
+ * @param[in]	cerr	-	cached error
+ *
+ * @return	int
+ * @retval	1	: copied
+ * @retval	0	: on error
+ */
+static int
+copy_cant_run_error(schd_error *err, schd_error *cerr)
+{
+	schd_error *nerr;
+
+	if ((nerr = dup_schd_error(cerr)) == NULL)
+		return 0;
+
+	move_schd_error(err, nerr);
+	free_schd_error(nerr);
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		fold a resource list's resources_available into a signature
+ *
+ * @param[in]	sig	-	signature so far
+ * @param[in]	res	-	resource list
+ *
+ * @return	unsigned long long
+ * @retval	new signature
+ */
+static unsigned long long
+hash_resources_avail(unsigned long long sig, resource *res)
+{
+	int i;
+
+	for (; res != NULL; res = res->next) {
+		sig = hash_str(sig, res->name);
+		sig = hash_bytes(sig, &res->avail, sizeof(res->avail));
+		sig = hash_str(sig, res->indirect_vnode_name);
+		if (res->str_avail != NULL)
+			for (i = 0; res->str_avail[i] != NULL; i++)
+				sig = hash_str(sig, res->str_avail[i]);
+	}
+
+	return sig;
+}
+
+/**
+ * @brief
+ *		fold a resource_req list into a signature
+ *
+ * @param[in]	sig	-	signature so far
+ * @param[in]	req	-	resource_req list
+ *
+ * @return	unsigned long long
+ * @retval	new signature
+ */
+static unsigned long long
+hash_resreq(unsigned long long sig, resource_req *req)
+{
+	for (; req != NULL; req = req->next) {
+		sig = hash_str(sig, req->name);
+		sig = hash_bytes(sig, &req->amount, sizeof(req->amount));
+		sig = hash_str(sig, req->res_str);
+	}
+
+	return sig;
+}
+
+/**
+ * @brief
+ *		fold the running and resource counts of an entity into a signature
+ *
+ * @param[in]	sig	-	signature so far
+ * @param[in]	cts	-	counts of the entity (may be NULL)
+ *
+ * @return	unsigned long long
+ * @retval	new signature
+ */
+static unsigned long long
+hash_counts(unsigned long long sig, counts *cts)
+{
+	if (cts == NULL)
+		return hash_str(sig, NULL);
+
+	sig = hash_bytes(sig, &cts->running, sizeof(cts->running));
+	return hash_resreq(sig, cts->rescts);
+}
+
+/**
+ * @brief
+ *		fold a string array into a signature
+ *
+ * @param[in]	sig	-	signature so far
+ * @param[in]	strs	-	string array (may be NULL)
+ *
+ * @return	unsigned long long
+ * @retval	new signature
+ */
+static unsigned long long
+hash_str_array(unsigned long long sig, char **strs)
+{
+	int i;
+
+	if (strs == NULL)
+		return hash_str(sig, NULL);
+
+	for (i = 0; strs[i] != NULL; i++)
+		sig = hash_str(sig, strs[i]);
+
+	return hash_bytes(sig, &i, sizeof(i));
+}
+
+/**
+ * @brief
+ *		check_limits() which reuses the reason a job failed its limits in
+ *		an earlier cycle if the job's request, the limits and the counts of
+ *		the job's entities have not changed since.  The cache is not used
+ *		when there are run events in the calendar during the job's run
+ *		since those are counted against the limits as well.
+ *
+ * @param[in]	sinfo	-	server info
+ * @param[in]	qinfo	-	queue info
+ * @param[in]	resresv	-	the job
+ * @param[out]	err	-	why the job exceeds a limit
+ * @param[in]	flags	-	check_limits() flags
+ *
+ * @return	int
+ * @retval	see check_limits()
+ */
+static int
+check_limits_cached(server_info *sinfo, queue_info *qinfo, resource_resv *resresv,
+	schd_error *err, unsigned int flags)
+{
+	struct cant_run_entry *ent;
+	unsigned long long sig;
+	int rc;
+
+	if (cant_run_cache == NULL || qinfo == NULL || !resresv->is_job ||
+		(flags & RETURN_ALL_ERR))
+		return check_limits(sinfo, qinfo, resresv, err, flags);
+
+	if (sinfo->calendar != NULL && exists_run_event(sinfo->calendar,
+		sinfo->server_time + calc_time_left(resresv)))
+		return check_limits(sinfo, qinfo, resresv, err, flags);
+
+	sig = hash_str(cant_run_lim_sig, qinfo->name);
+	sig = hash_str(sig, resresv->user);
+	sig = hash_str(sig, resresv->group);
+	sig = hash_str(sig, resresv->project);
+	sig = hash_resreq(sig, resresv->resreq);
+	sig = hash_counts(sig, find_counts(sinfo->user_counts, resresv->user));
+	sig = hash_counts(sig, find_counts(sinfo->group_counts, resresv->group));
+	sig = hash_counts(sig, find_counts(sinfo->project_counts, resresv->project));
+	sig = hash_counts(sig, sinfo->alljobcounts);
+	sig = hash_counts(sig, find_counts(qinfo->user_counts, resresv->user));
+	sig = hash_counts(sig, find_counts(qinfo->group_counts, resresv->group));
+	sig = hash_counts(sig, find_counts(qinfo->project_counts, resresv->project));
+	sig = hash_counts(sig, qinfo->alljobcounts);
+
+	ent = find_cant_run_entry(resresv->name, 0);
+	if (ent != NULL && ent->lim_err != NULL && ent->lim_sig == sig &&
+		copy_cant_run_error(err, ent->lim_err))
+		return ent->lim_rc;
+
+	rc = check_limits(sinfo, qinfo, resresv, err, flags);
+
+	if (rc != 0 && rc != SCHD_ERROR) {
+		if (ent == NULL)
+			ent = find_cant_run_entry(resresv->name, 1);
+		if (ent != NULL) {
+			free_schd_error(ent->lim_err);
+			ent->lim_err = dup_schd_error(err);
+			ent->lim_sig = sig;
+			ent->lim_rc = rc;
+		}
+	}
+
+	return rc;
+}
+
+/**
+ * @brief
+ *		check_nodes() which reuses the reason a job can never run found in
+ *		an earlier cycle if the job's request and the configuration of the
+ *		complex have not changed since.  Jobs in reservations or which are
+ *		being resumed are always checked since their nodes are their own.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	resresv	-	the job
+ * @param[in]	ninfo_arr	-	nodes to check
+ * @param[in]	nodepart	-	node partitions to check
+ * @param[in]	flags	-	check_nodes() flags
+ * @param[out]	err	-	why the job can't run
+ *
+ * @return	nspec **
+ * @retval	see check_nodes()
+ */
+static nspec **
+check_nodes_cached(status *policy, resource_resv *resresv, node_info **ninfo_arr,
+	node_partition **nodepart, unsigned int flags, schd_error *err)
+{
+	struct cant_run_entry *ent;
+	unsigned long long sig;
+	nspec **ns_arr;
+	selspec *spec;
+	place *pl;
+	int i;
+
+	if (cant_run_cache == NULL || !resresv->is_job || resresv->job == NULL ||
+		resresv->job->resv != NULL || resresv->job->execselect != NULL ||
+		resresv->job->queue == NULL || resresv->select == NULL ||
+		resresv->place_spec == NULL || (flags & RETURN_ALL_ERR))
+		return check_nodes(policy, resresv, ninfo_arr, nodepart, flags, err);
+
+	spec = resresv->select;
+	pl = resresv->place_spec;
+
+	sig = hash_bytes(cant_run_node_sig, &flags, sizeof(flags));
+	sig = hash_str(sig, resresv->job->queue->name);
+	for (i = 0; spec->chunks[i] != NULL; i++) {
+		sig = hash_str(sig, spec->chunks[i]->str_chunk);
+		sig = hash_bytes(sig, &spec->chunks[i]->num_chunks,
+			sizeof(spec->chunks[i]->num_chunks));
+	}
+	i = pl->free | pl->pack << 1 | pl->scatter << 2 | pl->vscatter << 3 |
+		pl->excl << 4 | pl->exclhost << 5 | pl->share << 6;
+	sig = hash_bytes(sig, &i, sizeof(i));
+	sig = hash_str(sig, pl->group);
+	sig = hash_resreq(sig, resresv->resreq);
+	sig = hash_str(sig, resresv->aoename);
+	sig = hash_str_array(sig, resresv->node_set_str);
+
+	ent = find_cant_run_entry(resresv->name, 0);
+	if (ent != NULL && ent->node_err != NULL && ent->node_sig == sig &&
+		copy_cant_run_error(err, ent->node_err)) {
+		schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+			"Job can never run with the unchanged complex, skipping node search");
+		return NULL;
+	}
+
+	ns_arr = check_nodes(policy, resresv, ninfo_arr, nodepart, flags, err);
+
+	if (ns_arr == NULL && err->status_code == NEVER_RUN) {
+		if (ent == NULL)
+			ent = find_cant_run_entry(resresv->name, 1);
+		if (ent != NULL) {
+			free_schd_error(ent->node_err);
+			ent->node_err = dup_schd_error(err);
+			ent->node_sig = sig;
+		}
+	}
+
+	return ns_arr;
+}
+
+/**
+ * @brief
+ *		begin a new cycle of the cannot-run cache.  The signatures of the
+ *		limits and of the complex are computed for the cycle and entries
+ *		not used in the last cycle are freed.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	sinfo	-	server info of the cycle
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+begin_cant_run_cache(status *policy, server_info *sinfo)
+{
+	unsigned long long sig;
+	node_info *ninfo;
+	queue_info *qinfo;
+	int flags;
+	int i;
+
+	if (policy == NULL || sinfo == NULL)
+		return;
+
+	if (!conf.cant_run_cache) {
+		free_cant_run_cache();
+		return;
+	}
+
+	if (cant_run_cache_prev != NULL)
+		entlim_free_ctx(cant_run_cache_prev, free_cant_run_entry);
+	cant_run_cache_prev = cant_run_cache;
+	if ((cant_run_cache = entlim_initialize_ctx()) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return;
+	}
+
+	/* limits */
+	sig = lim_signature(sinfo->liminfo, HASH_INIT);
+	for (i = 0; sinfo->queues != NULL && sinfo->queues[i] != NULL; i++) {
+		sig = hash_str(sig, sinfo->queues[i]->name);
+		sig = lim_signature(sinfo->queues[i]->liminfo, sig);
+	}
+	cant_run_lim_sig = sig;
+
+	/* the complex */
+	flags = sinfo->node_group_enable | sinfo->dont_span_psets << 1 |
+		sinfo->provision_enable << 2 | sinfo->has_multi_vnode << 3;
+	sig = hash_bytes(HASH_INIT, &flags, sizeof(flags));
+	sig = hash_str_array(sig, sinfo->node_group_key);
+	sig = hash_resources_avail(sig, sinfo->res);
+	for (i = 0; sinfo->queues != NULL && sinfo->queues[i] != NULL; i++) {
+		qinfo = sinfo->queues[i];
+		sig = hash_str(sig, qinfo->name);
+		sig = hash_bytes(sig, &qinfo->num_nodes, sizeof(qinfo->num_nodes));
+		sig = hash_str_array(sig, qinfo->node_group_key);
+		sig = hash_resources_avail(sig, qinfo->qres);
+	}
+	for (i = 0; sinfo->nodes != NULL && sinfo->nodes[i] != NULL; i++) {
+		ninfo = sinfo->nodes[i];
+		flags = ninfo->is_down | ninfo->is_offline << 1 |
+			ninfo->is_unknown << 2 | ninfo->is_stale << 3 |
+			ninfo->lic_lock << 4 | ninfo->no_multinode_jobs << 5 |
+			ninfo->provision_enable << 6 | ninfo->is_multivnoded << 7;
+		sig = hash_str(sig, ninfo->name);
+		sig = hash_str(sig, ninfo->mom);
+		sig = hash_str(sig, ninfo->queue_name);
+		sig = hash_bytes(sig, &flags, sizeof(flags));
+		sig = hash_bytes(sig, &ninfo->sharing, sizeof(ninfo->sharing));
+		sig = hash_resources_avail(sig, ninfo->res);
+	}
+	cant_run_node_sig = sig;
+}
+
+/**
+ * @brief
+ *		free the cannot-run cache.  Every job will be checked in full the
+ *		next cycle.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+free_cant_run_cache(void)
+{
+	if (cant_run_cache != NULL) {
+		entlim_free_ctx(cant_run_cache, free_cant_run_entry);
+		cant_run_cache = NULL;
+	}
+	if (cant_run_cache_prev != NULL) {
+		entlim_free_ctx(cant_run_cache_prev, free_cant_run_entry);
+		cant_run_cache_prev = NULL;
+	}
+}
@@ -239,6 +239,16 @@ resource *unset_str_res(void);
  */
 int find_correct_nodes(status *policy, server_info *sinfo, queue_info *qinfo, resource_resv *resresv, node_info ***ninfo_arr, node_partition ***nodepart);
 
+/*
+ *	begin_cant_run_cache - start a cycle of the cannot-run cache
+ */
+void begin_cant_run_cache(status *policy, server_info *sinfo);
+
+/*
+ *	free_cant_run_cache - free the cannot-run cache
+ */
+void free_cant_run_cache(void);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -51,6 +51,9 @@
 /* name of config file */
 #define CONFIG_FILE "sched_config"
 #define USAGE_FILE "usage"
+#define PROFILE_FILE "sched_profile"
+#define TRACE_FILE "sched_trace"
+#define SNAPSHOT_FILE "sched_snapshot"
 #define HOLIDAYS_FILE "holidays"
 #define RESGROUP_FILE "resource_group"
 #define DEDTIME_FILE "dedicated_time"
@@ -60,6 +63,10 @@
 #define USAGE_VERSION 2
 #define USAGE_NAME_MAX 50
 
+/* cycle snapshot file header */
+#define SNAPSHOT_MAGIC "PBS_SCHED_SNAPSHOT"
+#define SNAPSHOT_VERSION 1
+
 /* preempt priority values */
 #define PREEMPT_PRIORITY_HIGH 100000
 #define PREEMPT_PRIORITY_STEP 1000
@@ -90,6 +97,31 @@
  */
 #define SHRINK_MAX_RETRY 5
 
+/* default time between full job queries when incremental_job_query is set */
+#define JOB_QUERY_RESYNC_TIME 600
+
+/* parallel vnode evaluation: nodes handed to a thread at a time, the
+ * minimum number of vnodes before threads are used, and the most threads
+ */
+#define NODE_EVAL_CHUNK 64
+#define NODE_EVAL_MIN_NODES 512
+#define NODE_EVAL_MAX_THREADS 64
+
+/* resource lists at least this long get a lookup table (see find_resource) */
+#define RES_SLOTS_MIN_LEN 8
+
+/* cycle profiler: the number of cycles the rolling percentiles cover and
+ * the minimum time between updates of the sched_cycle_profile attribute
+ */
+#define PROF_HISTORY 100
+#define PROF_ATTR_UPDATE_TIME 300
+
+/* decision trace: the number of job decisions kept and the size of the
+ * buffers holding the strings of each decision's error
+ */
+#define TRACE_RING_SIZE 4096
+#define TRACE_ARG_SIZE 64
+
 /* Size of time buffer */
 #define TIMEBUF_SIZE 128
 /* parsing -
@@ -164,6 +196,12 @@
 #define PARSE_RESV_CONFIRM_IGNORE "resv_confirm_ignore"
 #define PARSE_ALLOW_AOE_CALENDAR "allow_aoe_calendar"
 #define PARSE_OPT_BACKFILL_FUZZY_TIME "opt_backfill_fuzzy_time"
+#define PARSE_INCREMENTAL_JOB_QUERY "incremental_job_query"
+#define PARSE_JOB_QUERY_RESYNC_TIME "job_query_resync_time"
+#define PARSE_NODE_EVAL_THREADS "node_eval_threads"
+#define PARSE_CYCLE_PROFILE "cycle_profile"
+#define PARSE_CANT_RUN_CACHE "cant_run_cache"
+#define PARSE_DECISION_TRACE "decision_trace"
 
 /* deprecated */
 #define PARSE_SORT_BY "sort_by"
@@ -189,6 +227,8 @@
 #define NUM_PEERS 50
 #define MAX_BUF_SIZE 2048
 #define MAX_DEF_REPLY 5
+#define MAX_JOB_UPDATES 1000
+#define MAX_QUEUED_RUNS 1000
 #define MAX_PTIME_SIZE 64
 
 /* resource names for sorting special cases */
@@ -89,6 +89,14 @@ enum select_job_status
 	ERR_IN_SELECT = -2	/* error while selecting a job to preempt */
 };
 
+/* whether a vnode can hold a chunk of the job preempting (preempt_victims) */
+enum preempt_node_fit
+{
+	PV_NODE_UNKNOWN,	/* not checked yet */
+	PV_NODE_FIT,		/* can hold at least one chunk */
+	PV_NODE_NOFIT		/* can't hold any chunk */
+};
+
 #define INIT_ARR_SIZE 2048
 
 /* Unspecified resource value */
@@ -98,6 +106,16 @@ enum select_job_status
 #define SCHD_INFINITY -2
 #define SCHD_INFINITY_STR "SCHD_INFINITY"
 
+/* initial value of a signature built with hash_bytes() and hash_str() */
+#define HASH_INIT 14695981039346656037ULL
+
+/* rank_off for new_obj_index() when the objects have no rank */
+#define OBJ_INDEX_NO_RANK ((size_t) -1)
+
+/* the name and rank of an object in an obj_index */
+#define OBJ_INDEX_NAME(idx, obj) (*(char **) ((char *) (obj) + (idx)->name_off))
+#define OBJ_INDEX_RANK(idx, obj) (*(int *) ((char *) (obj) + (idx)->rank_off))
+
 /* infinity walltime value for forever job. This is 5 years(=60 * 60 * 24 * 365 * 5 seconds) */
 #define JOB_INFINITY (60 * 60 * 24 * 365 * 5)
 
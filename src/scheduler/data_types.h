@@ -91,6 +91,12 @@ struct status;
 struct fairshare_head;
 struct sim_info;
 struct node_scratch;
+struct node_res_col;
+struct node_res_index;
+struct res_slots;
+struct resresv_set;
+struct obj_index;
+struct preempt_victims;
 
 typedef struct state_count state_count;
 typedef struct server_info server_info;
@@ -120,6 +126,12 @@ typedef struct status status;
 typedef struct fairshare_head fairshare_head;
 typedef struct sim_info sim_info;
 typedef struct node_scratch node_scratch;
+typedef struct node_res_col node_res_col;
+typedef struct node_res_index node_res_index;
+typedef struct res_slots res_slots;
+typedef struct resresv_set resresv_set;
+typedef struct obj_index obj_index;
+typedef struct preempt_victims preempt_victims;
 #ifdef NAS
 /* localmod 034 */
 /*
@@ -188,6 +200,7 @@ struct place
 	unsigned int share:1;		/* will share nodes */
 
 	char *group;			/* resource to node group by */
+	int refcount;			/* number of owners - see share_place() */
 };
 
 struct chunk
@@ -196,6 +209,8 @@ struct chunk
 	int num_chunks;		/* the number of chunks needed */
 	int seq_num;			/* the chunk sequence number */
 	resource_req *req;		/* the resources in resource_req form */
+	unsigned long *node_filter;	/* vnodes which may satisfy this chunk */
+	int node_filter_seq;		/* seq of the node_res_index node_filter is from */
 };
 
 struct selspec
@@ -204,6 +219,7 @@ struct selspec
 	int total_cpus;		/* # of cpus requested in this select spec */
 	resdef **defs;                /* the resources requested by this select spec*/
 	chunk **chunks;
+	int refcount;			/* number of owners - see share_selspec() */
 };
 
 struct sim_info
@@ -336,6 +352,16 @@ struct server_info
 	node_partition **hostsets;	/* partitions for vnodes on a host */
 
 	char **nodesigs;		/* node signatures from server nodes */
+	node_res_index *node_index;	/* per-resource columns of node resources */
+
+	/* name and rank indexes of the arrays above used by find_resource_resv(),
+	 * find_node_info(), find_queue_info() and their by rank versions
+	 */
+	obj_index *jobs_idx;
+	obj_index *all_resresv_idx;
+	obj_index *resvs_idx;
+	obj_index *nodes_idx;
+	obj_index *queues_idx;
 
 	/* cache of node partitions we created.  We cache them all here and
 	 * will attempt to find one when we need to use it.  This cache will not
@@ -474,6 +500,7 @@ struct job_info
 	time_t eligible_time;		/* eligible time accrued until last cycle */
 	
 	struct attrl *attr_updates;	/* used to federate all attr updates to server*/
+	int updates_queued;		/* send_job_updates() queue generation holding its updates */
 	float formula_value;		/* evaluated job sort formula value */
 
 #ifdef NAS
@@ -500,6 +527,34 @@ struct node_scratch
 	unsigned int ineligible:1; /* node is ineligible for the job */
 };
 
+/* one resource's values across all the server's vnodes.  The bitsets and
+ * avail array are indexed by node_info.node_ind
+ */
+struct node_res_col
+{
+	resdef *def;
+	unsigned int indexed:1;	/* bool, string or consumable resource */
+	unsigned long *unset;		/* vnodes without the resource */
+	unsigned long *unknown;	/* vnodes the index can't answer for */
+	sch_resource_t *avail;	/* consumable: total amount available */
+	unsigned long *bool_true;	/* boolean: True or settable either way */
+	unsigned long *bool_false;	/* boolean: False or settable either way */
+	char **vals;			/* string: the distinct values */
+	unsigned long **val_bits;	/* string: vnodes which have each value */
+	int num_vals;
+};
+
+/* columnar index of the resources of the server's vnodes built once a cycle */
+struct node_res_index
+{
+	int refcount;			/* number of server_info sharing the index */
+	int seq;			/* unique id to tell indexes apart */
+	int num_nodes;
+	int num_words;			/* number of words in a bitset */
+	int num_cols;
+	node_res_col *cols;
+};
+
 struct node_info
 {
 	unsigned is_down:1;		/* node is down */
@@ -579,6 +634,7 @@ struct node_info
 	resource *res;		/* list of resources max/current usage */
 
 	int rank;			/* unique numeric identifier for node */
+	int node_ind;			/* index into the server's node_res_index */
 
 #ifdef NAS
 	/* localmod 034 */
@@ -661,12 +717,23 @@ struct resource_resv
 	char *aoename;		/* store name of aoe if requested */
 	char **node_set_str;		/* user specified node string */
 	node_info **node_set;		/* node array specified by node_set_str */
+	int ec_index;			/* index of the res resv's equivalence class */
 #ifdef NAS /* localmod 034 */
 	enum site_j_share_type share_type; /* How resv counts against group share */
 #endif /* localmod 034 */
 };
 
 
+/* queued jobs which are alike in everything checked to see if they can run */
+struct resresv_set
+{
+	unsigned can_not_run:1;	/* a member of the set can not run this cycle */
+	unsigned long long key;	/* hash of what the set's members have in common */
+	resource_resv *resresv;	/* first member of the set, others match it */
+	int num_members;		/* number of res resvs in the set */
+	schd_error *err;		/* why the set can not run */
+};
+
 struct resource_type
 {
 	/* non consumable - used for selection only (e.g. arch) */
@@ -701,9 +768,19 @@ struct resource
 
 	resdef *def;                  /* resource definition */
 
+	res_slots *slots;		/* lookup table if this is the head of a long list */
+
 	struct resource *next;	/* next resource in list */
 };
 
+/* table to find a resource in a list by its resdef index - see find_resource() */
+struct res_slots
+{
+	int nslots;			/* number of slots (size of allres) */
+	resource *tail;		/* last resource in the list added to the table */
+	resource *slot[1];		/* resources indexed by resdef index */
+};
+
 struct resource_req
 {
 	char *name;			/* name of the resource - reference to the definition name */
@@ -720,6 +797,7 @@ struct resdef
 	char *name;			/* name of resource */
 	struct resource_type type;	/* resource type */
 	unsigned int flags;		/* resource flags (see pbs_ifl.h) */
+	int index;			/* index into allres or -1 */
 };
 
 struct prev_job_info
@@ -751,6 +829,7 @@ struct fairshare_head
 {
 	group_info *root;			/* root of fairshare tree */
 	time_t last_decay;			/* last time tree was decayed */
+	void *name_idx;			/* group_infos of the tree by name */
 };
 
 /* a path from the root to a group_info in the tree */
@@ -776,6 +855,7 @@ struct group_info
 	 */
 	usage_t usage;			/* calculated usage info */
 	usage_t temp_usage;			/* usage plus any temporary usage */
+	double usage_factor;			/* temp_usage / percentage (0 if no percentage) */
 
 	struct group_path *gpath;		/* path from the root of the tree */
 
@@ -807,6 +887,29 @@ struct np_cache
 	node_partition **nodepart;	/* node partitions */
 };
 
+/* hash index of an array of objects by name and rank (see new_obj_index()) */
+struct obj_index
+{
+	size_t name_off;		/* offset of the name in the objects */
+	size_t rank_off;		/* offset of the rank or OBJ_INDEX_NO_RANK */
+	int count;			/* number of objects of the array indexed */
+	int size;			/* number of slots in each table, a power of 2 */
+	void **name_slots;		/* the objects by name */
+	void **rank_slots;		/* the objects by rank */
+};
+
+/* running jobs searched for preemption victims of one high priority job
+ * (see new_preempt_victims())
+ */
+struct preempt_victims
+{
+	int sorted;			/* victims are and stay in preempt priority order */
+	int num_nodes;			/* number of vnodes in the node_res_index */
+	char *node_fit;			/* per node_ind: enum preempt_node_fit */
+	char *hjob_nodes;		/* per node_ind: the high prio job is on it */
+	resdef **rdtc_non_consumable;	/* checked on multi-vnoded hosts */
+};
+
 /* header to usage file.  Needs to be EXACTLY the same size as a
  * group_node_usage for backwards compatibility
  * tag defined in config.h
@@ -978,6 +1081,10 @@ struct config
 	unsigned node_sort_unused:1;	/* node sorting by unused/assigned is used */
 	unsigned resv_conf_ignore:1;  /* if we want to ignore dedicated time when confirming reservations.  Move to enum if ever expanded */
 	unsigned allow_aoe_calendar:1;        /* allow jobs requesting aoe in calendar*/
+	unsigned incremental_job_query:1;	/* only query jobs which changed */
+	unsigned cycle_profile:1;	/* profile the phases of the cycle */
+	unsigned cant_run_cache:1;	/* reuse why jobs couldn't run last cycle */
+	unsigned decision_trace:1;	/* keep a trace of the decisions on jobs */
 	unsigned logstderr:1;               /* log to stderr as well as log file */
 #ifdef NAS /* localmod 034 */
 	unsigned prime_sto	:1;	/* shares_track_only--no enforce shares */
@@ -1007,6 +1114,8 @@ struct config
 	int max_preempt_attempts;		/* max num of preempt attempts per cyc*/
 	int max_jobs_to_check;		/* max number of jobs to check in cyc*/
 	long dflt_opt_backfill_fuzzy;	/* default time for the fuzzy backfill optimization */
+	time_t job_query_resync_time;	/* time between full job queries */
+	int node_eval_threads;		/* threads used to evaluate vnodes */
 	char ded_prefix[PBS_MAXQUEUENAME +1];	/* prefix to dedicated queues */
 	char pt_prefix[PBS_MAXQUEUENAME +1];	/* prefix to primetime queues */
 	char npt_prefix[PBS_MAXQUEUENAME +1];	/* prefix to non primetime queues */
@@ -1056,7 +1165,10 @@ struct event_list
 	unsigned int eol:1;		/* we've reached the end of time */
 	timed_event *events;		/* the calendar of events */
 	timed_event *next_event;	/* the next event to be performed */
+	timed_event *last_event;	/* the last event in the calendar */
 	time_t *current_time;		/* [reference] current time in the calendar */
+	void *time_idx;			/* index of the first event at each event_time */
+	void *name_idx;			/* index of event chains by event name */
 };
 
 struct timed_event
@@ -1070,6 +1182,7 @@ struct timed_event
 	void *event_func_arg;		/* optional argument to function - not freed */
 	timed_event *next;
 	timed_event *prev;
+	timed_event *name_next;		/* next event in the calendar with the same name */
 };
 
 #ifdef	__cplusplus
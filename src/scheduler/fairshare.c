@@ -44,6 +44,8 @@
  * Functions included are:
  * 	add_child()
  * 	add_unknown()
+ * 	index_fairshare_tree()
+ * 	keep_group_info()
  * 	find_group_info()
  * 	find_alloc_ginfo()
  * 	new_group_info()
@@ -52,7 +54,9 @@
  * 	count_shares()
  * 	calc_fair_share_perc()
  * 	test_perc()
+ * 	set_usage_factor()
  * 	update_usage_on_run()
+ * 	undo_usage_on_run()
  * 	calculate_usage_value()
  * 	decay_fairshare_tree()
  * 	extract_fairshare()
@@ -84,6 +88,7 @@
 #include <errno.h>
 
 #include <log.h>
+#include <pbs_entlim.h>
 
 #include "data_types.h"
 #include "job_info.h"
@@ -131,44 +136,92 @@ add_child(group_info *ginfo, group_info *parent)
  * 		add a ginfo to the "unknown" group
  *
  * @param[in]	ginfo	-	ginfo to add
- * @param[in]	root	-	root of fairshare tree
+ * @param[in]	fhead	-	fairshare tree
  *
  * @return	nothing
  *
  */
 void
-add_unknown(group_info *ginfo, group_info *root)
+add_unknown(group_info *ginfo, fairshare_head *fhead)
 {
 	group_info *unknown;		/* ptr to the "unknown" group */
 
-	unknown = find_group_info("unknown", root);
+	unknown = find_group_info("unknown", fhead);
 	add_child(ginfo, unknown);
 	calc_fair_share_perc(unknown->child, UNSPECIFIED);
 }
 
 /**
  * @brief
- *		find_group_info - recursive function to find a group_info in the
- *			  resgroup tree
+ *		index_fairshare_tree - recursively add the group_infos of a subtree
+ *			       to a name index
  *
- * @param[in]	name	-	name of the ginfo to find
  * @param[in]	root	-	the root of the current sub-tree
+ * @param[in]	idx	-	the index to add to
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ *
+ */
+int
+index_fairshare_tree(group_info *root, void *idx)
+{
+	for (; root != NULL; root = root->sibling) {
+		if (entlim_add(root->name, root, idx) != 0)
+			return 0;
+		if (!index_fairshare_tree(root->child, idx))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		entlim free function for the name index.  The group_infos are
+ *		owned by the tree, not the index.
+ *
+ * @param[in]	ginfo	-	group_info being removed from the index
+ *
+ * @return	void
+ */
+void
+keep_group_info(void *ginfo)
+{
+}
+
+/**
+ * @brief
+ *		find_group_info - find a group_info in the resgroup tree by name.
+ *			  The name index of the tree is built on first use.
+ *
+ * @param[in]	name	-	name of the ginfo to find
+ * @param[in]	fhead	-	fairshare tree
  *
  * @return	the found group_info or NULL
  *
  */
 group_info *
-find_group_info(char *name, group_info *root)
+find_group_info(char *name, fairshare_head *fhead)
 {
-	group_info *ginfo;		/* the found group */
-	if (root == NULL || !strcmp(name, root->name))
-		return root;
+	if (name == NULL || fhead == NULL || fhead->root == NULL)
+		return NULL;
 
-	ginfo = find_group_info(name, root->sibling);
-	if (ginfo == NULL)
-		ginfo = find_group_info(name, root->child);
+	if (fhead->name_idx == NULL) {
+		if ((fhead->name_idx = entlim_initialize_ctx()) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return NULL;
+		}
+		if (!index_fairshare_tree(fhead->root, fhead->name_idx)) {
+			log_err(errno, __func__, "Unable to index fairshare tree");
+			entlim_free_ctx(fhead->name_idx, keep_group_info);
+			fhead->name_idx = NULL;
+			return NULL;
+		}
+	}
 
-	return ginfo;
+	return entlim_get(name, fhead->name_idx);
 }
 
 /**
@@ -178,17 +231,17 @@ find_group_info(char *name, group_info *root)
  *			  add it to the "unknown" group
  *
  * @param[in]	name	-	name of the ginfo to find
- * @param[in]	root	-	root of the fairshare tree
+ * @param[in]	fhead	-	fairshare tree
  *
  * @return	the found ginfo or the newly allocated ginfo
  *
  */
 group_info *
-find_alloc_ginfo(char *name, group_info *root)
+find_alloc_ginfo(char *name, fairshare_head *fhead)
 {
 	group_info *ginfo;		/* the found group or allocated group */
 
-	ginfo = find_group_info(name, root);
+	ginfo = find_group_info(name, fhead);
 
 	if (ginfo == NULL) {
 		if ((ginfo = new_group_info()) == NULL)
@@ -196,7 +249,9 @@ find_alloc_ginfo(char *name, group_info *root)
 
 		ginfo->name = string_dup(name);
 		ginfo->shares = 1;
-		add_unknown(ginfo, root);
+		add_unknown(ginfo, fhead);
+		if (fhead->name_idx != NULL)
+			entlim_add(ginfo->name, ginfo, fhead->name_idx);
 	}
 	return ginfo;
 }
@@ -225,6 +280,7 @@ new_group_info()
 	new->percentage = 0.0;
 	new->usage = 1;
 	new->temp_usage = 1;
+	new->usage_factor = 0;
 	new->gpath = NULL;
 	new->parent = NULL;
 	new->sibling = NULL;
@@ -238,7 +294,7 @@ new_group_info()
  * 		parse the resource group file
  *
  * @param[in]	fname	-	name of the file
- * @param[in]	root	-	root of fairshare tree
+ * @param[in]	fhead	-	fairshare tree
  *
  * @return	success/failure
  *
@@ -251,7 +307,7 @@ new_group_info()
  *
  */
 int
-parse_group(char *fname, group_info *root)
+parse_group(char *fname, fairshare_head *fhead)
 {
 	group_info *ginfo;		/* ptr to parent group */
 	group_info *new_ginfo;	/* used to add each new group */
@@ -288,7 +344,7 @@ parse_group(char *fname, group_info *root)
 				grouptok == NULL || sharestok == NULL) {
 				error = 1;
 			}
-			else if (find_group_info(nametok, root) != NULL) {
+			else if (find_group_info(nametok, fhead) != NULL) {
 				error = 1;
 				sprintf(log_buffer, "entity %s is not unique", nametok);
 				fprintf(stderr, "%s\n", log_buffer);
@@ -297,9 +353,9 @@ parse_group(char *fname, group_info *root)
 			}
 			else {
 				if (!strcmp(grouptok, "root"))
-					ginfo = find_group_info(FAIRSHARE_ROOT_NAME, root);
+					ginfo = find_group_info(FAIRSHARE_ROOT_NAME, fhead);
 				else
-					ginfo = find_group_info(grouptok, root);
+					ginfo = find_group_info(grouptok, fhead);
 
 				if (ginfo != NULL) {
 					shares = strtol(sharestok, &endp, 10);
@@ -313,6 +369,8 @@ parse_group(char *fname, group_info *root)
 							new_ginfo->cresgroup = cgroup;
 							new_ginfo->shares = shares;
 							add_child(new_ginfo, ginfo);
+							if (fhead->name_idx != NULL)
+								entlim_add(new_ginfo->name, new_ginfo, fhead->name_idx);
 						}
 						else
 							error = 1;
@@ -450,6 +508,7 @@ calc_fair_share_perc(group_info *root, int shares)
 	else
 		root->percentage = (float) root->shares / (float) cur_shares *
 			root->parent->percentage;
+	set_usage_factor(root);
 
 	calc_fair_share_perc(root->sibling, cur_shares);
 	calc_fair_share_perc(root->child, UNSPECIFIED);
@@ -475,6 +534,26 @@ test_perc(group_info *root)
 	return (root->child == NULL ? root->percentage :0) + test_perc(root->sibling) + test_perc(root->child);
 }
 
+/**
+ * @brief
+ *		set_usage_factor - recalculate the cached usage / percentage ratio
+ *			   of a group_info compare_path() sorts by.  Must be
+ *			   called whenever temp_usage or percentage changes.
+ *
+ * @param[in,out]	ginfo	-	group_info to update
+ *
+ * @return nothing
+ *
+ */
+void
+set_usage_factor(group_info *ginfo)
+{
+	if (ginfo->percentage > 0)
+		ginfo->usage_factor = ginfo->temp_usage / ginfo->percentage;
+	else
+		ginfo->usage_factor = 0;
+}
+
 
 /**
  * @brief
@@ -505,6 +584,7 @@ update_usage_on_run(resource_resv *resresv)
 		gpath = resresv->job->ginfo->gpath;
 		while (gpath != NULL) {
 			gpath->ginfo->temp_usage += u;
+			set_usage_factor(gpath->ginfo);
 			gpath = gpath->next;
 		}
 	}
@@ -513,6 +593,36 @@ update_usage_on_run(resource_resv *resresv)
 			"Job doesn't have a group_info ptr set, usage not updated.\n");
 }
 
+/**
+ * @brief
+ * 		Take back the usage update_usage_on_run() accrued for a job which
+ *	       turned out not to run, from the entity and all groups on the
+ *	       path from the entity to the root of the fairshare tree.
+ *
+ * @param[in]	resresv	-	the job whose usage is taken back
+ *
+ * @return nothing
+ *
+ */
+void
+undo_usage_on_run(resource_resv *resresv)
+{
+	usage_t u;
+	struct group_path *gpath;
+
+	if (resresv == NULL)
+		return;
+
+	if (!resresv->is_job || resresv->job == NULL || resresv->job->ginfo == NULL)
+		return;
+
+	u = formula_evaluate(conf.fairshare_res, resresv, resresv->resreq);
+	for (gpath = resresv->job->ginfo->gpath; gpath != NULL; gpath = gpath->next) {
+		gpath->ginfo->temp_usage -= u;
+		set_usage_factor(gpath->ginfo);
+	}
+}
+
 /**
  * @brief
  *		calculate_usage_value - calcualte a value that represents the usage
@@ -684,8 +794,8 @@ compare_path(struct group_path *gp1, struct group_path *gp2)
 			if (cur1->ginfo->percentage <= 0 && cur2->ginfo->percentage<= 0)
 				return 0;
 
-			curval1 = cur1->ginfo->temp_usage / cur1->ginfo->percentage;
-			curval2 = cur2->ginfo->temp_usage / cur2->ginfo->percentage;
+			curval1 = cur1->ginfo->usage_factor;
+			curval2 = cur2->ginfo->usage_factor;
 
 			if (curval1 < curval2)
 				rc = -1;
@@ -862,7 +972,7 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
 						error = 1;
 				}
 				if (!error)
-					read_usage_v2(fp, flags, fhead->root);
+					read_usage_v2(fp, flags, fhead);
 			}
 			else
 				error = 1;
@@ -874,7 +984,7 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
 		}
 		else	 { /* original headerless usage file */
 			rewind(fp);
-			read_usage_v1(fp, fhead->root);
+			read_usage_v1(fp, fhead);
 		}
 	}
 
@@ -887,7 +997,7 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
  * 		read version 1 usage file
  *
  * @param[in]	fp	-	the file pointer to the open file
- * @param[in]	root	-	root of the fairshare tree
+ * @param[in]	fhead	-	fairshare tree
  *
  * @return	int
  *	@retval	1	: success
@@ -895,7 +1005,7 @@ read_usage(char *filename, int flags, fairshare_head *fhead)
  *
  */
 int
-read_usage_v1(FILE *fp, group_info *root)
+read_usage_v1(FILE *fp, fairshare_head *fhead)
 {
 	struct group_node_usage_v1 grp;
 	group_info *ginfo;
@@ -906,7 +1016,7 @@ read_usage_v1(FILE *fp, group_info *root)
 
 	while (fread(&grp, sizeof(struct group_node_usage_v1), 1, fp)) {
 		if (grp.usage >= 0 && is_valid_pbs_name(grp.name, USAGE_NAME_MAX)) {
-			ginfo = find_alloc_ginfo(grp.name, root);
+			ginfo = find_alloc_ginfo(grp.name, fhead);
 			if (ginfo != NULL) {
 				ginfo->usage = grp.usage;
 				ginfo->temp_usage = grp.usage;
@@ -916,9 +1026,11 @@ read_usage_v1(FILE *fp, group_info *root)
 					while (gpath->next != NULL) {
 						gpath->ginfo->usage += grp.usage;
 						gpath->ginfo->temp_usage += grp.usage;
+						set_usage_factor(gpath->ginfo);
 						gpath = gpath->next;
 					}
 				}
+				set_usage_factor(ginfo);
 			}
 		}
 		else
@@ -935,14 +1047,14 @@ read_usage_v1(FILE *fp, group_info *root)
  *
  * @param[in]	fp    - the file pointer to the open file
  * @param[in]	flags	-	flags to check whether to trim or not.
- * @param[in]	root  - root of the fairshare tree
+ * @param[in]	fhead - fairshare tree
  *
  *	@retval 1 success
  *	@retval 0 failure
  *
  */
 int
-read_usage_v2(FILE *fp, int flags, group_info *root)
+read_usage_v2(FILE *fp, int flags, fairshare_head *fhead)
 {
 	struct group_node_usage_v2 grp;
 	group_info *ginfo;
@@ -957,9 +1069,9 @@ read_usage_v2(FILE *fp, int flags, group_info *root)
 			 * already in the resource_group file
 			 */
 			if (flags & FS_TRIM)
-				ginfo = find_group_info(grp.name, root);
+				ginfo = find_group_info(grp.name, fhead);
 			else
-				ginfo = find_alloc_ginfo(grp.name, root);
+				ginfo = find_alloc_ginfo(grp.name, fhead);
 
 			if (ginfo != NULL) {
 				ginfo->usage = grp.usage;
@@ -970,9 +1082,11 @@ read_usage_v2(FILE *fp, int flags, group_info *root)
 					while (gpath->next != NULL) {
 						gpath->ginfo->usage += grp.usage;
 						gpath->ginfo->temp_usage += grp.usage;
+						set_usage_factor(gpath->ginfo);
 						gpath = gpath->next;
 					}
 				}
+				set_usage_factor(ginfo);
 			}
 		}
 		else
@@ -1115,6 +1229,7 @@ dup_fairshare_tree(group_info *root, group_info *nparent)
 	nroot->percentage = root->percentage;
 	nroot->usage = root->usage;
 	nroot->temp_usage = root->temp_usage;
+	nroot->usage_factor = root->usage_factor;
 	nroot->name = string_dup(root->name);
 
 	if (nroot->name == NULL) {
@@ -1181,6 +1296,7 @@ new_fairshare_head()
 
 	fhead->root = NULL;
 	fhead->last_decay = 0;
+	fhead->name_idx = NULL;
 
 	return fhead;
 }
@@ -1229,6 +1345,8 @@ free_fairshare_head(fairshare_head *fhead)
 	if (fhead == NULL)
 		return;
 
+	if (fhead->name_idx != NULL)
+		entlim_free_ctx(fhead->name_idx, keep_group_info);
 	free_fairshare_tree(fhead->root);
 
 	free(fhead);
@@ -1249,6 +1367,7 @@ reset_temp_usage(group_info *head)
 		return;
 
 	head->temp_usage = head->usage;
+	set_usage_factor(head);
 	reset_temp_usage(head->sibling);
 	reset_temp_usage(head->child);
 }
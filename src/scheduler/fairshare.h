@@ -47,17 +47,26 @@ extern "C" {
 void add_child(group_info *ginfo, group_info *parent);
 
 /*
- *      find_group_info - recursive function to find a ginfo in the
- resgroup tree
+ *      index_fairshare_tree - add the ginfos of a subtree to a name index
  */
-group_info *find_group_info(char *name, group_info *root);
+int index_fairshare_tree(group_info *root, void *idx);
+
+/*
+ *      keep_group_info - entlim free function which leaves the ginfo alone
+ */
+void keep_group_info(void *ginfo);
+
+/*
+ *      find_group_info - find a ginfo in the resgroup tree by name
+ */
+group_info *find_group_info(char *name, fairshare_head *fhead);
 
 /*
  *      find_alloc_ginfo - trys to find a ginfo in the fair share tree.  If it
  *                        can not find the ginfo, then allocate a new one and
  *                        add it to the "unknown" group
  */
-group_info *find_alloc_ginfo(char *name, group_info *root);
+group_info *find_alloc_ginfo(char *name, fairshare_head *fhead);
 
 
 /*
@@ -74,7 +83,7 @@ group_info * new_group_info();
  *	parse_group - parse the resource group file
  *
  *	  fname - name of the file
- *	  root  - root of fairshare tree
+ *	  fhead - fairshare tree
  *
  *	return success/failure
  *
@@ -87,7 +96,7 @@ group_info * new_group_info();
  *	  shares  - the amount of shares the user/group has in its resgroup
  *
  */
-int parse_group(char *fname, group_info *root);
+int parse_group(char *fname, fairshare_head *fhead);
 
 /*
  *
@@ -118,12 +127,23 @@ int count_shares(group_info *grp);
  */
 int calc_fair_share_perc(group_info *root, int shares);
 
+/*
+ *      set_usage_factor - recalculate the cached usage / percentage ratio
+ */
+void set_usage_factor(group_info *ginfo);
+
 /*
  *      update_usage_on_run - update a users usage information when a
  *                            job is run
  */
 void update_usage_on_run(resource_resv *resresv);
 
+/*
+ *      undo_usage_on_run - take back the usage accrued when a job was run
+ *                          if the server could not run it
+ */
+void undo_usage_on_run(resource_resv *resresv);
+
 /*
  *      calculate_usage_value - calcualte a value that represents the usage
  *                              information
@@ -175,12 +195,12 @@ int read_usage(char *filename, int flags, fairshare_head *fhead);
 /*
  *      read_usage_v1 - read version 1 usage file
  */
-int read_usage_v1(FILE *fp, group_info *root);
+int read_usage_v1(FILE *fp, fairshare_head *fhead);
 
 /*
  *      read_usage_v2 - read version 2 usage file
  */
-int read_usage_v2(FILE *fp, int flags, group_info *root);
+int read_usage_v2(FILE *fp, int flags, fairshare_head *fhead);
 
 /*
  *      new_group_path - create a new group_path structure and init it
@@ -264,12 +284,12 @@ void free_fairshare_head(fairshare_head *fhead);
  *	add_unknown - add a ginfo to the "unknown" group
  *
  *	  ginfo - ginfo to add
- *	  root  - root of fairshare tre
+ *	  fhead - fairshare tree
  *
  *	return nothing
  *
  */
-void add_unknown(group_info *ginfo, group_info *root);
+void add_unknown(group_info *ginfo, fairshare_head *fhead);
 
 /*
  * 	reset_temp_usage - walk the fairshare tree resetting temp_usage = usage
@@ -52,6 +52,10 @@
  * 	end_cycle_tasks()
  * 	update_last_running()
  * 	update_job_can_not_run()
+ * 	queue_run_job()
+ * 	add_failed_run()
+ * 	flush_run_jobs()
+ * 	handle_failed_runs()
  * 	run_job()
  * 	run_update_resresv()
  * 	sim_run_update_resresv()
@@ -110,6 +114,9 @@
 #include "pbs_share.h"
 #include "pbs_internal.h"
 #include "limits_if.h"
+#include "profile.h"
+#include "trace.h"
+#include "snapshot.h"
 
 
 #ifdef NAS
@@ -176,7 +183,7 @@ schedinit(int argc, char *argv[])
 	/* preload the static members to the fairshare tree */
 	conf.fairshare = preload_tree();
 	if (conf.fairshare != NULL) {
-		parse_group(RESGROUP_FILE, conf.fairshare->root);
+		parse_group(RESGROUP_FILE, conf.fairshare);
 		calc_fair_share_perc(conf.fairshare->root->child, UNSPECIFIED);
 		if (conf.prime_fs || conf.non_prime_fs) {
 			read_usage(USAGE_FILE, 0, conf.fairshare);
@@ -363,7 +370,7 @@ init_scheduling_cycle(status *policy, server_info *sinfo)
 
 			for (i = 0; i < last_running_size ; i++) {
 				user = find_alloc_ginfo(last_running[i].entity_name,
-					sinfo->fairshare->root);
+					sinfo->fairshare);
 
 				for (j = 0; sinfo->running_jobs[j] != NULL &&
 					strcmp(last_running[i].name, sinfo->running_jobs[j]->name); j++)
@@ -490,8 +497,12 @@ schedule(int cmd, int sd, char *runjobid)
 			/*
 			 * on the first cycle after the server restarts custom resources
 			 * may have been added.  Dump what we have so we'll requery them.
+			 * The same goes for any job statuses we have cached.
 			 */
 			reset_global_resource_ptrs();
+			free_job_status_cache();
+			free_cant_run_cache();
+			free_np_layout_cache();
 
 		case SCH_SCHEDULE_NEW:
 		case SCH_SCHEDULE_TERM:
@@ -512,6 +523,10 @@ schedule(int cmd, int sd, char *runjobid)
 				write_usage(USAGE_FILE, conf.fairshare);
 			free_fairshare_head(conf.fairshare);
 			reset_global_resource_ptrs();
+			free_job_status_cache();
+			free_cant_run_cache();
+			free_np_layout_cache();
+			stop_node_eval_pool();
 			free(conf.prime_sort);
 			free(conf.non_prime_sort);
 			if(schedinit(0, NULL) != 0)
@@ -546,9 +561,22 @@ intermediate_schedule(int sd, char *jobid)
 {
 	int ret; /* to re schedule or not */
 	int cycle_cnt = 0; /* count of cycles run */
+	char snapfile[MAXPATHLEN + 1];
 
 	do {
+		/* write the input of this cycle for pbs_sched_replay */
+		if (snapshot_requested) {
+			snapshot_requested = 0;
+			snprintf(snapfile, sizeof(snapfile), "%s.%ld", SNAPSHOT_FILE,
+				(long) time(NULL));
+			snapshot_begin(snapfile);
+		}
+
+		prof_cycle_start();
+		trace_cycle_start();
 		ret = scheduling_cycle(sd, jobid);
+		prof_cycle_end(sd);
+		snapshot_end();
 
 		/* don't restart cycle if :- */
 
@@ -603,20 +631,26 @@ scheduling_cycle(int sd, char *jobid)
 	schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_DEBUG,
 		"", "Starting Scheduling Cycle");
 
-	update_cycle_status(&cstat, 0);
+	/* a replayed cycle runs at the time its snapshot was taken */
+	update_cycle_status(&cstat, snapshot_time());
 
 #ifdef NAS /* localmod 030 */
 	do_soft_cycle_interrupt = 0;
 	do_hard_cycle_interrupt = 0;
 #endif /* localmod 030 */
 	/* create the server / queue / job / node structures */
-	if ((sinfo = query_server(&cstat, sd)) == NULL) {
+	prof_start(PROF_QUERY_SERVER);
+	sinfo = query_server(&cstat, sd);
+	prof_stop(PROF_QUERY_SERVER);
+	if (sinfo == NULL) {
 		schdlog(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
 			"", "Problem with creating server data structure");
-		end_cycle_tasks(sinfo);
+		end_cycle_tasks(sd, sinfo);
 		return 0;
 	}
 	policy = sinfo->policy;
+
+	begin_cant_run_cache(policy, sinfo);
 	
 
 	/* don't confirm reservations if we're handling a qrun request */
@@ -626,7 +660,7 @@ scheduling_cycle(int sd, char *jobid)
 			 * further in the scheduling cycle since we don't have the up to date
 			 * information about the newly confirmed reservations
 			 */
-			end_cycle_tasks(sinfo);
+			end_cycle_tasks(sd, sinfo);
 			return 0;
 		}
 	}
@@ -661,7 +695,7 @@ scheduling_cycle(int sd, char *jobid)
 	if (init_scheduling_cycle(policy, sinfo) == 0) {
 		schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
 			sinfo->name, "init_scheduling_cycle failed.");
-		end_cycle_tasks(sinfo);
+		end_cycle_tasks(sd, sinfo);
 		return 0;
 	}
 
@@ -669,6 +703,9 @@ scheduling_cycle(int sd, char *jobid)
 	if (error == 0)
 		rc = main_sched_loop(policy, sd, sinfo, &err);
 
+	/* send what is left of the job updates queued during the cycle */
+	flush_job_updates(sd);
+
 	if (jobid != NULL) {
 		int def_rc = -1;
 		int i;
@@ -717,7 +754,7 @@ scheduling_cycle(int sd, char *jobid)
 	/* localmod 034 */
 	site_list_shares(stdout, sinfo, "eoc_", 1);
 #endif
-	end_cycle_tasks(sinfo);
+	end_cycle_tasks(sd, sinfo);
 	
 	free_schd_error(err);
 	if (rc < 0)
@@ -767,6 +804,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 	int sort_again = DONT_SORT_JOBS;
 	schd_error *err;
 	schd_error *chk_lim_err;
+	resresv_set **equiv_classes = NULL;	/* classes of alike jobs */
+	resresv_set *ec;		/* equivalence class of njob */
+	enum trace_phase tphase;	/* how njob's fate was decided */
 
 
 	if (policy == NULL || sinfo == NULL || rerr == NULL)
@@ -785,6 +825,12 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		return -1;
 	}
 
+	/* jobs alike in everything checked to see if they can run are grouped
+	 * so once one of them can not run, the others aren't checked again
+	 */
+	if (sinfo->qrun_job == NULL)
+		equiv_classes = create_resresv_sets(sinfo);
+
 	/* main scheduling loop */
 #ifdef NAS
 	/* localmod 030 */
@@ -802,6 +848,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		}
 #endif /* localmod 030 */
 
+		prof_start(PROF_JOB);
+		trace_job_start();
+		tphase = TRACE_NOT_RUN;
 		rc = 0;
 		comment[0] = '\0';
 		log_msg[0] = '\0';
@@ -813,13 +862,37 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG,
 			njob->name, "Considering job to run");
 
-		if (njob->is_shrink_to_fit) {
+		ec = NULL;
+		if (equiv_classes != NULL && njob->ec_index != UNSPECIFIED)
+			ec = equiv_classes[njob->ec_index];
+
+		if (ec != NULL && ec->can_not_run) {
+			schd_error *ecerr;
+
+			/* a job just like this one could not run, neither can this one */
+			schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, njob->name,
+				"Job's equivalence class can not run, skipping checks");
+			if ((ecerr = dup_schd_error(ec->err)) != NULL) {
+				move_schd_error(err, ecerr);
+				free_schd_error(ecerr);
+			}
+			ns_arr = NULL;
+			tphase = TRACE_EQUIV_CLASS;
+		}
+		else if (njob->is_shrink_to_fit) {
 			/* Pass the suitable heuristic for shrinking */
 			ns_arr = is_ok_to_run_STF(policy, sd, sinfo, qinfo, njob, err, shrink_job_algorithm);
 		}
 		else
 			ns_arr = is_ok_to_run(policy, sd, sinfo, qinfo, njob, NO_FLAGS, err);
-		
+
+		if (ns_arr == NULL && ec != NULL && !ec->can_not_run &&
+			ec->num_members > 1 && err->error_code != SUCCESS &&
+			err->error_code != SCHD_ERROR && err->error_code != NOT_QUEUED) {
+			if ((ec->err = dup_schd_error(err)) != NULL)
+				ec->can_not_run = 1;
+		}
+
 		if (err->status_code == NEVER_RUN)
 			njob->can_never_run = 1;
 
@@ -838,6 +911,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				if(run_update_resresv(policy, sd, sinfo, qinfo, tj, ns_arr, RURR_ADD_END_EVENT, err) > 0 ) {
 					rc = SUCCESS;
 					sort_again = MAY_RESORT_JOBS;
+					tphase = TRACE_RUN;
 				} else {
 					/* if run_update_resresv() returns 0 and pbs_errno == PBSE_HOOKERROR,
 					 * then this job is required to be ignored in this scheduling cycle
@@ -849,9 +923,17 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				free_nspecs(ns_arr);
 		}
 		else if (policy->preempting && in_runnable_state(njob) && (!njob -> can_never_run)) {
-			if (find_and_preempt_jobs(policy, sd, njob, sinfo, err) > 0) {
+			int preempt_rc;
+
+			prof_start(PROF_PREEMPT);
+			preempt_rc = find_and_preempt_jobs(policy, sd, njob, sinfo, err);
+			prof_stop(PROF_PREEMPT);
+			if (preempt_rc > 0) {
 				rc = SUCCESS;
 				sort_again = MUST_RESORT_JOBS;
+				tphase = TRACE_PREEMPT_RUN;
+				/* resources were freed, alike jobs may run now */
+				clear_resresv_sets(equiv_classes);
 			}
 			else
 				sort_again = SORTED;
@@ -883,9 +965,12 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			sort_again = SORTED;
 			if (should_backfill_with_job(policy, sinfo, njob, num_topjobs)) {
 #endif
+				prof_start(PROF_CALENDAR);
 				cal_rc = add_job_to_calendar(sd, policy, sinfo, njob);
+				prof_stop(PROF_CALENDAR);
 
 				if (cal_rc > 0) { /* Success! */
+					tphase = TRACE_TOP_JOB;
 #ifdef NAS /* localmod 034 */
 					switch(bf_rc)
 					{
@@ -967,6 +1052,12 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING,
 				njob->name, "Job will never run with the resources currently configured in the complex");
 		}
+		trace_decision(njob, tphase, err);
+
+		/* jobs the server could not run give their resources back */
+		if (handle_failed_runs(policy, sd, sinfo) > 0)
+			sort_again = MAY_RESORT_JOBS;
+
 		if ((rc != SUCCESS) && njob->job->resv ==NULL) {
 			/* jobs in reservations are outside of the law... they don't cause
 			 * the rest of the system to idle waiting for them
@@ -1027,11 +1118,13 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 
 		/* send any attribute updates to server that we've collected */
 		send_job_updates(sd, njob);
+		prof_stop(PROF_JOB);
 	}
 
 	*rerr = err;
 		
 	free_schd_error(chk_lim_err);
+	free_resresv_set_array(equiv_classes);
 	return rc;
 }
 
@@ -1039,16 +1132,24 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
  * @brief
  *		end_cycle_tasks - stuff which needs to happen at the end of a cycle
  *
+ * @param[in]	pbs_sd	-	connection descriptor to the pbs server
  * @param[in]	sinfo	-	the server structure
  *
  * @return	nothing
  *
  */
 void
-end_cycle_tasks(server_info *sinfo)
+end_cycle_tasks(int pbs_sd, server_info *sinfo)
 {
 	int i;
 
+	/* every way out of the cycle sends the job updates queued during it.
+	 * The jobs the server could not run get their comments set too.
+	 */
+	flush_job_updates(pbs_sd);
+	if (handle_failed_runs(sinfo != NULL ? sinfo->policy : NULL, pbs_sd, sinfo) > 0)
+		flush_job_updates(pbs_sd);
+
 	/* keep track of update used resources for fairshare */
 	if (sinfo != NULL && sinfo->policy->fair_share)
 		update_last_running(sinfo);
@@ -1156,6 +1257,7 @@ update_job_can_not_run(int pbs_sd, resource_resv *job, schd_error *err)
 			snprintf(del_buf, MAX_LOG_SIZE, "Job Deleted because it would never run: %s", log_buf);
 			schdlog(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
 				job->name, del_buf);
+			flush_job_updates(pbs_sd);
 			pbs_deljob(pbs_sd, job->name, del_buf);
 		}
 		
@@ -1170,6 +1272,304 @@ update_job_can_not_run(int pbs_sd, resource_resv *job, schd_error *err)
 	return ret;
 }
 
+/* asynchronous run requests waiting to be sent to the server in one
+ * pbs_asyrunjobs() request.  The name of each entry is a job id and its
+ * value is the execvnode to run the job on.
+ */
+static struct attrl *queued_runs = NULL;
+static struct attrl *queued_runs_tail = NULL;
+static int num_queued_runs = 0;
+
+/* jobs of the queued run requests the server could not run, waiting for
+ * handle_failed_runs().  Each entry has the error_code and error_text of
+ * the job as its attribs, as returned by pbs_asyrunjobs().
+ */
+static struct batch_status *failed_runs = NULL;
+
+/**
+ * @brief
+ * 		queue_run_job - queue an asynchronous run request for a job to be
+ *		sent by flush_run_jobs().  A full queue of MAX_QUEUED_RUNS jobs is
+ *		flushed before the job is added, so the job is never sent before
+ *		it has been run in our universe.  The queue is also flushed before
+ *		any other request the scheduler sends about a job and at the end
+ *		of the cycle.
+ *
+ * @param[in]	pbs_sd	-	pbs connection descriptor to the LOCAL server
+ * @param[in]	rjob	-	the job to run
+ * @param[in]	execvnode	-	the execvnode to run the job on
+ *
+ * @retval	0	: success
+ * @retval	!0	: error, pbs_errno is set
+ */
+static int
+queue_run_job(int pbs_sd, resource_resv *rjob, char *execvnode)
+{
+	struct attrl *pattr;
+
+	if ((pattr = new_attrl()) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return (pbs_errno = PBSE_SYSTEM);
+	}
+	pattr->name = string_dup(rjob->name);
+	pattr->value = string_dup(execvnode != NULL ? execvnode : "");
+	if (pattr->name == NULL || pattr->value == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_attrl(pattr);
+		return (pbs_errno = PBSE_SYSTEM);
+	}
+
+	if (num_queued_runs >= MAX_QUEUED_RUNS)
+		flush_run_jobs(pbs_sd);
+
+	if (queued_runs_tail != NULL)
+		queued_runs_tail->next = pattr;
+	else
+		queued_runs = pattr;
+	queued_runs_tail = pattr;
+	num_queued_runs++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ * 		add_failed_run - add a job the server could not run to the
+ *		failed_runs list for handle_failed_runs()
+ *
+ * @param[in]	jobid	-	the job which could not be run
+ * @param[in]	code	-	the pbs error code
+ * @param[in]	text	-	the error message or NULL
+ *
+ * @return	nothing
+ */
+static void
+add_failed_run(char *jobid, int code, char *text)
+{
+	struct batch_status *bs;
+	struct attrl *pattr;
+	char codebuf[20];
+
+	if ((bs = malloc(sizeof(struct batch_status))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return;
+	}
+	bs->name = string_dup(jobid);
+	bs->text = NULL;
+	bs->attribs = NULL;
+	bs->next = NULL;
+	if (bs->name == NULL) {
+		free(bs);
+		return;
+	}
+
+	snprintf(codebuf, sizeof(codebuf), "%d", code);
+	if ((pattr = new_attrl()) != NULL) {
+		pattr->name = string_dup(ATTR_JOBS_ERRCODE);
+		pattr->value = string_dup(codebuf);
+		bs->attribs = pattr;
+		if ((pattr->next = new_attrl()) != NULL) {
+			pattr = pattr->next;
+			pattr->name = string_dup(ATTR_JOBS_ERRTEXT);
+			pattr->value = string_dup(text != NULL ? text : "");
+		}
+	}
+
+	bs->next = failed_runs;
+	failed_runs = bs;
+}
+
+/**
+ * @brief
+ * 		flush_run_jobs - send the queued asynchronous run requests to the
+ *		server with one pbs_asyrunjobs() request
+ *
+ * @par
+ *		The jobs were already run in our universe.  The jobs the server
+ *		could not run are kept for handle_failed_runs() to take back out
+ *		of the universe, since a flush can happen while a job is in the
+ *		middle of being run in it.  If the request failed as a whole, the
+ *		jobs are sent again one at a time.
+ *
+ * @param[in]	pbs_sd	-	pbs connection descriptor to the LOCAL server
+ *
+ * @return	int
+ * @retval	1	success or nothing to send
+ * @retval	0	failure to run at least one job
+ */
+int
+flush_run_jobs(int pbs_sd)
+{
+	struct attrl *runs;
+	struct attrl *pattr;
+	struct batch_status *failed = NULL;
+	struct batch_status *bs;
+	char *errbuf;
+	char logbuf[MAX_LOG_SIZE];
+	int num_runs;
+	int rc = 1;
+
+	if (queued_runs == NULL)
+		return 1;
+
+	runs = queued_runs;
+	num_runs = num_queued_runs;
+	queued_runs = NULL;
+	queued_runs_tail = NULL;
+	num_queued_runs = 0;
+
+	if (pbs_sd != SIMULATE_SD && !got_sigpipe &&
+		pbs_asyrunjobs(pbs_sd, runs, &failed, NULL) != 0) {
+		rc = 0;
+		if (failed != NULL) {
+			for (bs = failed; bs->next != NULL; bs = bs->next)
+				;
+			bs->next = failed_runs;
+			failed_runs = failed;
+		} else {
+			errbuf = pbs_geterrmsg(pbs_sd);
+			if (errbuf == NULL)
+				errbuf = "";
+			snprintf(logbuf, MAX_LOG_SIZE,
+				"Failed to run %d jobs: %s (%d), running each job",
+				num_runs, errbuf, pbs_errno);
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+				__func__, logbuf);
+			rc = 1;
+			for (pattr = runs; pattr != NULL && !got_sigpipe; pattr = pattr->next) {
+				if (pbs_asyrunjob(pbs_sd, pattr->name, pattr->value, NULL) != 0) {
+					rc = 0;
+					errbuf = pbs_geterrmsg(pbs_sd);
+					add_failed_run(pattr->name, pbs_errno, errbuf);
+				}
+			}
+		}
+	}
+
+	free_attrl_list(runs);
+
+	return rc;
+}
+
+/**
+ * @brief
+ * 		handle_failed_runs - take the jobs the server could not run out
+ *		of the queued run requests (see flush_run_jobs()) back out of our
+ *		universe.  They give back their resources and fairshare usage and
+ *		are marked can not run, with their comment set and the reason
+ *		logged as if their run request had failed right away.
+ *
+ * @par
+ *		Called between jobs in the main scheduling loop and at the end of
+ *		the cycle, when no job is in the middle of being run.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	pbs_sd	-	pbs connection descriptor to the LOCAL server
+ * @param[in]	sinfo	-	the server, or NULL to only drop the failed jobs
+ *
+ * @return	int
+ * @retval	number of jobs taken back out of the universe
+ */
+int
+handle_failed_runs(status *policy, int pbs_sd, server_info *sinfo)
+{
+	struct batch_status *failed;
+	struct batch_status *bs;
+	struct attrl *attrp;
+	resource_resv *rjob;
+	resource_resv *cjob;	/* job whose comment is set */
+	timed_event *te;
+	schd_error *err;
+	char comment[MAX_LOG_SIZE];
+	char log_msg[MAX_LOG_SIZE];
+	char codebuf[20];
+	char *errtext;
+	int errcode;
+	int num = 0;
+
+	if (failed_runs == NULL)
+		return 0;
+
+	failed = failed_runs;
+	failed_runs = NULL;
+
+	if (policy == NULL || sinfo == NULL) {
+		pbs_statfree(failed);
+		return 0;
+	}
+
+	if ((err = new_schd_error()) == NULL) {
+		pbs_statfree(failed);
+		return 0;
+	}
+
+	for (bs = failed; bs != NULL; bs = bs->next) {
+		errcode = PBSE_NONE;
+		errtext = "";
+		for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+			if (attrp->name == NULL || attrp->value == NULL)
+				continue;
+			if (!strcmp(attrp->name, ATTR_JOBS_ERRCODE))
+				errcode = atoi(attrp->value);
+			else if (!strcmp(attrp->name, ATTR_JOBS_ERRTEXT))
+				errtext = attrp->value;
+		}
+
+		rjob = find_resource_resv(sinfo->jobs, bs->name);
+		if (rjob == NULL || rjob->job == NULL)
+			continue;
+
+		if (rjob->job->is_running) {
+			if (sinfo->calendar != NULL) {
+				te = find_calendar_event(sinfo->calendar, rjob->name, TIMED_END_EVENT, 0);
+				if (te != NULL) {
+					if (delete_event(sinfo, te, DE_NO_FLAGS) == 0)
+						schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, rjob->name, "Failed to delete end event for job.");
+				}
+			}
+			update_universe_on_end(policy, rjob, is_finished_job(errcode) ? "E" : "Q");
+			/* a run the server refused is not charged to the entity */
+			if (policy->fair_share)
+				undo_usage_on_run(rjob);
+		}
+		num++;
+
+		cjob = rjob;
+		rjob->can_not_run = 1;
+		if (rjob->job->is_subjob && rjob->job->parent_job != NULL) {
+			cjob = rjob->job->parent_job;
+			cjob->can_not_run = 1;
+		}
+
+		if (is_finished_job(errcode) == 1) {
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO,
+				rjob->name, "Job already finished");
+			continue;
+		}
+
+		clear_schd_error(err);
+		set_schd_error_codes(err, NOT_RUN, RUN_FAILURE);
+		set_schd_error_arg(err, ARG1, errtext);
+		snprintf(codebuf, sizeof(codebuf), "%d", errcode);
+		set_schd_error_arg(err, ARG2, codebuf);
+
+		comment[0] = '\0';
+		log_msg[0] = '\0';
+		translate_fail_code(err, comment, log_msg);
+		if (comment[0] != '\0' &&
+			(!cjob->job->is_array || !cjob->job->is_begin))
+			update_job_comment(pbs_sd, cjob, comment);
+		if (log_msg[0] != '\0')
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB,
+				LOG_INFO, rjob->name, log_msg);
+	}
+
+	free_schd_error(err);
+	pbs_statfree(failed);
+
+	return num;
+}
+
 /**
  * @brief
  * 		run_job - handle the running of a pbs job.  If it's a peer job
@@ -1182,6 +1582,11 @@ update_job_can_not_run(int pbs_sd, resource_resv *job, schd_error *err)
  * @param[in]	throughput	-	thoughput mode enabled?
  * @param[out]	err	-	error struct to return errors
  *
+ * @par
+ *		In throughput mode, the run request is queued with queue_run_job()
+ *		and sent along with others.  The server would not have waited for
+ *		the job to start anyway.
+ *
  * @retval	0	: success
  * @retval	1	: failure
  * @retval -1	: error
@@ -1202,6 +1607,13 @@ run_job(int pbs_sd, resource_resv *rjob, char *execvnode, int throughput, schd_e
 		return -1;
 	}
 
+	/* the server needs to see queued updates of the job before it runs.
+	 * Queued runs are sent before queued updates, so the updates of other
+	 * jobs can wait.
+	 */
+	if (!throughput || job_updates_queued(rjob))
+		flush_job_updates(pbs_sd);
+
 	if (rjob->is_peer_ob) {
 		if (strchr(rjob->server->name, (int) ':') == NULL) {
 #ifdef NAS /* localmod 005 */
@@ -1245,13 +1657,13 @@ run_job(int pbs_sd, resource_resv *rjob, char *execvnode, int throughput, schd_e
 						schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_NOTICE, rjob->name, logbuf);
 					}
 					if (throughput)
-						rc = pbs_asyrunjob(pbs_sd, rjob->name, execvnode, NULL);
+						rc = queue_run_job(pbs_sd, rjob, execvnode);
 					else
 						rc = pbs_runjob(pbs_sd, rjob->name, execvnode, NULL);
 				}
 			} else {
 				if (throughput)
-					rc = pbs_asyrunjob(pbs_sd, rjob->name, execvnode, NULL);
+					rc = queue_run_job(pbs_sd, rjob, execvnode);
 				else
 					rc = pbs_runjob(pbs_sd, rjob->name, execvnode, NULL);
 			}
@@ -1384,6 +1796,7 @@ run_update_resresv(status *policy, int pbs_sd, server_info *sinfo,
 	pbs_errno = PBSE_NONE;
 	if (resresv->is_job && resresv->job->is_suspended) {
 		if (pbs_sd != SIMULATE_SD) {
+			flush_job_updates(pbs_sd);
 			pbsrc = pbs_sigjob(pbs_sd, resresv->name, "resume", NULL);
 			if (!pbsrc)
 				ret = 1;
@@ -1508,7 +1921,9 @@ run_update_resresv(status *policy, int pbs_sd, server_info *sinfo,
 					fflush(stdout);
 #endif /* localmod 031 */
 
-					pbsrc = run_job(pbs_sd, rr, execvnode, sinfo->throughput_mode, err);
+					/* a qrun is answered with the result of its run request */
+					pbsrc = run_job(pbs_sd, rr, execvnode,
+						sinfo->throughput_mode && sinfo->qrun_job == NULL, err);
 
 #ifdef NAS_CLUSTER /* localmod 125 */
 					ret = translate_runjob_return_code(pbsrc, resresv);
@@ -2177,7 +2592,9 @@ next_job(status *policy, server_info *sinfo, int flag)
 		else if (policy->by_queue)
 			last_queue = 0;
 		skip = SKIP_NOTHING;
+		prof_start(PROF_SORT_JOBS);
 		sort_jobs(policy, sinfo);
+		prof_stop(PROF_SORT_JOBS);
 		sort_status = SORTED;
 		return NULL;
 	}
@@ -2200,7 +2617,9 @@ next_job(status *policy, server_info *sinfo, int flag)
 
 	if ((sort_status != SORTED) || ((flag == MAY_RESORT_JOBS) && policy->fair_share)
 		|| (flag == MUST_RESORT_JOBS)) {
+		prof_start(PROF_SORT_JOBS);
 		sort_jobs(policy, sinfo);
+		prof_stop(PROF_SORT_JOBS);
 		sort_status = SORTED;
 	}
 	if (policy->round_robin) {
@@ -156,7 +156,7 @@ int update_job_can_not_run(int pbs_sd, resource_resv *job, schd_error *err);
 /*
  *	end_cycle_tasks - stuff which needs to happen at the end of a cycle
  */
-void end_cycle_tasks(server_info *sinfo);
+void end_cycle_tasks(int pbs_sd, server_info *sinfo);
 
 /*
  *	add_job_to_calendar - find the most top job and init all the
@@ -171,6 +171,17 @@ int add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo, resource
  */
 int run_job(int pbs_sd, resource_resv *rjob, char *execvnode, int throughput, schd_error *err);
 
+/*
+ *	flush_run_jobs - send the queued asynchronous run requests to the server
+ */
+int flush_run_jobs(int pbs_sd);
+
+/*
+ *	handle_failed_runs - take the jobs the server could not run out of the
+ *			     queued run requests back out of our universe
+ */
+int handle_failed_runs(status *policy, int pbs_sd, server_info *sinfo);
+
 /*
  *	should_backfill_with_job - should we call add_job_to_calendar() with job
  *	returns 1: we should backfill 0: we should not
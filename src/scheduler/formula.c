@@ -0,0 +1,992 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    formula.c
+ *
+ * @brief
+ * 	formula.c - native evaluation of the job_sort_formula and the
+ *	fairshare_usage_res formula.  A formula is compiled once into an
+ *	expression tree whose resource names are resolved to their resource
+ *	definitions.  The tree is then evaluated for each job without going
+ *	through the embedded python interpreter.
+ *
+ *	The evaluation follows python 2 arithmetic since that is what the
+ *	formula has always been evaluated with: a value is an integer if
+ *	python would see it printed without a decimal point, integer division
+ *	floors and the modulus takes the sign of the divisor.  Formulas using
+ *	anything other than numbers, names, parentheses and the operators
+ *	+ - * / // % ** are left to python, as are values which would overflow
+ *	a python int into a long.
+ *
+ * Functions included are:
+ * 	new_formula_node()
+ * 	free_formula_node()
+ * 	formula_skip_space()
+ * 	parse_formula_number()
+ * 	parse_formula_name()
+ * 	parse_formula_atom()
+ * 	parse_formula_power()
+ * 	parse_formula_factor()
+ * 	parse_formula_term()
+ * 	parse_formula_expr()
+ * 	compile_formula()
+ * 	formula_res_value()
+ * 	formula_binary_op()
+ * 	formula_power()
+ * 	eval_formula_node()
+ * 	find_compiled_formula()
+ * 	formula_evaluate_native()
+ * 	free_formula_cache()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+
+#include <log.h>
+#include <libutil.h>
+#include <pbs_share.h>
+#include "constant.h"
+#include "config.h"
+#include "data_types.h"
+#include "globals.h"
+#include "misc.h"
+#include "resource_resv.h"
+#include "formula.h"
+
+/* number of distinct formulas kept compiled */
+#define FORMULA_CACHE_SIZE 4
+
+enum formula_op {
+	FOP_CONST,
+	FOP_RES,
+	FOP_SPECIAL,
+	FOP_NEG,
+	FOP_POS,
+	FOP_ADD,
+	FOP_SUB,
+	FOP_MUL,
+	FOP_DIV,
+	FOP_FLOORDIV,
+	FOP_MOD,
+	FOP_POW
+};
+
+/* the special case key words a formula can use */
+enum formula_special {
+	FSP_ELIGIBLE_TIME,
+	FSP_QUEUE_PRIO,
+	FSP_JOB_PRIO,
+	FSP_FSPERC,
+	FSP_ACCRUE_TYPE
+};
+
+/* return codes of eval_formula_node() */
+enum formula_eval_rc {
+	FEVAL_OK,
+	FEVAL_EXCEPTION,		/* python would have raised an exception */
+	FEVAL_UNSUPPORTED		/* leave it to python */
+};
+
+/* a python int or float */
+struct formula_value {
+	int is_int;
+	long long i;
+	double f;
+};
+
+struct formula_node {
+	enum formula_op op;
+	struct formula_value val;	/* FOP_CONST */
+	resdef *def;			/* FOP_RES */
+	enum formula_special special;	/* FOP_SPECIAL */
+	struct formula_node *left;	/* operand of unary operators */
+	struct formula_node *right;
+};
+
+struct compiled_formula {
+	char *src;			/* the formula */
+	struct formula_node *expr;	/* NULL if it is left to python */
+};
+
+static struct compiled_formula formula_cache[FORMULA_CACHE_SIZE];
+static int formula_cache_next = 0;
+
+static void free_formula_node(struct formula_node *node);
+static struct formula_node *parse_formula_expr(char **s);
+static struct formula_node *parse_formula_factor(char **s);
+
+/**
+ * @brief
+ * 		allocate a formula_node
+ *
+ * @param[in]	op	-	the node's operation
+ * @param[in]	left	-	left (or only) operand
+ * @param[in]	right	-	right operand
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error (the operands are freed)
+ */
+static struct formula_node *
+new_formula_node(enum formula_op op, struct formula_node *left,
+	struct formula_node *right)
+{
+	struct formula_node *node;
+
+	if ((node = malloc(sizeof(struct formula_node))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_formula_node(left);
+		free_formula_node(right);
+		return NULL;
+	}
+
+	node->op = op;
+	node->val.is_int = 1;
+	node->val.i = 0;
+	node->val.f = 0;
+	node->def = NULL;
+	node->special = FSP_ELIGIBLE_TIME;
+	node->left = left;
+	node->right = right;
+
+	return node;
+}
+
+/**
+ * @brief
+ * 		free a formula expression tree
+ *
+ * @param[in]	node	-	root of the tree
+ *
+ * @return	void
+ */
+static void
+free_formula_node(struct formula_node *node)
+{
+	if (node == NULL)
+		return;
+
+	free_formula_node(node->left);
+	free_formula_node(node->right);
+	free(node);
+}
+
+/**
+ * @brief
+ * 		skip the white space in a formula
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	void
+ */
+static void
+formula_skip_space(char **s)
+{
+	while (**s == ' ' || **s == '\t')
+		(*s)++;
+}
+
+/**
+ * @brief
+ * 		parse a number the way python 2 would.  Octal, hex, long and
+ *		complex literals are not handled.
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: not a number we handle
+ */
+static struct formula_node *
+parse_formula_number(char **s)
+{
+	struct formula_node *node;
+	char *p = *s;
+	char *endp;
+	int is_int = 1;
+	long long i = 0;
+	double f = 0;
+
+	while (isdigit((int) *p))
+		p++;
+	if (*p == '.') {
+		is_int = 0;
+		p++;
+		while (isdigit((int) *p))
+			p++;
+	}
+	if (*p == 'e' || *p == 'E') {
+		is_int = 0;
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!isdigit((int) *p))
+			return NULL;
+		while (isdigit((int) *p))
+			p++;
+	}
+	if (isalnum((int) *p) || *p == '_' || *p == '.' || p == *s)
+		return NULL;
+
+	if (is_int) {
+		/* a leading 0 makes it octal */
+		if (**s == '0' && p - *s > 1)
+			return NULL;
+		errno = 0;
+		i = strtoll(*s, &endp, 10);
+		if (errno == ERANGE)
+			return NULL;
+	} else {
+		if (**s == '.' && p - *s == 1)
+			return NULL;
+		f = strtod(*s, &endp);
+	}
+	if (endp != p)
+		return NULL;
+
+	if ((node = new_formula_node(FOP_CONST, NULL, NULL)) == NULL)
+		return NULL;
+	node->val.is_int = is_int;
+	node->val.i = i;
+	node->val.f = f;
+	*s = p;
+
+	return node;
+}
+
+/**
+ * @brief
+ * 		parse a name and resolve it to a special case key word or
+ *		to a consumable resource
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: not a name we know
+ */
+static struct formula_node *
+parse_formula_name(char **s)
+{
+	struct formula_node *node;
+	static struct {
+		char *name;
+		enum formula_special special;
+	} specials[] = {
+		{FORMULA_ELIGIBLE_TIME, FSP_ELIGIBLE_TIME},
+		{FORMULA_QUEUE_PRIO, FSP_QUEUE_PRIO},
+		{FORMULA_JOB_PRIO, FSP_JOB_PRIO},
+		{FORMULA_FSPERC, FSP_FSPERC},
+		{FORMULA_ACCRUE_TYPE, FSP_ACCRUE_TYPE}
+	};
+	char *p = *s;
+	int len;
+	int i;
+
+	while (isalnum((int) *p) || *p == '_')
+		p++;
+	len = p - *s;
+	if (len == 0)
+		return NULL;
+
+	/* the special cases are added last to python's dictionary so win */
+	for (i = 0; i < sizeof(specials) / sizeof(specials[0]); i++) {
+		if (strlen(specials[i].name) == len && !strncmp(*s, specials[i].name, len)) {
+			if ((node = new_formula_node(FOP_SPECIAL, NULL, NULL)) == NULL)
+				return NULL;
+			node->special = specials[i].special;
+			*s = p;
+			return node;
+		}
+	}
+
+	for (i = 0; consres[i] != NULL; i++) {
+		if (strlen(consres[i]->name) == len && !strncmp(*s, consres[i]->name, len)) {
+			if ((node = new_formula_node(FOP_RES, NULL, NULL)) == NULL)
+				return NULL;
+			node->def = consres[i];
+			*s = p;
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		parse an atom: a number, a name or a parenthesized expression
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error
+ */
+static struct formula_node *
+parse_formula_atom(char **s)
+{
+	struct formula_node *node;
+
+	formula_skip_space(s);
+
+	if (**s == '(') {
+		(*s)++;
+		node = parse_formula_expr(s);
+		if (node == NULL)
+			return NULL;
+		formula_skip_space(s);
+		if (**s != ')') {
+			free_formula_node(node);
+			return NULL;
+		}
+		(*s)++;
+		return node;
+	}
+
+	if (isdigit((int) **s) || **s == '.')
+		return parse_formula_number(s);
+
+	if (isalpha((int) **s) || **s == '_')
+		return parse_formula_name(s);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		parse a power: atom ['**' factor]
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error
+ */
+static struct formula_node *
+parse_formula_power(char **s)
+{
+	struct formula_node *left;
+	struct formula_node *right;
+
+	if ((left = parse_formula_atom(s)) == NULL)
+		return NULL;
+
+	formula_skip_space(s);
+	if ((*s)[0] != '*' || (*s)[1] != '*')
+		return left;
+	*s += 2;
+
+	if ((right = parse_formula_factor(s)) == NULL) {
+		free_formula_node(left);
+		return NULL;
+	}
+
+	return new_formula_node(FOP_POW, left, right);
+}
+
+/**
+ * @brief
+ * 		parse a factor: ('+'|'-') factor | power
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error
+ */
+static struct formula_node *
+parse_formula_factor(char **s)
+{
+	struct formula_node *node;
+	enum formula_op op;
+
+	formula_skip_space(s);
+	if (**s != '-' && **s != '+')
+		return parse_formula_power(s);
+
+	op = (**s == '-') ? FOP_NEG : FOP_POS;
+	(*s)++;
+	if ((node = parse_formula_factor(s)) == NULL)
+		return NULL;
+
+	return new_formula_node(op, node, NULL);
+}
+
+/**
+ * @brief
+ * 		parse a term: factor (('*'|'/'|'//'|'%') factor)*
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error
+ */
+static struct formula_node *
+parse_formula_term(char **s)
+{
+	struct formula_node *node;
+	struct formula_node *right;
+	enum formula_op op;
+
+	if ((node = parse_formula_factor(s)) == NULL)
+		return NULL;
+
+	while (1) {
+		formula_skip_space(s);
+		if ((*s)[0] == '*' && (*s)[1] != '*') {
+			op = FOP_MUL;
+			*s += 1;
+		} else if ((*s)[0] == '/' && (*s)[1] == '/') {
+			op = FOP_FLOORDIV;
+			*s += 2;
+		} else if ((*s)[0] == '/') {
+			op = FOP_DIV;
+			*s += 1;
+		} else if ((*s)[0] == '%') {
+			op = FOP_MOD;
+			*s += 1;
+		} else
+			return node;
+
+		if ((right = parse_formula_factor(s)) == NULL) {
+			free_formula_node(node);
+			return NULL;
+		}
+		if ((node = new_formula_node(op, node, right)) == NULL)
+			return NULL;
+	}
+}
+
+/**
+ * @brief
+ * 		parse an expression: term (('+'|'-') term)*
+ *
+ * @param[in,out]	s	-	position in the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: on error
+ */
+static struct formula_node *
+parse_formula_expr(char **s)
+{
+	struct formula_node *node;
+	struct formula_node *right;
+	enum formula_op op;
+
+	if ((node = parse_formula_term(s)) == NULL)
+		return NULL;
+
+	while (1) {
+		formula_skip_space(s);
+		if (**s == '+')
+			op = FOP_ADD;
+		else if (**s == '-')
+			op = FOP_SUB;
+		else
+			return node;
+		(*s)++;
+
+		if ((right = parse_formula_term(s)) == NULL) {
+			free_formula_node(node);
+			return NULL;
+		}
+		if ((node = new_formula_node(op, node, right)) == NULL)
+			return NULL;
+	}
+}
+
+/**
+ * @brief
+ * 		compile a formula into an expression tree
+ *
+ * @param[in]	formula	-	the formula
+ *
+ * @return	struct formula_node *
+ * @retval	NULL	: the formula has to be left to python
+ */
+static struct formula_node *
+compile_formula(char *formula)
+{
+	struct formula_node *expr;
+	char *s = formula;
+
+	if ((expr = parse_formula_expr(&s)) == NULL)
+		return NULL;
+
+	formula_skip_space(&s);
+	if (*s != '\0') {
+		free_formula_node(expr);
+		return NULL;
+	}
+
+	return expr;
+}
+
+/**
+ * @brief
+ * 		the value python would see for a resource.  It is printed into
+ *		python's dictionary with float_digits() digits so read the
+ *		printed value back the same way.
+ *
+ * @param[in]	amount	-	amount of the resource
+ * @param[out]	val	-	the value
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: python would see a long
+ */
+static int
+formula_res_value(sch_resource_t amount, struct formula_value *val)
+{
+	char buf[128];
+	int digits;
+
+	digits = float_digits(amount, FLOAT_NUM_DIGITS);
+	if (digits == 0) {
+		/* 9.2e18 is about LLONG_MAX */
+		if (amount >= 9.2e18 || amount <= -9.2e18)
+			return 0;
+		val->is_int = 1;
+		/* float_digits() leaves no .5 to round, so this matches %.0f */
+		val->i = (long long) (amount < 0 ? -floor(-amount + 0.5) : floor(amount + 0.5));
+		return 1;
+	}
+
+	snprintf(buf, sizeof(buf), "%.*f", digits, amount);
+	val->is_int = 0;
+	val->f = strtod(buf, NULL);
+	return 1;
+}
+
+/**
+ * @brief
+ * 		raise a value to a power the way python 2 does
+ *
+ * @param[in]	l	-	base
+ * @param[in]	r	-	exponent
+ * @param[out]	ans	-	result
+ * @param[out]	msg	-	the exception if one is raised
+ *
+ * @return	enum formula_eval_rc
+ */
+static enum formula_eval_rc
+formula_power(struct formula_value *l, struct formula_value *r,
+	struct formula_value *ans, char **msg)
+{
+	double base;
+	double exp;
+
+	if (l->is_int && r->is_int && r->i >= 0) {
+		long long b = l->i;
+		long long e = r->i;
+		long long res = 1;
+
+		while (e > 0) {
+			if (e & 1) {
+				if (b != 0 && (res > LLONG_MAX / (b < 0 ? -b : b) ||
+					res < -(LLONG_MAX / (b < 0 ? -b : b))))
+					return FEVAL_UNSUPPORTED;
+				res *= b;
+			}
+			e >>= 1;
+			if (e > 0) {
+				if (b > 3037000499LL || b < -3037000499LL)
+					return FEVAL_UNSUPPORTED;
+				b *= b;
+			}
+		}
+		ans->is_int = 1;
+		ans->i = res;
+		return FEVAL_OK;
+	}
+
+	base = l->is_int ? (double) l->i : l->f;
+	exp = r->is_int ? (double) r->i : r->f;
+
+	ans->is_int = 0;
+	if (exp == 0) {
+		ans->f = 1.0;
+		return FEVAL_OK;
+	}
+	if (base == 0 && exp < 0) {
+		*msg = "0.0 cannot be raised to a negative power";
+		return FEVAL_EXCEPTION;
+	}
+	if (base < 0 && exp != floor(exp)) {
+		*msg = "negative number cannot be raised to a fractional power";
+		return FEVAL_EXCEPTION;
+	}
+	ans->f = pow(base, exp);
+	/* python raises an OverflowError */
+	if (ans->f > DBL_MAX || ans->f < -DBL_MAX || ans->f != ans->f)
+		return FEVAL_UNSUPPORTED;
+
+	return FEVAL_OK;
+}
+
+/**
+ * @brief
+ * 		apply a binary operator the way python 2 does
+ *
+ * @param[in]	op	-	the operator
+ * @param[in]	l	-	left operand
+ * @param[in]	r	-	right operand
+ * @param[out]	ans	-	result
+ * @param[out]	msg	-	the exception if one is raised
+ *
+ * @return	enum formula_eval_rc
+ */
+static enum formula_eval_rc
+formula_binary_op(enum formula_op op, struct formula_value *l,
+	struct formula_value *r, struct formula_value *ans, char **msg)
+{
+	long long a;
+	long long b;
+	double x;
+	double y;
+	double mod;
+	double div;
+	double floordiv;
+
+	if (op == FOP_POW)
+		return formula_power(l, r, ans, msg);
+
+	if (l->is_int && r->is_int) {
+		a = l->i;
+		b = r->i;
+		ans->is_int = 1;
+		switch (op) {
+			case FOP_ADD:
+				if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b))
+					return FEVAL_UNSUPPORTED;
+				ans->i = a + b;
+				break;
+			case FOP_SUB:
+				if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b))
+					return FEVAL_UNSUPPORTED;
+				ans->i = a - b;
+				break;
+			case FOP_MUL:
+				if (a != 0 && b != 0) {
+					if (a > 0 ? (b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a) :
+						(b > 0 ? a < LLONG_MIN / b : b < LLONG_MAX / a))
+						return FEVAL_UNSUPPORTED;
+				}
+				ans->i = a * b;
+				break;
+			case FOP_DIV:
+			case FOP_FLOORDIV:
+			case FOP_MOD:
+				if (b == 0) {
+					*msg = "integer division or modulo by zero";
+					return FEVAL_EXCEPTION;
+				}
+				if (a == LLONG_MIN && b == -1)
+					return FEVAL_UNSUPPORTED;
+				if (op == FOP_MOD) {
+					ans->i = a % b;
+					if (ans->i != 0 && ((ans->i < 0) != (b < 0)))
+						ans->i += b;
+				} else {
+					ans->i = a / b;
+					if ((a % b != 0) && ((a < 0) != (b < 0)))
+						ans->i--;
+				}
+				break;
+			default:
+				return FEVAL_UNSUPPORTED;
+		}
+		return FEVAL_OK;
+	}
+
+	x = l->is_int ? (double) l->i : l->f;
+	y = r->is_int ? (double) r->i : r->f;
+	ans->is_int = 0;
+	switch (op) {
+		case FOP_ADD:
+			ans->f = x + y;
+			break;
+		case FOP_SUB:
+			ans->f = x - y;
+			break;
+		case FOP_MUL:
+			ans->f = x * y;
+			break;
+		case FOP_DIV:
+			if (y == 0) {
+				*msg = "float division by zero";
+				return FEVAL_EXCEPTION;
+			}
+			ans->f = x / y;
+			break;
+		case FOP_MOD:
+			if (y == 0) {
+				*msg = "float modulo";
+				return FEVAL_EXCEPTION;
+			}
+			mod = fmod(x, y);
+			if (mod != 0) {
+				if ((y < 0) != (mod < 0))
+					mod += y;
+			} else
+				mod = 0.0 * y;	/* zero with the sign of y */
+			ans->f = mod;
+			break;
+		case FOP_FLOORDIV:
+			/* python's float_divmod() */
+			if (y == 0) {
+				*msg = "float divmod()";
+				return FEVAL_EXCEPTION;
+			}
+			mod = fmod(x, y);
+			div = (x - mod) / y;
+			if (mod != 0 && ((y < 0) != (mod < 0)))
+				div -= 1.0;
+			if (div != 0) {
+				floordiv = floor(div);
+				if (div - floordiv > 0.5)
+					floordiv += 1.0;
+			} else
+				floordiv = 0.0 * (x / y);
+			ans->f = floordiv;
+			break;
+		default:
+			return FEVAL_UNSUPPORTED;
+	}
+
+	return FEVAL_OK;
+}
+
+/**
+ * @brief
+ * 		evaluate a compiled formula for a job
+ *
+ * @param[in]	node	-	the expression tree
+ * @param[in]	resresv	-	job for the special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ * @param[out]	ans	-	result
+ * @param[out]	msg	-	the exception if one is raised
+ *
+ * @return	enum formula_eval_rc
+ */
+static enum formula_eval_rc
+eval_formula_node(struct formula_node *node, resource_resv *resresv,
+	resource_req *resreq, struct formula_value *ans, char **msg)
+{
+	struct formula_value l;
+	struct formula_value r;
+	resource_req *req;
+	enum formula_eval_rc rc;
+	char buf[128];
+
+	switch (node->op) {
+		case FOP_CONST:
+			*ans = node->val;
+			return FEVAL_OK;
+
+		case FOP_RES:
+			req = find_resource_req(resreq, node->def);
+			if (req == NULL) {
+				ans->is_int = 1;
+				ans->i = 0;
+				return FEVAL_OK;
+			}
+			return formula_res_value(req->amount, ans) ? FEVAL_OK : FEVAL_UNSUPPORTED;
+
+		case FOP_SPECIAL:
+			ans->is_int = 1;
+			switch (node->special) {
+				case FSP_ELIGIBLE_TIME:
+					ans->i = resresv->job->eligible_time;
+					break;
+				case FSP_QUEUE_PRIO:
+					ans->i = resresv->job->queue->priority;
+					break;
+				case FSP_JOB_PRIO:
+					ans->i = resresv->job->priority;
+					break;
+				case FSP_ACCRUE_TYPE:
+					ans->i = resresv->job->accrue_type;
+					break;
+				case FSP_FSPERC:
+					/* printed with %lf into python's dictionary */
+					snprintf(buf, sizeof(buf), "%lf", resresv->job->ginfo == NULL ?
+						0.0 : resresv->job->ginfo->percentage);
+					ans->is_int = 0;
+					ans->f = strtod(buf, NULL);
+					break;
+			}
+			return FEVAL_OK;
+
+		case FOP_NEG:
+		case FOP_POS:
+			if ((rc = eval_formula_node(node->left, resresv, resreq, ans, msg)) != FEVAL_OK)
+				return rc;
+			if (node->op == FOP_NEG) {
+				if (ans->is_int) {
+					if (ans->i == LLONG_MIN)
+						return FEVAL_UNSUPPORTED;
+					ans->i = -ans->i;
+				} else
+					ans->f = -ans->f;
+			}
+			return FEVAL_OK;
+
+		default:
+			if ((rc = eval_formula_node(node->left, resresv, resreq, &l, msg)) != FEVAL_OK)
+				return rc;
+			if ((rc = eval_formula_node(node->right, resresv, resreq, &r, msg)) != FEVAL_OK)
+				return rc;
+			return formula_binary_op(node->op, &l, &r, ans, msg);
+	}
+}
+
+/**
+ * @brief
+ * 		find the compiled form of a formula, compiling it the first
+ *		time it is seen
+ *
+ * @param[in]	formula	-	the formula
+ *
+ * @return	struct compiled_formula *
+ * @retval	NULL	: on error
+ */
+static struct compiled_formula *
+find_compiled_formula(char *formula)
+{
+	struct compiled_formula *cf;
+	int i;
+
+	for (i = 0; i < FORMULA_CACHE_SIZE; i++) {
+		if (formula_cache[i].src != NULL && !strcmp(formula_cache[i].src, formula))
+			return &formula_cache[i];
+	}
+
+	cf = &formula_cache[formula_cache_next];
+	formula_cache_next = (formula_cache_next + 1) % FORMULA_CACHE_SIZE;
+
+	free(cf->src);
+	free_formula_node(cf->expr);
+	cf->expr = NULL;
+	if ((cf->src = string_dup(formula)) == NULL)
+		return NULL;
+
+	cf->expr = compile_formula(formula);
+	if (cf->expr == NULL)
+		schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, formula,
+			"Formula can not be evaluated natively, python will be used");
+
+	return cf;
+}
+
+/**
+ * @brief
+ * 		evaluate a math formula for a job based on its resources
+ *		without the embedded python interpreter
+ *
+ * @param[in]	formula	-	formula to evaluate
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ * @param[out]	ans	-	evaluated formula answer or 0 on exception
+ *
+ * @return	int
+ * @retval	1	: the formula was evaluated
+ * @retval	0	: the formula needs to be evaluated by python
+ *
+ * @par MT-safe: No
+ */
+int
+formula_evaluate_native(char *formula, resource_resv *resresv,
+	resource_req *resreq, sch_resource_t *ans)
+{
+	struct compiled_formula *cf;
+	struct formula_value val;
+	char errbuf[MAX_LOG_SIZE];
+	char *msg = NULL;
+
+	if (ans == NULL)
+		return 0;
+
+	*ans = 0;
+	if (formula == NULL || resresv == NULL ||
+		resresv->job == NULL || consres == NULL)
+		return 1;
+
+	if ((cf = find_compiled_formula(formula)) == NULL || cf->expr == NULL)
+		return 0;
+
+	switch (eval_formula_node(cf->expr, resresv, resreq, &val, &msg)) {
+		case FEVAL_OK:
+			*ans = val.is_int ? (sch_resource_t) val.i : val.f;
+			return 1;
+		case FEVAL_EXCEPTION:
+			snprintf(errbuf, sizeof(errbuf),
+				"Formula evaluation for job had an error.  Zero value will be used: %s",
+				msg);
+			schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+				resresv->name, errbuf);
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief
+ * 		free the compiled formulas
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+free_formula_cache(void)
+{
+	int i;
+
+	for (i = 0; i < FORMULA_CACHE_SIZE; i++) {
+		free(formula_cache[i].src);
+		free_formula_node(formula_cache[i].expr);
+		formula_cache[i].src = NULL;
+		formula_cache[i].expr = NULL;
+	}
+	formula_cache_next = 0;
+}
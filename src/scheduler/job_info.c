@@ -42,12 +42,23 @@
  *
  * Functions included are:
  * 	query_jobs()
+ * 	new_job_status_entry()
+ * 	free_job_status_entry()
+ * 	keep_job_status_entry()
+ * 	update_job_status_eligible_time()
+ * 	cache_job_statuses()
+ * 	query_job_status()
+ * 	begin_job_status_cache()
+ * 	end_job_status_cache()
+ * 	free_job_status_cache()
  * 	query_job()
  * 	new_job_info()
  * 	free_job_info()
  * 	set_job_state()
  * 	update_job_attr()
  * 	send_job_updates()
+ * 	job_updates_queued()
+ * 	flush_job_updates()
  * 	send_attr_updates()
  * 	unset_job_attr()
  * 	update_job_comment()
@@ -59,6 +70,10 @@
  * 	preempt_job()
  * 	find_and_preempt_jobs()
  * 	find_jobs_to_preempt()
+ * 	preempt_node_ind()
+ * 	new_preempt_victims()
+ * 	free_preempt_victims()
+ * 	preempt_node_fit()
  * 	select_job_to_preempt()
  * 	preempt_level()
  * 	set_preempt_prio()
@@ -69,6 +84,7 @@
  * 	modify_job_array_for_qrun()
  * 	queue_subjob()
  * 	formula_evaluate()
+ * 	formula_evaluate_python()
  * 	make_eligible()
  * 	make_ineligible()
  * 	update_accruetype()
@@ -101,6 +117,7 @@
 #include <pbs_share.h>
 #include <pbs_internal.h>
 #include <pbs_error.h>
+#include <pbs_entlim.h>
 #include "queue_info.h"
 #include "job_info.h"
 #include "resv_info.h"
@@ -119,6 +136,9 @@
 #include "simulate.h"
 #include "resource.h"
 #include "server_info.h"
+#include "profile.h"
+#include "snapshot.h"
+#include "formula.h"
 
 #ifdef NAS
 #include "site_code.h"
@@ -490,6 +510,37 @@ static struct fc_translation_table fctt[] = {
 #define	ERR2COMMENT(code)	(fctt[(code) - RET_BASE].fc_comment)
 #define	ERR2INFO(code)		(fctt[(code) - RET_BASE].fc_info)
 
+/* job states whose status is kept between cycles by the job status cache.
+ * Jobs in any other state are always queried in full.
+ */
+#define JOB_STATUS_CACHE_STATES	"QHW"
+
+/**
+ *	The job status cache keeps the full batch_status of each queued job
+ *	between cycles when incremental_job_query is set.  Each cycle only the
+ *	state and mtime of the jobs in a queue are queried and the full status
+ *	is only requested for jobs which have changed since they were cached.
+ *
+ *	Entries are keyed by job name.  As entries are reused, they are moved
+ *	from the previous generation (job_status_cache_prev) into the current
+ *	one (job_status_cache).  Anything left in the previous generation once
+ *	all queues have been queried belongs to jobs which have left the system.
+ */
+struct job_status_cache_entry {
+	struct batch_status *bs;	/* full status of the job */
+	long mtime;			/* job's mtime when bs was queried */
+	time_t queried;			/* cycle time when bs was queried */
+	long eligible_time;		/* eligible_time when bs was queried */
+};
+
+static void *job_status_cache = NULL;		/* current generation */
+static void *job_status_cache_prev = NULL;	/* previous generation */
+static time_t job_status_cache_synced = 0;	/* time of last full query */
+static time_t job_status_cache_now = 0;		/* time of current cycle */
+static int job_status_cache_resync = 0;		/* query all jobs in full */
+
+static struct batch_status *query_job_status(int pbs_sd, char *queue_name);
+
 /**
  * @brief
  * 		create an array of jobs in a specified queue
@@ -557,6 +608,9 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	/* used for pbs_geterrmsg() */
 	char *errmsg;
 
+	/* job statuses are owned by the job status cache */
+	int cached = 0;
+
 	if (policy == NULL || qinfo == NULL || queue_name == NULL)
 		return pjobs;
 
@@ -564,10 +618,19 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 
 	if (qinfo->is_peer_queue)
 		opl.next = &opl2[0];
+	else if (job_status_cache != NULL)
+		cached = 1;
 
 
 	/* get jobs from PBS server */
-	if ((jobs = pbs_selstat(pbs_sd, &opl, NULL, "S")) == NULL) {
+	if (cached)
+		jobs = query_job_status(pbs_sd, queue_name);
+	else
+		jobs = pbs_selstat(pbs_sd, &opl, NULL, "S");
+
+	snapshot_put(SNAP_JOB, queue_name, jobs);
+
+	if (jobs == NULL) {
 		if (pbs_errno > 0) {
 			errmsg = pbs_geterrmsg(pbs_sd);
 			if (errmsg == NULL)
@@ -600,7 +663,8 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 
 	if (resresv_arr == NULL) {
 		log_err(errno, "query_jobs", "Error allocating memory");
-		pbs_statfree(jobs);
+		if (!cached)
+			pbs_statfree(jobs);
 		return NULL;
 	}
 	resresv_arr[num_prev_jobs] = NULL;
@@ -613,7 +677,8 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	for (i = num_prev_jobs; cur_job != NULL; i++) {
 		if ((resresv = query_job(cur_job, qinfo->server, err)) ==NULL) {
 			free_schd_error(err);
-			pbs_statfree(jobs);
+			if (!cached)
+				pbs_statfree(jobs);
 			free_resource_resv_array(resresv_arr);
 			return NULL;
 		}
@@ -748,7 +813,7 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		if (!strcmp(conf.fairshare_ent, "queue")) {
 			if (resresv->server->fairshare !=NULL) {
 				resresv->job->ginfo =
-					find_alloc_ginfo(qinfo->name, resresv->server->fairshare->root);
+					find_alloc_ginfo(qinfo->name, resresv->server->fairshare);
 			}
 			else
 				resresv->job->ginfo = NULL;
@@ -767,7 +832,7 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 #endif /* localmod 058 */
 			if (resresv->server->fairshare !=NULL) {
 				resresv->job->ginfo = find_alloc_ginfo(fairshare_name,
-					resresv->server->fairshare->root);
+					resresv->server->fairshare);
 			}
 			else
 				resresv->job->ginfo = NULL;
@@ -850,12 +915,448 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	}
 	resresv_arr[i] = NULL;
 
-	pbs_statfree(jobs);
+	if (!cached)
+		pbs_statfree(jobs);
 	free_schd_error(err);
 
 	return resresv_arr;
 }
 
+/**
+ * @brief
+ *		create a job status cache entry for a job's batch_status
+ *
+ * @param[in]	bs	-	full status of the job
+ *
+ * @return	struct job_status_cache_entry *
+ * @retval	new entry
+ * @retval	NULL	: on error
+ */
+static struct job_status_cache_entry *
+new_job_status_entry(struct batch_status *bs)
+{
+	struct job_status_cache_entry *ent;
+	struct attrl *attrp;
+
+	if ((ent = malloc(sizeof(struct job_status_cache_entry))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	bs->next = NULL;
+	ent->bs = bs;
+	ent->mtime = 0;
+	ent->queried = job_status_cache_now;
+	ent->eligible_time = 0;
+
+	for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+		if (!strcmp(attrp->name, ATTR_mtime))
+			ent->mtime = strtol(attrp->value, NULL, 10);
+		else if (!strcmp(attrp->name, ATTR_eligible_time))
+			ent->eligible_time = (long) res_to_num(attrp->value, NULL);
+	}
+
+	return ent;
+}
+
+/**
+ * @brief
+ *		free a job status cache entry along with its batch_status
+ *
+ * @param[in]	entry	-	entry to free
+ *
+ * @return	void
+ */
+static void
+free_job_status_entry(void *entry)
+{
+	struct job_status_cache_entry *ent = entry;
+
+	if (ent == NULL)
+		return;
+
+	if (ent->bs != NULL) {
+		ent->bs->next = NULL;
+		pbs_statfree(ent->bs);
+	}
+	free(ent);
+}
+
+/**
+ * @brief
+ *		entlim free function used when an entry is removed from one index
+ *		but is still referenced by another
+ *
+ * @param[in]	entry	-	entry being removed
+ *
+ * @return	void
+ */
+static void
+keep_job_status_entry(void *entry)
+{
+	return;
+}
+
+/**
+ * @brief
+ *		bring the eligible_time of a reused job status up to date.  The
+ *		server computes eligible_time when the job is statused, so a job
+ *		accruing eligible time will have accrued it since it was cached.
+ *
+ * @param[in]	ent	-	job status cache entry being reused
+ *
+ * @return	void
+ */
+static void
+update_job_status_eligible_time(struct job_status_cache_entry *ent)
+{
+	struct attrl *attrp;
+	struct attrl *etime = NULL;
+	int accruing = 0;
+	char buf[32];
+
+	for (attrp = ent->bs->attribs; attrp != NULL; attrp = attrp->next) {
+		if (!strcmp(attrp->name, ATTR_eligible_time))
+			etime = attrp;
+		else if (!strcmp(attrp->name, ATTR_accrue_type))
+			accruing = !strcmp(attrp->value, ACCRUE_ELIG);
+	}
+
+	if (etime == NULL || !accruing)
+		return;
+
+	sprintf(buf, "%ld",
+		ent->eligible_time + (long)(job_status_cache_now - ent->queried));
+	free(etime->value);
+	etime->value = string_dup(buf);
+}
+
+/**
+ * @brief
+ *		add a list of full job statuses to the current generation of the
+ *		job status cache.
+ *
+ * @param[in]	bs_list	-	list of job statuses from pbs_selstat()
+ *
+ * @return	struct batch_status *
+ * @retval	bs_list (now owned by the job status cache)
+ */
+static struct batch_status *
+cache_job_statuses(struct batch_status *bs_list)
+{
+	struct batch_status *bs;
+	struct batch_status *bs_next;
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct job_status_cache_entry *ent;
+
+	for (bs = bs_list; bs != NULL; bs = bs_next) {
+		bs_next = bs->next;
+		if ((ent = new_job_status_entry(bs)) == NULL) {
+			pbs_statfree(bs);
+			continue;
+		}
+		if (entlim_replace(bs->name, ent, job_status_cache,
+			free_job_status_entry) != 0) {
+			free_job_status_entry(ent);
+			continue;
+		}
+
+		if (head == NULL)
+			head = bs;
+		else
+			tail->next = bs;
+		tail = bs;
+	}
+
+	return head;
+}
+
+/**
+ * @brief
+ *		query the status of the jobs in a queue through the job status cache.
+ *		Only the state and mtime of the jobs are queried every cycle.  The
+ *		full status is only queried for jobs which are not cached, jobs
+ *		which have been modified since they were cached, and jobs which are
+ *		not in a cacheable state (e.g. running jobs).
+ *
+ * @par NOTE:
+ *		mtime has a one second resolution.  A job modified within the same
+ *		second it was cached can not be told apart from an unmodified job, so
+ *		such jobs are queried again the next cycle.
+ *
+ * @param[in]	pbs_sd	-	connection to pbs_server
+ * @param[in]	queue_name	-	the name of the queue to query
+ *
+ * @return	struct batch_status *
+ * @retval	list of job statuses owned by the job status cache
+ * @retval	NULL	: no jobs or error (pbs_errno is set on error)
+ *
+ * @par MT-safe: No
+ */
+static struct batch_status *
+query_job_status(int pbs_sd, char *queue_name)
+{
+	struct attropl opl = { NULL, ATTR_q, NULL, NULL, EQ };
+	struct attropl opl_mtime = { NULL, ATTR_mtime, NULL, NULL, GE };
+	struct attropl opl_state =
+		{ NULL, ATTR_state, NULL, JOB_STATUS_CACHE_STATES, NE };
+	static struct attrl light_attrs[2] = {
+		{ &light_attrs[1], ATTR_state, NULL, "", SET },
+		{ NULL, ATTR_mtime, NULL, "", SET } };
+
+	/* state and mtime of all jobs in the queue */
+	struct batch_status *light;
+
+	/* jobs which need to be queried in full */
+	struct batch_status *fresh;
+	void *fresh_idx;
+
+	struct batch_status *bs;
+	struct batch_status *bs_next;
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct job_status_cache_entry *ent;
+	pbs_entlim_key_t *key;
+	struct attrl *attrp;
+	char *state;
+	char mtime_buf[32];
+	long mtime;
+	long min_mtime = 0;
+	int num_changed = 0;
+	int num_jobs = 0;
+	int num_cached = 0;
+	int need_others = 0;
+	int missing = 0;
+	int pass;
+
+	if (queue_name == NULL || job_status_cache == NULL)
+		return NULL;
+
+	opl.value = queue_name;
+
+	if (job_status_cache_resync || job_status_cache_prev == NULL)
+		return cache_job_statuses(pbs_selstat(pbs_sd, &opl, NULL, "S"));
+
+	if ((light = pbs_selstat(pbs_sd, &opl, light_attrs, "S")) == NULL)
+		return NULL;
+
+	/* find the jobs which need to be queried in full */
+	for (bs = light; bs != NULL; bs = bs->next) {
+		state = NULL;
+		mtime = 0;
+		for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+			if (!strcmp(attrp->name, ATTR_state))
+				state = attrp->value;
+			else if (!strcmp(attrp->name, ATTR_mtime))
+				mtime = strtol(attrp->value, NULL, 10);
+		}
+
+		if (state == NULL || strchr(JOB_STATUS_CACHE_STATES, *state) == NULL) {
+			need_others = 1;
+			continue;
+		}
+
+		ent = entlim_get(bs->name, job_status_cache_prev);
+		if (ent == NULL || ent->mtime != mtime || mtime >= ent->queried) {
+			if (num_changed == 0 || mtime < min_mtime)
+				min_mtime = mtime;
+			num_changed++;
+		}
+	}
+
+	if ((fresh_idx = entlim_initialize_ctx()) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		pbs_statfree(light);
+		return cache_job_statuses(pbs_selstat(pbs_sd, &opl, NULL, "S"));
+	}
+
+	/* pass 0: changed jobs, pass 1: jobs not in a cacheable state */
+	for (pass = 0; pass < 2; pass++) {
+		if (pass == 0) {
+			if (num_changed == 0)
+				continue;
+			sprintf(mtime_buf, "%ld", min_mtime);
+			opl_mtime.value = mtime_buf;
+			opl.next = &opl_mtime;
+		} else {
+			if (!need_others)
+				continue;
+			opl.next = &opl_state;
+		}
+
+		fresh = pbs_selstat(pbs_sd, &opl, NULL, "S");
+		if (fresh == NULL && pbs_errno > 0)
+			missing = 1;
+
+		for (bs = fresh; bs != NULL; bs = bs_next) {
+			bs_next = bs->next;
+			if ((ent = new_job_status_entry(bs)) == NULL) {
+				pbs_statfree(bs);
+				missing = 1;
+			}
+			else if (entlim_add(bs->name, ent, fresh_idx) != 0)
+				free_job_status_entry(ent); /* job was returned by both passes */
+		}
+	}
+	opl.next = NULL;
+
+	/* merge the cached and freshly queried statuses in server order */
+	for (bs = light; bs != NULL && !missing; bs = bs->next) {
+		if ((ent = entlim_get(bs->name, fresh_idx)) != NULL)
+			entlim_delete(bs->name, fresh_idx, keep_job_status_entry);
+		else if ((ent = entlim_get(bs->name, job_status_cache_prev)) != NULL) {
+			entlim_delete(bs->name, job_status_cache_prev, keep_job_status_entry);
+			update_job_status_eligible_time(ent);
+			num_cached++;
+		}
+		else {
+			/* job changed between our queries */
+			missing = 1;
+			break;
+		}
+
+		if (entlim_replace(bs->name, ent, job_status_cache,
+			free_job_status_entry) != 0) {
+			free_job_status_entry(ent);
+			missing = 1;
+			break;
+		}
+
+		ent->bs->next = NULL;
+		if (head == NULL)
+			head = ent->bs;
+		else
+			tail->next = ent->bs;
+		tail = ent->bs;
+		num_jobs++;
+	}
+	pbs_statfree(light);
+
+	if (missing) {
+		entlim_free_ctx(fresh_idx, free_job_status_entry);
+		sprintf(log_buffer, "Job status cache out of sync, querying all jobs");
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_QUEUE, LOG_DEBUG, queue_name,
+			log_buffer);
+		return cache_job_statuses(pbs_selstat(pbs_sd, &opl, NULL, "S"));
+	}
+
+	/* jobs which were submitted after the state and mtime query */
+	key = NULL;
+	while ((key = entlim_get_next(key, fresh_idx)) != NULL) {
+		ent = key->recptr;
+		if (entlim_replace(ent->bs->name, ent, job_status_cache,
+			free_job_status_entry) != 0) {
+			free_job_status_entry(ent);
+			continue;
+		}
+		if (head == NULL)
+			head = ent->bs;
+		else
+			tail->next = ent->bs;
+		tail = ent->bs;
+		num_jobs++;
+	}
+	entlim_free_ctx(fresh_idx, keep_job_status_entry);
+
+	sprintf(log_buffer, "Queried %d of %d jobs, %d from job status cache",
+		num_jobs - num_cached, num_jobs, num_cached);
+	schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_QUEUE, LOG_DEBUG, queue_name,
+		log_buffer);
+
+	return head;
+}
+
+/**
+ * @brief
+ *		start a new generation of the job status cache.  Called before the
+ *		jobs of all the queues are queried.  If incremental_job_query is not
+ *		set, the cache is freed and jobs are queried in full.
+ *
+ * @param[in]	sinfo	-	server whose jobs are about to be queried
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+begin_job_status_cache(server_info *sinfo)
+{
+	if (sinfo == NULL)
+		return;
+
+	if (!conf.incremental_job_query) {
+		free_job_status_cache();
+		return;
+	}
+
+	/* a previous query did not complete.  What was cached is still good */
+	if (job_status_cache != NULL)
+		end_job_status_cache();
+
+	job_status_cache_now = sinfo->server_time;
+
+	if (job_status_cache_prev == NULL ||
+		job_status_cache_now - job_status_cache_synced >= conf.job_query_resync_time) {
+		if (job_status_cache_prev != NULL) {
+			entlim_free_ctx(job_status_cache_prev, free_job_status_entry);
+			job_status_cache_prev = NULL;
+		}
+		job_status_cache_resync = 1;
+		job_status_cache_synced = job_status_cache_now;
+	}
+	else
+		job_status_cache_resync = 0;
+
+	if ((job_status_cache = entlim_initialize_ctx()) == NULL)
+		log_err(errno, __func__, MEM_ERR_MSG);
+}
+
+/**
+ * @brief
+ *		finish the current generation of the job status cache.  Statuses of
+ *		jobs which were not seen this cycle are freed.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+end_job_status_cache(void)
+{
+	if (job_status_cache == NULL)
+		return;
+
+	if (job_status_cache_prev != NULL)
+		entlim_free_ctx(job_status_cache_prev, free_job_status_entry);
+
+	job_status_cache_prev = job_status_cache;
+	job_status_cache = NULL;
+}
+
+/**
+ * @brief
+ *		free the job status cache.  All jobs will be queried in full the
+ *		next cycle.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+free_job_status_cache(void)
+{
+	if (job_status_cache != NULL) {
+		entlim_free_ctx(job_status_cache, free_job_status_entry);
+		job_status_cache = NULL;
+	}
+	if (job_status_cache_prev != NULL) {
+		entlim_free_ctx(job_status_cache_prev, free_job_status_entry);
+		job_status_cache_prev = NULL;
+	}
+	job_status_cache_synced = 0;
+}
+
 /**
  * @brief
  *		query_job - takes info from a batch_status about a job and
@@ -921,7 +1422,7 @@ query_job(struct batch_status *job, server_info *sinfo, schd_error *err)
 				if (strchr(attrp->value, ':') != NULL) {
 					/* moved to query_jobs() in order to include the queue name
 					 resresv -> job -> ginfo = find_alloc_ginfo( attrp -> value,
-					 sinfo -> fairshare -> root );
+					 sinfo -> fairshare );
 					 */
 					/* localmod 034 */
 					resresv->job->sh_info = site_find_alloc_share(sinfo,
@@ -929,7 +1430,7 @@ query_job(struct batch_status *job, server_info *sinfo, schd_error *err)
 				}
 #else
 				resresv->job->ginfo = find_alloc_ginfo(attrp->value,
-					sinfo->fairshare->root);
+					sinfo->fairshare);
 #endif /* localmod 059 */
 			}
 			else
@@ -1191,6 +1692,7 @@ new_job_info()
 	jinfo->queued_subjobs = NULL;
 	jinfo->parent_job = NULL;
 	jinfo->attr_updates = NULL;
+	jinfo->updates_queued = 0;
 
 	jinfo->formula_value = 0.0;
 
@@ -1439,34 +1941,196 @@ update_job_attr(int pbs_sd, resource_resv *resresv, char *attr_name,
 	return 0;
 }
 
+/* delayed job attribute updates waiting to be sent to the server in one
+ * pbs_alterjobs() request.  The name of each entry is a job id and its
+ * attribs are the job's attr_updates.
+ */
+static struct batch_status *job_updates = NULL;
+static struct batch_status *job_updates_tail = NULL;
+static int num_job_updates = 0;
+/* generation of the queue, bumped each time it is flushed.  A job whose
+ * updates_queued matches it has updates in the queue.
+ */
+static int job_updates_gen = 1;
+
 /**
  * @brief
- * 		send delayed job attribute updates for job using send_attr_updates().
+ * 		queue delayed job attribute updates for job to be sent by
+ *		flush_job_updates().
  *
  * @par
  * 		The main reason to use this function over a direct send_attr_update()
- *      call is so that the job's attr_updates list gets free'd and NULL'd.  
- *      We don't want to send the attr updates multiple times
+ *      call is so that the job's attr_updates list gets handed off and NULL'd.
+ *      We don't want to send the attr updates multiple times.
+ *
+ * @par
+ *      The queue is flushed when it holds MAX_JOB_UPDATES jobs, before
+ *      the scheduler sends any other request about a job to the server
+ *      and at the end of the cycle.
  * 
  * @param[in]	pbs_sd	-	server connection descriptor
  * @param[in]	job	-	job to send attributes to
  * 
- * @return	int(ret val from send_attr_updates)
+ * @return	int
  * @retval	1	- success
  * @retval	0	- failure to update
  */
 int send_job_updates(int pbs_sd, resource_resv *job) {
-	int rc;
+	struct batch_status *bs;
 	
-	if(job == NULL)
+	if(job == NULL || job->job->attr_updates == NULL)
 		return 0;
-	
-	rc = send_attr_updates(pbs_sd, job->name, job->job->attr_updates) ;
-	
-	free_attrl_list(job->job->attr_updates);
+
+	if (pbs_sd == SIMULATE_SD || got_sigpipe) {
+		free_attrl_list(job->job->attr_updates);
+		job->job->attr_updates = NULL;
+		return pbs_sd == SIMULATE_SD; /* simulation always successful */
+	}
+
+	if ((bs = malloc(sizeof(struct batch_status))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_attrl_list(job->job->attr_updates);
+		job->job->attr_updates = NULL;
+		return 0;
+	}
+	if ((bs->name = string_dup(job->name)) == NULL) {
+		free(bs);
+		free_attrl_list(job->job->attr_updates);
+		job->job->attr_updates = NULL;
+		return 0;
+	}
+	bs->attribs = job->job->attr_updates;
+	bs->text = NULL;
+	bs->next = NULL;
 	job->job->attr_updates = NULL;
-	return rc;
+	job->job->updates_queued = job_updates_gen;
+
+	if (job_updates_tail != NULL)
+		job_updates_tail->next = bs;
+	else
+		job_updates = bs;
+	job_updates_tail = bs;
+	num_job_updates++;
+
+	if (num_job_updates >= MAX_JOB_UPDATES)
+		return flush_job_updates(pbs_sd);
+
+	return 1;
 	}
+
+/**
+ * @brief
+ * 		are delayed attribute updates of a job waiting in the queue?
+ *
+ * @param[in]	job	-	the job
+ *
+ * @return	int
+ * @retval	1	the job has queued updates
+ * @retval	0	it does not
+ */
+int
+job_updates_queued(resource_resv *job)
+{
+	if (job == NULL || job->job == NULL)
+		return 0;
+
+	return job->job->updates_queued == job_updates_gen;
+}
+
+/**
+ * @brief
+ * 		send the queued delayed job attribute updates to the server with
+ *		one pbs_alterjobs() request.  The queued run requests are sent
+ *		first (see flush_run_jobs()).
+ *
+ * @par
+ *		Each job the server could not alter is logged like a failed
+ *		send_attr_updates().  If the request failed as a whole, the
+ *		updates are sent again one job at a time.
+ *
+ * @param[in]	pbs_sd	-	server connection descriptor
+ *
+ * @return	int
+ * @retval	1	success or nothing to send
+ * @retval	0	failure to update at least one job
+ */
+int
+flush_job_updates(int pbs_sd)
+{
+	struct batch_status *updates;
+	struct batch_status *failed = NULL;
+	struct batch_status *bs;
+	struct batch_status *bs_next;
+	struct attrl *attrp;
+	char *errbuf;
+	int errcode;
+	int num_updates;
+	char logbuf[MAX_LOG_SIZE];
+	int rc = 1;
+
+	/* updates made after a job was run have to reach the server after the run */
+	flush_run_jobs(pbs_sd);
+
+	if (job_updates == NULL)
+		return 1;
+
+	/* send_attr_updates() flushes the queue, so empty it first */
+	updates = job_updates;
+	num_updates = num_job_updates;
+	job_updates = NULL;
+	job_updates_tail = NULL;
+	num_job_updates = 0;
+	job_updates_gen++;
+
+	if (pbs_sd != SIMULATE_SD && !got_sigpipe &&
+		pbs_alterjobs(pbs_sd, updates, &failed, NULL) != 0) {
+		rc = 0;
+		if (failed == NULL) {
+			errbuf = pbs_geterrmsg(pbs_sd);
+			if (errbuf == NULL)
+				errbuf = "";
+			snprintf(logbuf, MAX_LOG_SIZE,
+				"Failed to update attributes of %d jobs: %s (%d), updating each job",
+				num_updates, errbuf, pbs_errno);
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+				__func__, logbuf);
+			rc = 1;
+			for (bs = updates; bs != NULL; bs = bs->next)
+				if (send_attr_updates(pbs_sd, bs->name, bs->attribs) == 0)
+					rc = 0;
+		}
+		for (bs = failed; bs != NULL; bs = bs->next) {
+			errcode = PBSE_NONE;
+			errbuf = "";
+			for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+				if (!strcmp(attrp->name, ATTR_JOBS_ERRCODE))
+					errcode = atoi(attrp->value);
+				else if (!strcmp(attrp->name, ATTR_JOBS_ERRTEXT))
+					errbuf = attrp->value;
+			}
+			if (is_finished_job(errcode) == 1) {
+				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, bs->name,
+					"Failed to update job attributes, Job already finished");
+			} else {
+				snprintf(logbuf, MAX_LOG_SIZE,
+					"Failed to update job attributes: %s (%d)", errbuf, errcode);
+				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+					bs->name, logbuf);
+			}
+		}
+		pbs_statfree(failed);
+	}
+
+	for (bs = updates; bs != NULL; bs = bs_next) {
+		bs_next = bs->next;
+		free_attrl_list(bs->attribs);
+		free(bs->name);
+		free(bs);
+	}
+
+	return rc;
+}
+
 /**
  * @brief
  * 		send delayed attributes to the server for a job
@@ -1490,6 +2154,8 @@ int send_attr_updates(int pbs_sd, char *job_name, struct attrl *pattr) {
 	if (pbs_sd == SIMULATE_SD)
 		return 1; /* simulation always successful */
 
+	/* keep updates in the order they were made */
+	flush_job_updates(pbs_sd);
 
 		if (pattr->next == NULL)
 			one_attr = 1;
@@ -1608,6 +2274,8 @@ update_jobs_cant_run(int pbs_sd, resource_resv **resresv_arr,
 	if (resresv_arr == NULL)
 		return;
 
+	prof_start(PROF_CANT_RUN);
+
 	/* We are not starting at the front of the array, so we need to find the
 	 * element to start with.
 	 */
@@ -1629,6 +2297,8 @@ update_jobs_cant_run(int pbs_sd, resource_resv **resresv_arr,
 			}
 		}
 	}
+
+	prof_stop(PROF_CANT_RUN);
 }
 
 /**
@@ -1952,7 +2622,7 @@ dup_job_info(job_info *ojinfo, queue_info *nqinfo)
 
 	if (nqinfo->server->fairshare !=NULL) {
 		njinfo->ginfo = find_group_info(ojinfo->ginfo->name,
-			nqinfo->server->fairshare->root);
+			nqinfo->server->fairshare);
 	}
 	else
 		njinfo->ginfo = NULL;
@@ -2135,6 +2805,8 @@ preempt_job(status *policy, int pbs_sd, resource_resv *pjob, server_info *sinfo)
 	if (!pjob->job->is_running || pjob->ninfo_arr == NULL)
 		return 0;
 
+	flush_job_updates(pbs_sd);
+
 	po = get_preemption_order(pjob, sinfo);
 	for (i = 0; i < PREEMPT_METHOD_HIGH && pjob->job->is_running; i++) {
 		if (po->order[i] == PREEMPT_METHOD_SUSPEND) {
@@ -2216,7 +2888,7 @@ preempt_job(status *policy, int pbs_sd, resource_resv *pjob, server_info *sinfo)
 	} else {
 		/* we're prematurely ending a job.  We need to correct our calendar */
 		if (sinfo->calendar != NULL) {
-			te = find_timed_event(sinfo->calendar->events, pjob->name, TIMED_END_EVENT, 0);
+			te = find_calendar_event(sinfo->calendar, pjob->name, TIMED_END_EVENT, 0);
 			if (te != NULL) {
 				if (delete_event(sinfo, te, DE_NO_FLAGS) == 0)
 					schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->name, "Failed to delete end event for job.");
@@ -2389,6 +3061,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 	char log_buf[MAX_LOG_SIZE];
 	nspec **ns_arr = NULL;
 	schd_error *err;
+	preempt_victims *pv;
 
 	enum sched_error old_errorcode = SUCCESS;
 	char *old_errorarg1 = NULL;
@@ -2575,12 +3248,24 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 		free_schd_error_list(full_err);
 		free_server(nsinfo, 1);
 		free(pjobs);
+		free(prjobs);
+		return NULL;
+	}
+
+	if ((pv = new_preempt_victims(policy, nsinfo, njob)) == NULL) {
+		free_schd_error_list(full_err);
+		free_schd_error(err);
+		free_server(nsinfo, 1);
+		free(pjobs);
+		free(prjobs);
+		return NULL;
 	}
 
 	skipto=0;
-	while ((indexfound = select_index_to_preempt(policy, njob, rjobs, skipto, err, fail_list)) != NO_JOB_FOUND) {
+	while ((indexfound = select_index_to_preempt(policy, njob, rjobs, skipto, err, fail_list, pv)) != NO_JOB_FOUND) {
 		if (indexfound == ERR_IN_SELECT) {
 			/* System error occurred, no need to proceed */
+			free_preempt_victims(pv);
 			free_server(nsinfo, 1);
 			free(pjobs);
 			free(old_errorarg1);
@@ -2596,7 +3281,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 
 			update_universe_on_end(policy, pjob,  "S");
 			if ( nsinfo -> calendar != NULL ) {
-				te = find_timed_event(nsinfo->calendar->events, pjob->name, TIMED_END_EVENT, 0);
+				te = find_calendar_event(nsinfo->calendar, pjob->name, TIMED_END_EVENT, 0);
 				if (te != NULL) {
 					if (delete_event(nsinfo, te, DE_NO_FLAGS) == 0)
 						schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->name, "Failed to delete end event for job.");
@@ -2650,6 +3335,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 					nj = queue_subjob(njob, nsinfo, njob->job->queue);
 
 					if (nj == NULL) {
+						free_preempt_victims(pv);
 						free_server(nsinfo, 1);
 						free(pjobs);
 						free_schd_error_list(full_err);
@@ -2710,6 +3396,7 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB,
 			LOG_DEBUG, njob->name, buf);
 	}
+	free_preempt_victims(pv);
 
 	pjobs[j] = NULL;
 
@@ -2789,6 +3476,190 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 	return pjobs_list;
 }
 
+/**
+ * @brief
+ *		preempt_node_ind - the position of a vnode (or of the server vnode
+ *		a reservation vnode is a copy of) in the server's node_res_index
+ *
+ * @param[in] pv - the victim search
+ * @param[in] node - the vnode
+ *
+ * @return int
+ * @retval position of the vnode
+ * @retval -1 : the vnode isn't in the index
+ */
+static int
+preempt_node_ind(preempt_victims *pv, node_info *node)
+{
+	int ind = node->node_ind;
+
+	if (ind < 0 && node->svr_node != NULL)
+		ind = node->svr_node->node_ind;
+
+	if (ind < 0 || ind >= pv->num_nodes)
+		return -1;
+
+	return ind;
+}
+
+/**
+ * @brief
+ *		new_preempt_victims - set up the search for preemption victims of
+ *		a high priority job.  What the vnodes of the universe can do for the
+ *		job is looked up once here and in preempt_node_fit() instead of
+ *		for every candidate select_index_to_preempt() looks at.
+ *
+ * @param[in] policy - policy info
+ * @param[in] sinfo - the universe the victims are running in
+ * @param[in] hjob - the high priority job to preempt for
+ *
+ * @return preempt_victims *
+ * @retval new victim search
+ * @retval NULL	: on error
+ */
+preempt_victims *
+new_preempt_victims(status *policy, server_info *sinfo, resource_resv *hjob)
+{
+	preempt_victims *pv;
+	int max_resdefs;
+	int i, j;
+
+	if (policy == NULL || sinfo == NULL || hjob == NULL)
+		return NULL;
+
+	if ((pv = calloc(1, sizeof(preempt_victims))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	/* soft limits are the only thing which changes preemption priorities
+	 * in the middle of a cycle.  Without them, victims sorted by priority
+	 * stay sorted while we simulate preempting them.
+	 */
+	pv->sorted = !sinfo->has_soft_limit;
+	for (i = 0; pv->sorted && sinfo->queues != NULL && sinfo->queues[i] != NULL; i++)
+		if (sinfo->queues[i]->has_soft_limit)
+			pv->sorted = 0;
+
+	/* unsafe to consider vnodes from multivnoded hosts "no good" when "not enough" of some consumable
+	 * resource can be found in the vnode, since rest may be provided by other vnodes on the same host
+	 * restrict check on these vnodes to check only against non consumable resources
+	 */
+	max_resdefs = count_array((void **) policy->resdef_to_check);
+	if (max_resdefs > 0) {
+		pv->rdtc_non_consumable = calloc(max_resdefs + 1, sizeof(resdef *));
+		if (pv->rdtc_non_consumable == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free_preempt_victims(pv);
+			return NULL;
+		}
+		for (i = 0, j = 0; policy->resdef_to_check[i] != NULL; i++)
+			if (policy->resdef_to_check[i]->type.is_non_consumable)
+				pv->rdtc_non_consumable[j++] = policy->resdef_to_check[i];
+	}
+
+	if (sinfo->node_index == NULL || sinfo->node_index->num_nodes <= 0)
+		return pv;
+
+	pv->num_nodes = sinfo->node_index->num_nodes;
+	pv->node_fit = calloc(pv->num_nodes, sizeof(char));
+	pv->hjob_nodes = calloc(pv->num_nodes, sizeof(char));
+	if (pv->node_fit == NULL || pv->hjob_nodes == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_preempt_victims(pv);
+		return NULL;
+	}
+
+	/* if one of the vnodes isn't in the index, we fall back on ranks */
+	if (hjob->ninfo_arr != NULL) {
+		for (i = 0; hjob->ninfo_arr[i] != NULL; i++) {
+			j = preempt_node_ind(pv, hjob->ninfo_arr[i]);
+			if (j < 0) {
+				free(pv->hjob_nodes);
+				pv->hjob_nodes = NULL;
+				break;
+			}
+			pv->hjob_nodes[j] = 1;
+		}
+	}
+
+	return pv;
+}
+
+/**
+ * @brief
+ *		free_preempt_victims - free a victim search
+ *
+ * @param[in,out] pv - the victim search to free
+ *
+ * @return nothing
+ */
+void
+free_preempt_victims(preempt_victims *pv)
+{
+	if (pv == NULL)
+		return;
+
+	free(pv->node_fit);
+	free(pv->hjob_nodes);
+	free(pv->rdtc_non_consumable);
+	free(pv);
+}
+
+/**
+ * @brief
+ *		preempt_node_fit - can a vnode hold at least one chunk of the high
+ *		priority job if everything running on it was preempted?  The answer
+ *		only depends on the total resources of the vnode, so it's kept for
+ *		the vnodes of the universe for the rest of the victim search.
+ *
+ * @param[in] pv - the victim search
+ * @param[in] hjob - the high priority job to preempt for
+ * @param[in] node - the vnode
+ * @param[in] err - scratch error structure
+ *
+ * @return int
+ * @retval 1 : the vnode can hold a chunk of hjob
+ * @retval 0 : it can't
+ */
+static int
+preempt_node_fit(preempt_victims *pv, resource_resv *hjob, node_info *node,
+	schd_error *err)
+{
+	resdef **rdtc_here = NULL; /* at first assume all resources (including consumables) need to be checked */
+	long num_chunks_returned;
+	int cached = 0;
+	int fit = 0;
+	int k;
+
+	/* reservation vnodes aren't in the index: their resources are different */
+	if (node->node_ind >= 0 && node->node_ind < pv->num_nodes) {
+		if (pv->node_fit[node->node_ind] != PV_NODE_UNKNOWN)
+			return pv->node_fit[node->node_ind] == PV_NODE_FIT;
+		cached = 1;
+	}
+
+	if (node->is_multivnoded)
+		rdtc_here = pv->rdtc_non_consumable;
+
+	for (k = 0; hjob->select->chunks[k] != NULL && !fit; k++) {
+		/* if only non consumables are checked, infinite number of chunks can be satisfied,
+		 * and SCHD_INFINITY is negative, so don't be tempted to check on positive value
+		 */
+		clear_schd_error(err);
+		num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
+					COMPARE_TOTAL | CHECK_ALL_BOOLS | UNSET_RES_ZERO,
+					rdtc_here, INSUFFICIENT_RESOURCE, err);
+		if ((num_chunks_returned > 0) || (num_chunks_returned == SCHD_INFINITY))
+			fit = 1;
+	}
+
+	if (cached)
+		pv->node_fit[node->node_ind] = fit ? PV_NODE_FIT : PV_NODE_NOFIT;
+
+	return fit;
+}
+
 /**
  * @brief
  *		select a good candidate for preemption
@@ -2800,6 +3671,9 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
  * @param[in] err    - reason the high prio job isn't running
  * @param[in] fail_list - list of jobs to skip. They previously failed to be preempted.
  *			  Do not select them again.
+ * @param[in] pv - the victim search of hjob (see new_preempt_victims())
+ *		   if it is sorted, rjobs has to be in ascending preempt priority
+ *		   NULL to set one up for this call only
  *
  * @return long
  * @retval index of the job to preempt
@@ -2809,14 +3683,14 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 long
 select_index_to_preempt(status *policy, resource_resv *hjob,
 	resource_resv **rjobs, long skipto, schd_error *err,
-	int *fail_list)
+	int *fail_list, preempt_victims *pv)
 {
 	int i, j, k;
 	resource_req *req;
 	int good=1, certainlygood=0;		/* good boolean: Is job eligible to be preempted */
 	struct preempt_ordering *po;
 	resource_req *req2;
-	resdef **rdtc_non_consumable = NULL;
+	preempt_victims *tmp_pv = NULL;
 	char *limitres_name = NULL;
 	int limitres_injob=1;
 	resource_req *req_scan;
@@ -2864,8 +3738,20 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 	}
 
 	/* This shouldn't happen, but you can never be too paranoid */
-	if (hjob->job->is_running && hjob->ninfo_arr == NULL)
+	if (hjob->job->is_running && hjob->ninfo_arr == NULL) {
+		free(limitres_name);
 		return NO_JOB_FOUND;
+	}
+
+	if (pv == NULL) {
+		if ((tmp_pv = new_preempt_victims(policy, hjob->server, hjob)) == NULL) {
+			free(limitres_name);
+			return ERR_IN_SELECT;
+		}
+		/* we don't know if rjobs is sorted */
+		tmp_pv->sorted = 0;
+		pv = tmp_pv;
+	}
 
 	/* if we find a good job, we'll break out at the bottom
 	 * we can't break out up here since i will be incremented by this point
@@ -2876,6 +3762,13 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 		int node_good = 1;
 		int svr_res_good = 1;
 
+		/* the rest of the jobs have at least our preemption priority */
+		if (pv->sorted && rjobs[i]->job != NULL &&
+			rjobs[i]->job->preempt >= hjob->job->preempt) {
+			good = 0;
+			break;
+		}
+
 		/* lets be optimistic.. we'll start off assuming this is a good candidate */
 		good = 1;
 		certainlygood = 0;
@@ -3075,17 +3968,30 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 
 		if (good && !certainlygood) {
 			if (hjob->ninfo_arr != NULL) {
-				for (j = 0; hjob->ninfo_arr[j] != NULL; j++) {
-					if (find_node_by_rank(rjobs[i]->ninfo_arr,
-						hjob->ninfo_arr[j]->rank) != NULL)
-						break;
+				int on_hjob_nodes = 0;
+
+				if (pv->hjob_nodes != NULL) {
+					for (j = 0; rjobs[i]->ninfo_arr[j] != NULL && !on_hjob_nodes; j++) {
+						k = preempt_node_ind(pv, rjobs[i]->ninfo_arr[j]);
+						if (k >= 0)
+							on_hjob_nodes = pv->hjob_nodes[k];
+						else if (find_node_by_rank(hjob->ninfo_arr,
+							rjobs[i]->ninfo_arr[j]->rank) != NULL)
+							on_hjob_nodes = 1;
+					}
+				} else {
+					for (j = 0; hjob->ninfo_arr[j] != NULL && !on_hjob_nodes; j++) {
+						if (find_node_by_rank(rjobs[i]->ninfo_arr,
+							hjob->ninfo_arr[j]->rank) != NULL)
+							on_hjob_nodes = 1;
+					}
 				}
 
 				/* if we made all the way through the list, then rjobs[i] has no useful
 				 * nodes for us to use... don't select it, unless it's not node resources we're after
 				 */
 
-				if (hjob->ninfo_arr[j] == NULL) {
+				if (!on_hjob_nodes) {
 					good = 0;
 					svr_res_good = 0;
 					for (req = hjob->resreq; req != NULL; req = req->next) {
@@ -3107,61 +4013,20 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 					certainlygood = 1;
 			}
 		}
-		if (good) {
+		/* whether the job is certainly good doesn't depend on its vnodes */
+		if (good && !certainlygood) {
 			schd_error *err;
 			node_good = 0;
 
 			err = new_schd_error();
-			if(err == NULL)
+			if(err == NULL) {
+				free_preempt_victims(tmp_pv);
+				free(limitres_name);
 				return NO_JOB_FOUND;
-
-			for (j = 0; rjobs[i]->ninfo_arr[j] != NULL && !node_good; j++) {
-				resdef **check_resdef = NULL;
-				resdef **rdtc_here = NULL; /* at first assume all resources (including consumables) need to be checked */
-				node_info *node = rjobs[i]->ninfo_arr[j];
-				if (node->is_multivnoded) {
-					/* unsafe to consider vnodes from multivnoded hosts "no good" when "not enough" of some consumable
-					 * resource can be found in the vnode, since rest may be provided by other vnodes on the same host
-					 * restrict check on these vnodes to check only against non consumable resources
-					 */
-					if (rdtc_non_consumable == NULL) {
-						long max_resdefs = 0;
-						if (policy != NULL) {
-							max_resdefs = count_array( (void **) policy->resdef_to_check);
-						}
-						if (max_resdefs > 0)    {
-							rdtc_non_consumable = (resdef **) calloc(sizeof(resdef *),(size_t) max_resdefs + 1);
-							if (rdtc_non_consumable != NULL) {
-								long resdef_index = 0;
-								long rdtc_nc_index = 0;
-								for (; policy->resdef_to_check[resdef_index] != NULL; resdef_index++) {
-									if (policy->resdef_to_check[resdef_index]->type.is_non_consumable) {
-										rdtc_non_consumable[rdtc_nc_index] = policy->resdef_to_check[resdef_index];
-										rdtc_nc_index++;
-									}
-									rdtc_non_consumable[rdtc_nc_index] = NULL;
-								}
-							}
-						}
-					}
-					rdtc_here = rdtc_non_consumable;
-				}
-				for (k = 0; hjob->select->chunks[k] != NULL; k++) {
-					long num_chunks_returned = 0;
-					/* if only non consumables are checked, infinite number of chunks can be satisfied,
-					 * and SCHD_INFINITY is negative, so don't be tempted to check on positive value
-					 */
-					clear_schd_error(err);
-					num_chunks_returned = check_avail_resources(node->res, hjob->select->chunks[k]->req,
-								COMPARE_TOTAL | CHECK_ALL_BOOLS | UNSET_RES_ZERO,
-								rdtc_here, INSUFFICIENT_RESOURCE, err); 
-					if ( (num_chunks_returned > 0) || (num_chunks_returned == SCHD_INFINITY) ) {
-						node_good = 1;
-						break;
-					}
-
-				}
 			}
+
+			for (j = 0; rjobs[i]->ninfo_arr[j] != NULL && !node_good; j++)
+				node_good = preempt_node_fit(pv, hjob, rjobs[i]->ninfo_arr[j], err);
 			free_schd_error(err);
 
 			if (node_good == 0) {
@@ -3190,8 +4055,7 @@ select_index_to_preempt(status *policy, resource_resv *hjob,
 		if (good || certainlygood)
 			break;
 	}
-	if (rdtc_non_consumable != NULL)
-		free (rdtc_non_consumable);
+	free_preempt_victims(tmp_pv);
 
 	if (limitres_name != NULL)
 		free (limitres_name);
@@ -3618,10 +4482,34 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 	return rresv;
 }
 
+/**
+ * @brief
+ * 		evaluate a math formula for jobs based on their resources.
+ *		The formula is evaluated natively (see formula.c) unless it uses
+ *		something only the embedded python interpreter can evaluate.
+ *
+ * @param[in]	formula	-	formula to evaluate
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ *
+ * @return	evaluated formula answer or 0 on exception
+ *
+ */
+sch_resource_t
+formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
+{
+	sch_resource_t ans;
+
+	if (formula_evaluate_native(formula, resresv, resreq, &ans))
+		return ans;
+
+	return formula_evaluate_python(formula, resresv, resreq);
+}
+
 /**
  * @brief
  * 		evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ *		through the embedded python interpreter
  *
  * @param[in]	formula	-	formula to evaluate
  * @param[in]	resresv	-	job for special case key words
@@ -3633,9 +4521,8 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 
 #ifdef PYTHON
 sch_resource_t
-formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
+formula_evaluate_python(char *formula, resource_resv *resresv, resource_req *resreq)
 {
-	static char id[] = "formula_evaluate";
 	char buf[1024];
 	char *globals;
 	int globals_size = 1024;  /* initial size... will grow if needed */
@@ -3753,7 +4640,7 @@ formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
 }
 #else
 sch_resource_t
-formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
+formula_evaluate_python(char *formula, resource_resv *resresv, resource_req *resreq)
 {
 	return 0;
 }
@@ -48,6 +48,21 @@ extern "C" {
  */
 resource_resv **query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, char *queue_name);
 
+/*
+ *	begin_job_status_cache - start a new generation of the job status cache
+ */
+void begin_job_status_cache(server_info *sinfo);
+
+/*
+ *	end_job_status_cache - free cached statuses of jobs not seen this cycle
+ */
+void end_job_status_cache(void);
+
+/*
+ *	free_job_status_cache - free the job status cache
+ */
+void free_job_status_cache(void);
+
 /*
  *	query_job - takes info from a batch_status about a job and puts
  */
@@ -79,9 +94,15 @@ int
 update_job_attr(int pbs_sd, resource_resv *resresv, char *attr_name,
 	char *attr_resc, char *attr_value, struct attrl *extra, unsigned int flags );
 
-/* send delayed job attribute updates for job using send_attr_updates() */ 
+/* queue delayed job attribute updates for job to be sent by flush_job_updates() */
 int send_job_updates(int pbs_sd, resource_resv *job);
 
+/* are delayed attribute updates of a job waiting to be sent? */
+int job_updates_queued(resource_resv *job);
+
+/* send queued delayed job attribute updates to the server with pbs_alterjobs() */
+int flush_job_updates(int pbs_sd);
+
 /* send delayed attributes to the server for a job */
 int send_attr_updates(int pbs_sd, char *job_name, struct attrl *pattr);
 
@@ -159,7 +180,20 @@ find_jobs_to_preempt(status *policy, resource_resv *jinfo,
 long
 select_index_to_preempt(status *policy, resource_resv *hjob,
 	resource_resv **rjobs, long skipto, schd_error *err,
-	int *fail_list);
+	int *fail_list, preempt_victims *pv);
+
+/*
+ *      new_preempt_victims - set up the search for preemption victims
+ *                            of a high priority job
+ */
+preempt_victims *
+new_preempt_victims(status *policy, server_info *sinfo, resource_resv *hjob);
+
+/*
+ *      free_preempt_victims - free a victim search
+ */
+void
+free_preempt_victims(preempt_victims *pv);
 
 /*
  *      preempt_level - take a preemption priority and return a preemption
@@ -237,11 +271,17 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 	queue_info *qinfo);
 /*
  *	formula_evaluate - evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ *		NOTE: done natively, falling back to the embedded python interpreter
  */
 
 sch_resource_t formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq);
 
+/*
+ *	formula_evaluate_python - evaluate a math formula for jobs based on their
+ *				  resources through the embedded python interpreter
+ */
+sch_resource_t formula_evaluate_python(char *formula, resource_resv *resresv, resource_req *resreq);
+
 /*
  *
  *      update_accruetype - Updates accrue_type of job on server.
@@ -50,6 +50,8 @@
  * 	lim_setlimits()
  * 	has_hardlimits()
  * 	has_softlimits()
+ * 	lim_signature()
+ * 	lim_kinds()
  * 	new_limcounts()
  * 	free_limcounts()
  * 	make_limcounts()
@@ -278,23 +280,47 @@ check_queue_max_run_soft(server_info *, queue_info *,
 typedef	int	(*limfunc_t)(server_info *, queue_info *, resource_resv *,
 	limcounts *, limcounts *, schd_error *);
 
-static limfunc_t	limfuncs[] = {
-	check_queue_max_group_run,
-	check_queue_max_project_run,
-	check_queue_max_run,
-	check_queue_max_user_run,
-	check_server_max_group_run,
-	check_server_max_project_run,
-	check_server_max_run,
-	check_server_max_user_run,
-	check_queue_max_group_res,
-	check_queue_max_project_res,
-	check_queue_max_res,
-	check_queue_max_user_res,
-	check_server_max_group_res,
-	check_server_max_project_res,
-	check_server_max_res,
-	check_server_max_user_res,
+/**
+ * @brief
+ * 		kinds of hard limits, one bit per entity key type for run limits
+ * 		and one for resource limits.  A limit function is only called
+ * 		when its kind of limit is set on the server or queue it checks.
+ */
+#define	LIM_KIND_RUN(kt)	(1U << (2 * (kt)))
+#define	LIM_KIND_RES(kt)	(1U << (2 * (kt) + 1))
+
+/**
+ * @struct	limfunc_ent
+ * @brief
+ * 		entry in the hard limit function table
+ *
+ * @param[in]	lf_func	-	the limit function
+ * @param[in]	lf_queue	-	1 if the function checks queue limits, 0 for server
+ * @param[in]	lf_kind	-	the kind of limit the function checks
+ */
+struct limfunc_ent {
+	limfunc_t	lf_func;
+	int		lf_queue;
+	unsigned int	lf_kind;
+};
+
+static struct limfunc_ent	limfuncs[] = {
+	{check_queue_max_group_run,	1, LIM_KIND_RUN(LIM_GROUP)},
+	{check_queue_max_project_run,	1, LIM_KIND_RUN(LIM_PROJECT)},
+	{check_queue_max_run,		1, LIM_KIND_RUN(LIM_OVERALL)},
+	{check_queue_max_user_run,	1, LIM_KIND_RUN(LIM_USER)},
+	{check_server_max_group_run,	0, LIM_KIND_RUN(LIM_GROUP)},
+	{check_server_max_project_run,	0, LIM_KIND_RUN(LIM_PROJECT)},
+	{check_server_max_run,		0, LIM_KIND_RUN(LIM_OVERALL)},
+	{check_server_max_user_run,	0, LIM_KIND_RUN(LIM_USER)},
+	{check_queue_max_group_res,	1, LIM_KIND_RES(LIM_GROUP)},
+	{check_queue_max_project_res,	1, LIM_KIND_RES(LIM_PROJECT)},
+	{check_queue_max_res,		1, LIM_KIND_RES(LIM_OVERALL)},
+	{check_queue_max_user_res,	1, LIM_KIND_RES(LIM_USER)},
+	{check_server_max_group_res,	0, LIM_KIND_RES(LIM_GROUP)},
+	{check_server_max_project_res,	0, LIM_KIND_RES(LIM_PROJECT)},
+	{check_server_max_res,		0, LIM_KIND_RES(LIM_OVERALL)},
+	{check_server_max_user_res,	0, LIM_KIND_RES(LIM_USER)},
 };
 
 /**
@@ -376,6 +402,7 @@ static void
 schderr_args_server_res(const char *, const char *,
 	schd_error *);
 static sch_resource_t	lim_get(const char *, void *);
+static unsigned int	lim_kinds(void *);
 static int		lim_setoldlimits(const struct attrl *, void *);
 static int		lim_setreslimits(const struct attrl *, void *);
 static int		lim_setrunlimits(const struct attrl *, void *);
@@ -387,10 +414,14 @@ static int		lim_setrunlimits(const struct attrl *, void *);
  *
  * @param[in]	li_ctxh	-	limit context for storing (hard) resource and run limits
  * @param[in]	li_ctxs	-	limit context for storing (soft) resource and run limits
+ * @param[in]	li_kinds	-	LIM_KIND_* bits of the hard limits in li_ctxh
+ * @param[in]	li_kinds_valid	-	1 if li_kinds is up to date with li_ctxh
  */
 struct limit_info {
-	void	*li_ctxh;
-	void	*li_ctxs;
+	void		*li_ctxh;
+	void		*li_ctxs;
+	unsigned int	li_kinds;
+	int		li_kinds_valid;
 };
 #define	LI2RESCTX(li)		(((struct limit_info *) li)->li_ctxh)
 #define	LI2RESCTXSOFT(li)	(((struct limit_info *) li)->li_ctxs)
@@ -493,6 +524,8 @@ lim_dup_liminfo(void *p)
 			return (NULL);
 		} else
 			LI2RESCTXSOFT(newlip) = ctx;
+		newlip->li_kinds = oldlip->li_kinds;
+		newlip->li_kinds_valid = oldlip->li_kinds_valid;
 
 		/*
 		 *	We currently store both resource and run limits in a
@@ -620,6 +653,7 @@ lim_setlimits(const struct attrl *a, enum limtype lt, void *p)
 {
 	struct limit_info	*lip = p;
 
+	lip->li_kinds_valid = 0;
 	switch (lt) {
 		case LIM_RES:
 			if (is_hardlimit(a))
@@ -708,6 +742,91 @@ has_softlimits(void *p)
 	}
 	return (0);
 }
+/**
+ * @brief
+ * 		fold the hard and soft limits stored in a limit info structure into
+ *		a signature.  Two structures holding the same limits fold in the
+ *		same way.
+ *
+ * @param[in]	p	-	limit info structure
+ * @param[in]	sig	-	signature so far
+ *
+ * @return	unsigned long long
+ * @retval	new signature
+ */
+unsigned long long
+lim_signature(void *p, unsigned long long sig)
+{
+	struct limit_info	*lip = p;
+	pbs_entlim_key_t	*k = NULL;
+
+	if (lip == NULL)
+		return sig;
+
+	/* run limits share the resource limit contexts */
+	while ((k = entlim_get_next(k, LI2RESCTX(lip))) != NULL) {
+		sig = hash_str(sig, k->key);
+		sig = hash_str(sig, k->recptr);
+	}
+	sig = hash_str(sig, "soft");
+	while ((k = entlim_get_next(k, LI2RESCTXSOFT(lip))) != NULL) {
+		sig = hash_str(sig, k->key);
+		sig = hash_str(sig, k->recptr);
+	}
+
+	return sig;
+}
+/**
+ * @brief
+ * 		return the kinds of hard limits stored in a limit info structure.
+ *		The kinds are found by walking the limit keys once and are kept
+ *		until the limits change.
+ *
+ * @param[in,out]	p	-	limit info structure
+ *
+ * @return	unsigned int
+ * @retval	LIM_KIND_* bits of the hard limits set
+ */
+static unsigned int
+lim_kinds(void *p)
+{
+	struct limit_info	*lip = p;
+	pbs_entlim_key_t	*k = NULL;
+	enum lim_keytypes	kt;
+
+	if (lip == NULL)
+		return 0;
+	if (lip->li_kinds_valid)
+		return lip->li_kinds;
+
+	lip->li_kinds = 0;
+	while ((k = entlim_get_next(k, LI2RESCTX(lip))) != NULL) {
+		switch (k->key[0]) {
+			case 'u':
+				kt = LIM_USER;
+				break;
+			case 'g':
+				kt = LIM_GROUP;
+				break;
+			case 'p':
+				kt = LIM_PROJECT;
+				break;
+			case 'o':
+				kt = LIM_OVERALL;
+				break;
+			default:
+				continue;
+		}
+		/* resource limit keys are of the form "u:entity;resource" */
+		if (strchr(k->key, ';') != NULL)
+			lip->li_kinds |= LIM_KIND_RES(kt);
+		else
+			lip->li_kinds |= LIM_KIND_RUN(kt);
+	}
+	lip->li_kinds_valid = 1;
+
+	return lip->li_kinds;
+}
 /**
  * @brief
  *		create a new limit count structure and initialize it.
@@ -819,9 +938,13 @@ make_limcounts(counts *user, counts *group, counts *project, counts *all)
 int
 check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err, unsigned int flags)
 {
-	int	rc;
+	int	rc = 0;
 	int	any_fail_rc = 0;
 	int	i;
+	unsigned int svr_kinds;
+	unsigned int que_kinds;
+	limcounts svr_live;
+	limcounts que_live;
 	limcounts *svr_counts = NULL;
 	limcounts *que_counts = NULL;
 	limcounts *svr_counts_max = NULL;
@@ -840,6 +963,12 @@ check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err
 	if (si == NULL || qi == NULL || rr == NULL)
 		return 0;
 
+	/* nothing to do if neither the server nor the queue has hard limits */
+	svr_kinds = lim_kinds(si->liminfo);
+	que_kinds = lim_kinds(qi->liminfo);
+	if (svr_kinds == 0 && que_kinds == 0)
+		return 0;
+
 	/*
 	 * Check for  CHECK_CUMULATIVE_LIMIT is needed because we  must have
 	 * already run through the same loop before while calling check_limits
@@ -1040,52 +1169,52 @@ check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err
 		}
 
 	}
+	/*
+	 * The limit functions only read the counts, so unless the calendar
+	 * made us a copy to work with, point them at the live counts rather
+	 * than duplicating every count list for every job we check.
+	 */
 	if ((flags & CHECK_LIMIT)) {
 		if (svr_counts_max != NULL) {
 			server_lim = svr_counts_max;
 		}
 		else {
-			server_lim = make_limcounts(si->user_counts,
-				si->group_counts,
-				si->project_counts,
-				si->alljobcounts);
-			if (server_lim == NULL)
-				return 0;
+			svr_live.user = si->user_counts;
+			svr_live.group = si->group_counts;
+			svr_live.project = si->project_counts;
+			svr_live.all = si->alljobcounts;
+			server_lim = &svr_live;
 		}
 		if (que_counts_max != NULL) {
 			queue_lim = que_counts_max;
 		}
 		else {
-			queue_lim = make_limcounts(qi->user_counts,
-				qi->group_counts,
-				qi->project_counts,
-				qi->alljobcounts);
-			if (queue_lim == NULL) {
-				free_limcounts(server_lim);
-				return 0;
-			}
+			que_live.user = qi->user_counts;
+			que_live.group = qi->group_counts;
+			que_live.project = qi->project_counts;
+			que_live.all = qi->alljobcounts;
+			queue_lim = &que_live;
 		}
 	}
 	else if ((flags & CHECK_CUMULATIVE_LIMIT)) {
 		if (!si->has_hard_limit && !qi->has_hard_limit)
 			return 0;
-		server_lim = make_limcounts(si->total_user_counts,
-			si->total_group_counts,
-			si->total_project_counts,
-			si->total_alljobcounts);
-		if (server_lim == NULL)
-			return 0;
-		queue_lim = make_limcounts(qi->total_user_counts,
-			qi->total_group_counts,
-			qi->total_project_counts,
-			qi->total_alljobcounts);
-		if (queue_lim == NULL) {
-			free_limcounts(server_lim);
-			return 0;
-		}
+		svr_live.user = si->total_user_counts;
+		svr_live.group = si->total_group_counts;
+		svr_live.project = si->total_project_counts;
+		svr_live.all = si->total_alljobcounts;
+		server_lim = &svr_live;
+		que_live.user = qi->total_user_counts;
+		que_live.group = qi->total_group_counts;
+		que_live.project = qi->total_project_counts;
+		que_live.all = qi->total_alljobcounts;
+		queue_lim = &que_live;
 	}
 	for (i = 0; i < sizeof(limfuncs) / sizeof(limfuncs[0]); i++) {
-		if ((rc = (limfuncs[i])(si, qi, rr, server_lim,
+		/* skip functions whose kind of limit isn't set */
+		if (!(limfuncs[i].lf_kind & (limfuncs[i].lf_queue ? que_kinds : svr_kinds)))
+			continue;
+		if ((rc = (limfuncs[i].lf_func)(si, qi, rr, server_lim,
 		queue_lim, err)) != 0) {
 			if ((flags & RETURN_ALL_ERR)) {
 				if (any_fail_rc == 0)
@@ -1095,8 +1224,8 @@ check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err
 				prev_err = err;
 				err = err->next;
 				if(err == NULL) {
-					free_limcounts(server_lim);
-					free_limcounts(queue_lim);
+					free_limcounts(svr_counts_max);
+					free_limcounts(que_counts_max);
 					return SCHD_ERROR;
 				}
 			} else {
@@ -1106,8 +1235,8 @@ check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err
 		}
 	}
 
-	free_limcounts(server_lim);
-	free_limcounts(queue_lim);
+	free_limcounts(svr_counts_max);
+	free_limcounts(que_counts_max);
 	
 	if (flags & RETURN_ALL_ERR) {
 		if (prev_err != NULL) {
@@ -84,6 +84,14 @@
  * 		res_to_str_c()
  * 		res_to_str_r()
  * 		res_to_str_re()
+ * 		hash_bytes()
+ * 		hash_str()
+ * 		new_obj_index()
+ * 		free_obj_index()
+ * 		clear_obj_index()
+ * 		update_obj_index()
+ * 		find_obj_index_by_name()
+ * 		find_obj_index_by_rank()
  *
  */
 #include <pbs_config.h>
@@ -1780,3 +1788,302 @@ res_to_str_re(void *p, enum resource_fields fld, char **buf,
 		return "";
 	return *buf;
 }
+
+/**
+ * @brief
+ * 		fold a buffer into a hash (64 bit FNV-1a).  Used to build signatures
+ *		which tell if the inputs to a check have changed between cycles.
+ *		Start with HASH_INIT.
+ *
+ * @param[in]	hash	-	hash so far
+ * @param[in]	buf	-	buffer to fold in
+ * @param[in]	len	-	length of buf
+ *
+ * @return	unsigned long long
+ * @retval	new hash
+ */
+unsigned long long
+hash_bytes(unsigned long long hash, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief
+ * 		fold a string into a hash.  A NULL string and an empty string
+ *		hash differently.
+ *
+ * @param[in]	hash	-	hash so far
+ * @param[in]	str	-	string to fold in (may be NULL)
+ *
+ * @return	unsigned long long
+ * @retval	new hash
+ */
+unsigned long long
+hash_str(unsigned long long hash, const char *str)
+{
+	if (str == NULL)
+		return hash_bytes(hash, "\377", 1);
+
+	/* include the terminating NUL so "ab","c" differs from "a","bc" */
+	return hash_bytes(hash, str, strlen(str) + 1);
+}
+
+/**
+ * @brief
+ * 		create an index of a NULL terminated array of objects by name and
+ *		by rank.  The index is filled in as it is searched.  It can only
+ *		be used for arrays which are added to at the end and never have
+ *		objects removed, like the arrays of the server.  An array may be
+ *		reordered, as long as the index is brought up to date with
+ *		update_obj_index() first.
+ *
+ * @param[in]	name_off	-	offset of the char *name member of the objects
+ * @param[in]	rank_off	-	offset of the int rank member of the objects or
+ *								OBJ_INDEX_NO_RANK
+ *
+ * @return	obj_index *
+ * @retval	new index
+ * @retval	NULL	: on error
+ */
+obj_index *
+new_obj_index(size_t name_off, size_t rank_off)
+{
+	obj_index *idx;
+
+	if ((idx = calloc(1, sizeof(obj_index))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	idx->name_off = name_off;
+	idx->rank_off = rank_off;
+
+	return idx;
+}
+
+/**
+ * @brief
+ * 		free an object index
+ *
+ * @param[in]	idx	-	index to free
+ *
+ * @return	void
+ */
+void
+free_obj_index(obj_index *idx)
+{
+	if (idx == NULL)
+		return;
+
+	free(idx->name_slots);
+	free(idx->rank_slots);
+	free(idx);
+}
+
+/**
+ * @brief
+ * 		empty an object index so it can be used for a new array
+ *
+ * @param[in]	idx	-	index to empty
+ *
+ * @return	void
+ */
+void
+clear_obj_index(obj_index *idx)
+{
+	if (idx == NULL)
+		return;
+
+	if (idx->size > 0) {
+		memset(idx->name_slots, 0, idx->size * sizeof(void *));
+		if (idx->rank_slots != NULL)
+			memset(idx->rank_slots, 0, idx->size * sizeof(void *));
+	}
+	idx->count = 0;
+}
+
+/**
+ * @brief
+ * 		add an object to an index.  If another object with the same name or
+ *		rank is already in the index, it is kept so searches find the
+ *		object which was added to the array first.
+ *
+ * @param[in]	idx	-	the index
+ * @param[in]	obj	-	the object to add
+ *
+ * @return	void
+ */
+static void
+add_obj_index(obj_index *idx, void *obj)
+{
+	unsigned int mask = idx->size - 1;
+	unsigned int slot;
+	char *name;
+	int rank;
+
+	name = OBJ_INDEX_NAME(idx, obj);
+	if (name != NULL) {
+		for (slot = hash_str(HASH_INIT, name) & mask; idx->name_slots[slot] != NULL;
+			slot = (slot + 1) & mask)
+			if (!strcmp(OBJ_INDEX_NAME(idx, idx->name_slots[slot]), name))
+				break;
+		if (idx->name_slots[slot] == NULL)
+			idx->name_slots[slot] = obj;
+	}
+
+	if (idx->rank_slots != NULL) {
+		rank = OBJ_INDEX_RANK(idx, obj);
+		for (slot = hash_bytes(HASH_INIT, &rank, sizeof(rank)) & mask;
+			idx->rank_slots[slot] != NULL; slot = (slot + 1) & mask)
+			if (OBJ_INDEX_RANK(idx, idx->rank_slots[slot]) == rank)
+				break;
+		if (idx->rank_slots[slot] == NULL)
+			idx->rank_slots[slot] = obj;
+	}
+}
+
+/**
+ * @brief
+ * 		bring an object index up to date with the objects added to the end
+ *		of its array since it was last searched.  If this fails, the index
+ *		is emptied and will be rebuilt by the next search.
+ *
+ * @param[in]	idx	-	the index
+ * @param[in]	arr	-	the indexed array
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: on error
+ */
+int
+update_obj_index(obj_index *idx, void **arr)
+{
+	void **name_slots;
+	void **rank_slots = NULL;
+	int size;
+	int i;
+
+	if (idx == NULL || arr == NULL)
+		return 0;
+
+	for (i = idx->count; arr[i] != NULL; i++) {
+		/* keep the tables at most half full */
+		if ((i + 1) * 2 > idx->size) {
+			for (size = idx->size > 0 ? idx->size * 2 : 64; size < (i + 1) * 2; size *= 2)
+				;
+			name_slots = calloc(size, sizeof(void *));
+			if (name_slots != NULL && idx->rank_off != OBJ_INDEX_NO_RANK)
+				rank_slots = calloc(size, sizeof(void *));
+			if (name_slots == NULL ||
+				(idx->rank_off != OBJ_INDEX_NO_RANK && rank_slots == NULL)) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				free(name_slots);
+				clear_obj_index(idx);
+				return 0;
+			}
+			free(idx->name_slots);
+			free(idx->rank_slots);
+			idx->name_slots = name_slots;
+			idx->rank_slots = rank_slots;
+			idx->size = size;
+			for (idx->count = 0; idx->count < i; idx->count++)
+				add_obj_index(idx, arr[idx->count]);
+		}
+		add_obj_index(idx, arr[i]);
+		idx->count = i + 1;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		find the first object in an indexed array by name
+ *
+ * @param[in]	idx	-	the index of arr
+ * @param[in]	arr	-	the indexed array
+ * @param[in]	name	-	name to find
+ * @param[out]	obj	-	the object found or NULL if there is none
+ *
+ * @return	int
+ * @retval	1	: the index was searched
+ * @retval	0	: the index could not be used, search arr instead
+ */
+int
+find_obj_index_by_name(obj_index *idx, void **arr, const char *name, void **obj)
+{
+	unsigned int mask;
+	unsigned int slot;
+
+	if (idx == NULL || arr == NULL || name == NULL || obj == NULL)
+		return 0;
+
+	if (!update_obj_index(idx, arr))
+		return 0;
+
+	*obj = NULL;
+	if (idx->size == 0)
+		return 1;
+
+	mask = idx->size - 1;
+	for (slot = hash_str(HASH_INIT, name) & mask; idx->name_slots[slot] != NULL;
+		slot = (slot + 1) & mask) {
+		if (!strcmp(OBJ_INDEX_NAME(idx, idx->name_slots[slot]), name)) {
+			*obj = idx->name_slots[slot];
+			break;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		find the first object in an indexed array by rank
+ *
+ * @param[in]	idx	-	the index of arr
+ * @param[in]	arr	-	the indexed array
+ * @param[in]	rank	-	rank to find
+ * @param[out]	obj	-	the object found or NULL if there is none
+ *
+ * @return	int
+ * @retval	1	: the index was searched
+ * @retval	0	: the index could not be used, search arr instead
+ */
+int
+find_obj_index_by_rank(obj_index *idx, void **arr, int rank, void **obj)
+{
+	unsigned int mask;
+	unsigned int slot;
+
+	if (idx == NULL || arr == NULL || obj == NULL ||
+		idx->rank_off == OBJ_INDEX_NO_RANK)
+		return 0;
+
+	if (!update_obj_index(idx, arr))
+		return 0;
+
+	*obj = NULL;
+	if (idx->size == 0)
+		return 1;
+
+	mask = idx->size - 1;
+	for (slot = hash_bytes(HASH_INIT, &rank, sizeof(rank)) & mask;
+		idx->rank_slots[slot] != NULL; slot = (slot + 1) & mask) {
+		if (OBJ_INDEX_RANK(idx, idx->rank_slots[slot]) == rank) {
+			*obj = idx->rank_slots[slot];
+			break;
+		}
+	}
+
+	return 1;
+}
@@ -314,6 +314,24 @@ add_str_to_array(char ***str_arr, char *str);
 int 
 add_str_to_unique_array(char ***str_arr, char *str);
 
+/*
+ * fold a buffer or a string into a hash (see HASH_INIT)
+ */
+unsigned long long
+hash_bytes(unsigned long long hash, const void *buf, size_t len);
+unsigned long long
+hash_str(unsigned long long hash, const char *str);
+
+/*
+ * index a NULL terminated array of objects by name and rank
+ */
+obj_index *new_obj_index(size_t name_off, size_t rank_off);
+void free_obj_index(obj_index *idx);
+void clear_obj_index(obj_index *idx);
+int update_obj_index(obj_index *idx, void **arr);
+int find_obj_index_by_name(obj_index *idx, void **arr, const char *name, void **obj);
+int find_obj_index_by_rank(obj_index *idx, void **arr, int rank, void **obj);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -53,6 +53,7 @@
  * 	add_node_state()
  * 	talk_with_mom()
  * 	node_filter()
+ * 	find_node_array_index()
  * 	find_node_info()
  * 	find_node_by_host()
  * 	dup_nodes()
@@ -78,6 +79,11 @@
  * 	eval_simple_selspec()
  * 	is_vnode_eligible()
  * 	is_vnode_eligible_chunk()
+ * 	node_eval_range()
+ * 	node_eval_worker()
+ * 	start_node_eval_pool()
+ * 	stop_node_eval_pool()
+ * 	eval_vnodes_eligible_chunk()
  * 	resources_avail_on_vnode()
  * 	check_resources_for_node()
  * 	parse_placespec()
@@ -122,6 +128,8 @@
 #include <errno.h>
 #include <math.h>
 #include <errno.h>
+#include <signal.h>
+#include <pthread.h>
 #include <pbs_ifl.h>
 #include <log.h>
 #include <rm.h>
@@ -144,6 +152,9 @@
 #include "pbs_internal.h"
 #include "server_info.h"
 #include "pbs_share.h"
+#include "node_res_index.h"
+#include "snapshot.h"
+#include "trace.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -152,6 +163,35 @@
 /* name of the last node a job ran on - used in smp_dist = round robin */
 static char last_node_name[PBS_MAXSVRJOBID];
 
+/* values of the eligibility array filled in by eval_vnodes_eligible_chunk() */
+#define NODE_EVAL_UNKNOWN	0
+#define NODE_EVAL_ELIGIBLE	1
+#define NODE_EVAL_INELIGIBLE	2
+
+/* worker threads used to check vnode eligibility for a chunk in parallel */
+static struct node_eval_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;	/* signaled when new work is posted */
+	pthread_cond_t done_cond;	/* signaled when the last worker finishes */
+	pthread_t *threads;
+	int nthreads;
+	int shutdown;
+	unsigned long generation;	/* bumped each time work is posted */
+	int active;			/* workers not done with this generation */
+
+	/* the work currently posted */
+	node_info **ninfo_arr;
+	resource_req *specreq;
+	resource_resv *resresv;
+	char *eligible;
+	int next;			/* next vnode index to hand out */
+	int end;			/* one past the last vnode index */
+} node_eval_pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER
+};
+
 /**
  * @brief
  *      query_nodes - query all the nodes associated with a server
@@ -175,7 +215,9 @@ query_nodes(int pbs_sd, server_info *sinfo)
 	int i;
 
 	/* get nodes from PBS server */
-	if ((nodes = pbs_statvnode(pbs_sd, NULL, NULL, NULL)) == NULL) {
+	nodes = pbs_statvnode(pbs_sd, NULL, NULL, NULL);
+	snapshot_put(SNAP_VNODE, NULL, nodes);
+	if (nodes == NULL) {
 		err = pbs_geterrmsg(pbs_sd);
 		sprintf(errbuf, "Error getting nodes: %s", err);
 		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "", errbuf);
@@ -473,6 +515,7 @@ new_node_info()
 	new->pcpus = 0;
 
 	new->rank = 0;
+	new->node_ind = -1;
 
 	new->nodesig_ind = -1;
 
@@ -970,6 +1013,27 @@ node_filter(node_info **nodes, int size,
 	return new_nodes;
 }
 
+/**
+ * @brief
+ *		find the server's name and rank index of a node array
+ *
+ * @param[in]	ninfo_arr	-	array of nodes
+ *
+ * @return	obj_index *
+ * @retval	the index if ninfo_arr is the server's nodes array
+ * @retval	NULL	: ninfo_arr has no index
+ */
+static obj_index *
+find_node_array_index(node_info **ninfo_arr)
+{
+	if (ninfo_arr == NULL || ninfo_arr[0] == NULL ||
+		ninfo_arr[0]->server == NULL ||
+		ninfo_arr != ninfo_arr[0]->server->nodes)
+		return NULL;
+
+	return ninfo_arr[0]->server->nodes_idx;
+}
+
 /**
  * @brief
  *		find_node_info - find a node in a node array
@@ -985,10 +1049,15 @@ node_info *
 find_node_info(node_info **ninfo_arr, char *nodename)
 {
 	int i;
+	void *ninfo;
 
 	if (nodename == NULL || ninfo_arr == NULL)
 		return NULL;
 
+	if (find_obj_index_by_name(find_node_array_index(ninfo_arr),
+		(void **) ninfo_arr, nodename, &ninfo))
+		return ninfo;
+
 	for (i = 0; ninfo_arr[i] != NULL &&
 		strcmp(nodename, ninfo_arr[i]->name) ; i++)
 		;
@@ -1198,6 +1267,7 @@ dup_node_info(node_info *onode, server_info *nsinfo,
 	nnode->pcpus = onode->pcpus;
 
 	nnode->rank = onode->rank;
+	nnode->node_ind = onode->node_ind;
 
 	nnode->has_hard_limit = onode->has_hard_limit;
 	nnode->no_multinode_jobs = onode->no_multinode_jobs;
@@ -1737,6 +1807,10 @@ should_talk_with_mom(node_info *ninfo)
 	if (ninfo->is_offline)
 		return 0;
 
+	/* a replayed cycle uses the vnode resources in the snapshot */
+	if (snapshot_replaying())
+		return 0;
+
 	if (conf.dyn_res_to_get != NULL)
 		talk = 1;
 
@@ -2840,6 +2914,15 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	static schd_error *failerr = NULL;
 
+	/* used for parallel vnode evaluation */
+	char *eligible = NULL;	/* per-vnode results from the node eval pool */
+	int num_nodes = 0;
+	int eval_end = 0;	/* vnodes before this index have been checked */
+	int eval_window = 0;	/* number of vnodes to check at a time */
+	int is_eligible;
+
+	unsigned long *node_filter = NULL; /* vnodes which may satisfy the chunk */
+
 
 	/* used for floating licensing */
 	int cur_flt_lic;		/* current number of floating licenses */
@@ -2932,14 +3015,47 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	nsa = *nspec_arr;
 
+	/* With many vnodes to search, check the non-consumable resources of the
+	 * vnodes ahead of the loop below on the node eval pool.  The vnodes are
+	 * checked a window at a time so little work is wasted if the chunk is
+	 * satisfied early.  The loop still walks the vnodes in order.
+	 */
+	if (conf.node_eval_threads > 0 && specreq_noncons != NULL) {
+		num_nodes = count_array((void **) ninfo_arr);
+		if (num_nodes >= NODE_EVAL_MIN_NODES &&
+			start_node_eval_pool(conf.node_eval_threads) > 0) {
+			eval_window = NODE_EVAL_CHUNK * 4 * (conf.node_eval_threads + 1);
+			eligible = calloc(num_nodes, sizeof(char));
+			if (eligible == NULL)
+				log_err(errno, __func__, MEM_ERR_MSG);
+		}
+	}
+
+	/* If the whole chunk has to fit on one vnode, use the server's node
+	 * index to find the vnodes which can never satisfy it.  Once we have the
+	 * error for the first vnode which fails, those vnodes are skipped without
+	 * checking them individually.
+	 */
+	if (!(flags & EVAL_OKBREAK) && resresv->server->node_index != NULL)
+		node_filter = chunk_node_filter(chk, resresv->server->node_index);
+
 	for (i = 0, j = 0; ninfo_arr[i] != NULL && chunks_found == 0; i++) {
 		if (ninfo_arr[i]->nscr.visited || ninfo_arr[i]->nscr.scattered  ||
 			ninfo_arr[i]->nscr.ineligible)
 			continue;
 
+		/* err is left alone so it still holds the last checked vnode's error */
+		if (failerr->status_code != SCHD_UNKWN &&
+			(ninfo_arr[i]->lic_lock || cur_flt_lic > 0) &&
+			!node_in_node_filter(node_filter, ninfo_arr[i])) {
+			ninfo_arr[i]->nscr.visited = 1;
+			continue;
+		}
+
 		allocated = 0;
 		licenses_allocated = 0;
 		clear_schd_error(err);
+		trace_nodes_tested++;
 		if (ninfo_arr[i]->lic_lock || cur_flt_lic > 0) {
 			if (need_new_nspec) {
 				need_new_nspec = 0;
@@ -2951,6 +3067,7 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 						free_resource_req_list(specreq_noncons);
 					if (flags & EVAL_OKBREAK)
 						free_nodes(ninfo_arr);
+					free(eligible);
 					set_schd_error_codes(err, NOT_RUN, SCHD_ERROR);
 					return 0;
 				}
@@ -2960,8 +3077,22 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 				nspecs_allocated++;
 			}
 
-			if (is_vnode_eligible_chunk(specreq_noncons, ninfo_arr[i], resresv,
-					err)) {
+			if (eligible != NULL && i >= eval_end) {
+				eval_end = i + eval_window;
+				if (eval_end > num_nodes)
+					eval_end = num_nodes;
+				eval_vnodes_eligible_chunk(ninfo_arr, i, eval_end,
+					specreq_noncons, resresv, eligible);
+			}
+
+			/* An ineligible vnode is checked again to fill in err */
+			if (eligible != NULL && eligible[i] == NODE_EVAL_ELIGIBLE)
+				is_eligible = 1;
+			else
+				is_eligible = is_vnode_eligible_chunk(specreq_noncons,
+					ninfo_arr[i], resresv, err);
+
+			if (is_eligible) {
 				if (!ninfo_arr[i]->lic_lock) {
 					ncpusreq = find_resource_req(specreq_cons, ncpusdef);
 					if (ncpusreq != NULL)
@@ -3084,6 +3215,8 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	nsa[j] = NULL;
 
+	free(eligible);
+
 	if (specreq_cons != NULL)
 		free_resource_req_list(specreq_cons);
 	if (specreq_noncons != NULL)
@@ -3274,6 +3407,242 @@ is_vnode_eligible_chunk(resource_req *specreq, node_info *node,
 	return 1;
 }
 
+/**
+ * @brief
+ * 		check the non-consumable resources of a range of vnodes from the
+ *		work posted to the node eval pool and record the result in the
+ *		pool's eligibility array.
+ *
+ * @par
+ *		No logging and no error structure is used here so it is safe to
+ *		call from a worker thread.  The error reason for ineligible vnodes
+ *		is recreated by the caller of eval_vnodes_eligible_chunk().
+ *
+ * @param[in]	start	-	first vnode index to check
+ * @param[in]	end	-	one past the last vnode index to check
+ *
+ * @return	void
+ */
+static void
+node_eval_range(int start, int end)
+{
+	node_info *node;
+	int i;
+
+	for (i = start; i < end; i++) {
+		node = node_eval_pool.ninfo_arr[i];
+		if (node->nscr.visited || node->nscr.scattered || node->nscr.ineligible)
+			continue;
+
+		if (is_vnode_eligible_chunk(node_eval_pool.specreq, node,
+			node_eval_pool.resresv, NULL))
+			node_eval_pool.eligible[i] = NODE_EVAL_ELIGIBLE;
+		else
+			node_eval_pool.eligible[i] = NODE_EVAL_INELIGIBLE;
+	}
+}
+
+/**
+ * @brief
+ * 		main loop of a node eval worker thread.  Wait for work to be
+ *		posted and take NODE_EVAL_CHUNK vnodes at a time until there are
+ *		none left.
+ *
+ * @param[in]	arg	-	unused
+ *
+ * @return	NULL
+ */
+static void *
+node_eval_worker(void *arg)
+{
+	unsigned long seen = 0;
+	int start;
+	int end;
+
+	pthread_mutex_lock(&node_eval_pool.lock);
+	while (1) {
+		while (!node_eval_pool.shutdown && node_eval_pool.generation == seen)
+			pthread_cond_wait(&node_eval_pool.work_cond, &node_eval_pool.lock);
+
+		if (node_eval_pool.shutdown)
+			break;
+
+		seen = node_eval_pool.generation;
+		while (node_eval_pool.next < node_eval_pool.end) {
+			start = node_eval_pool.next;
+			end = start + NODE_EVAL_CHUNK;
+			if (end > node_eval_pool.end)
+				end = node_eval_pool.end;
+			node_eval_pool.next = end;
+
+			pthread_mutex_unlock(&node_eval_pool.lock);
+			node_eval_range(start, end);
+			pthread_mutex_lock(&node_eval_pool.lock);
+		}
+
+		node_eval_pool.active--;
+		if (node_eval_pool.active == 0)
+			pthread_cond_signal(&node_eval_pool.done_cond);
+	}
+	pthread_mutex_unlock(&node_eval_pool.lock);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		start the worker threads used to check vnode eligibility in
+ *		parallel.  If the pool is already running with a different
+ *		number of threads, it is restarted.
+ *
+ * @param[in]	nthreads	-	number of worker threads
+ *
+ * @return	int
+ * @retval	number of worker threads running
+ *
+ * @par MT-safe: No
+ */
+int
+start_node_eval_pool(int nthreads)
+{
+	sigset_t allsigs;
+	sigset_t oldsigs;
+	char logbuf[MAX_LOG_SIZE];
+	int i;
+
+	if (nthreads == node_eval_pool.nthreads)
+		return node_eval_pool.nthreads;
+
+	stop_node_eval_pool();
+
+	if (nthreads <= 0)
+		return 0;
+
+	/* These return shared resources which are created on first use.
+	 * Create them now so the workers only ever read them.
+	 */
+	if (false_res() == NULL || zero_res() == NULL || unset_str_res() == NULL)
+		return 0;
+
+	if ((node_eval_pool.threads = calloc(nthreads, sizeof(pthread_t))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+
+	/* signals are handled by the main thread only */
+	sigfillset(&allsigs);
+	pthread_sigmask(SIG_BLOCK, &allsigs, &oldsigs);
+
+	node_eval_pool.shutdown = 0;
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&node_eval_pool.threads[i], NULL,
+			node_eval_worker, NULL) != 0)
+			break;
+		node_eval_pool.nthreads++;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+
+	if (node_eval_pool.nthreads < nthreads) {
+		snprintf(logbuf, sizeof(logbuf),
+			"Only able to start %d of %d node eval threads",
+			node_eval_pool.nthreads, nthreads);
+		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+			__func__, logbuf);
+	}
+
+	return node_eval_pool.nthreads;
+}
+
+/**
+ * @brief
+ * 		stop and join the node eval worker threads
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+stop_node_eval_pool(void)
+{
+	int i;
+
+	if (node_eval_pool.threads == NULL)
+		return;
+
+	pthread_mutex_lock(&node_eval_pool.lock);
+	node_eval_pool.shutdown = 1;
+	pthread_cond_broadcast(&node_eval_pool.work_cond);
+	pthread_mutex_unlock(&node_eval_pool.lock);
+
+	for (i = 0; i < node_eval_pool.nthreads; i++)
+		pthread_join(node_eval_pool.threads[i], NULL);
+
+	free(node_eval_pool.threads);
+	node_eval_pool.threads = NULL;
+	node_eval_pool.nthreads = 0;
+	node_eval_pool.shutdown = 0;
+}
+
+/**
+ * @brief
+ * 		check the non-consumable resources of the vnodes
+ *		ninfo_arr[start] through ninfo_arr[end - 1] against a chunk using
+ *		the node eval pool.  The calling thread works along with the
+ *		workers and returns once all the vnodes have been checked.
+ *
+ * @par
+ *		Each vnode's result only depends on that vnode, so the results
+ *		are the same as checking the vnodes one by one in order.  Vnodes
+ *		which are visited, scattered or ineligible are left
+ *		NODE_EVAL_UNKNOWN.
+ *
+ * @param[in]	ninfo_arr	-	the vnodes being searched
+ * @param[in]	start	-	first vnode index to check
+ * @param[in]	end	-	one past the last vnode index to check
+ * @param[in]	specreq	-	non-consumable resources from the chunk
+ * @param[in]	resresv	-	the job/resv the chunk is from
+ * @param[out]	eligible	-	per-vnode result indexed like ninfo_arr
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+eval_vnodes_eligible_chunk(node_info **ninfo_arr, int start, int end,
+	resource_req *specreq, resource_resv *resresv, char *eligible)
+{
+	int cur_start;
+	int cur_end;
+
+	pthread_mutex_lock(&node_eval_pool.lock);
+	node_eval_pool.ninfo_arr = ninfo_arr;
+	node_eval_pool.specreq = specreq;
+	node_eval_pool.resresv = resresv;
+	node_eval_pool.eligible = eligible;
+	node_eval_pool.next = start;
+	node_eval_pool.end = end;
+	node_eval_pool.active = node_eval_pool.nthreads;
+	node_eval_pool.generation++;
+	pthread_cond_broadcast(&node_eval_pool.work_cond);
+
+	while (node_eval_pool.next < node_eval_pool.end) {
+		cur_start = node_eval_pool.next;
+		cur_end = cur_start + NODE_EVAL_CHUNK;
+		if (cur_end > node_eval_pool.end)
+			cur_end = node_eval_pool.end;
+		node_eval_pool.next = cur_end;
+
+		pthread_mutex_unlock(&node_eval_pool.lock);
+		node_eval_range(cur_start, cur_end);
+		pthread_mutex_lock(&node_eval_pool.lock);
+	}
+
+	while (node_eval_pool.active > 0)
+		pthread_cond_wait(&node_eval_pool.done_cond, &node_eval_pool.lock);
+	pthread_mutex_unlock(&node_eval_pool.lock);
+}
+
 /**
  * @brief
  * 		check to see if there are enough
@@ -5098,9 +5467,15 @@ node_info *
 find_node_by_rank(node_info **ninfo_arr, int rank)
 {
 	int i;
+	void *ninfo;
+
 	if (ninfo_arr == NULL)
 		return NULL;
 
+	if (find_obj_index_by_rank(find_node_array_index(ninfo_arr),
+		(void **) ninfo_arr, rank, &ninfo))
+		return ninfo;
+
 	for (i = 0; ninfo_arr[i] != NULL && ninfo_arr[i]->rank != rank; i++)
 		;
 
@@ -422,6 +422,16 @@ is_vnode_eligible(node_info *node, resource_resv *resresv,
 int is_vnode_eligible_chunk(resource_req *specreq, node_info *node,
 		resource_resv *resresv, schd_error *err);
 
+/* start the threads used to check vnode eligibility in parallel */
+int start_node_eval_pool(int nthreads);
+
+/* stop the threads used to check vnode eligibility in parallel */
+void stop_node_eval_pool(void);
+
+/* check the non-consumable resources of a range of vnodes in parallel */
+void eval_vnodes_eligible_chunk(node_info **ninfo_arr, int start, int end,
+	resource_req *specreq, resource_resv *resresv, char *eligible);
+
 /*
  *	resources_avail_on_vnode - check to see if there are enough
  *				consuable resources on a vnode to make it
@@ -62,6 +62,7 @@
  * 	resresv_can_fit_nodepart()
  * 	create_specific_nodepart()
  * 	create_placement_sets()
+ * 	free_np_layout_cache()
  *
  */
 #include <pbs_config.h>
@@ -69,12 +70,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
 #include "errno.h"
 
 #include <log.h>
 #include <pbs_ifl.h>
 #include <pbs_internal.h>
+#include <pbs_entlim.h>
 #include "config.h"
 #include "constant.h"
 #include "data_types.h"
@@ -351,6 +354,615 @@ need_to_partition(node_info **ninfo_arr, char *resname)
 	return 1;
 }
 
+/**
+ *	The placement set layout cache remembers which vnodes are in which node
+ *	partition between cycles, so create_node_partitions() does not need to
+ *	re-partition the vnodes every cycle.  A layout belongs to the resource
+ *	names and flags create_node_partitions() was called with and to the
+ *	names of the vnodes in the node array, in order.  Each cycle, only the
+ *	vnodes whose partition resource values have changed are moved between
+ *	the partitions of the layout.  The node_partitions are still built from
+ *	the layout each cycle because they point at the cycle's vnodes, and
+ *	their metadata is filled in by node_partition_update().
+ *
+ *	Layouts are kept in two generations like the cannot-run cache.  Layouts
+ *	which were not used in a cycle are freed when the next cycle begins.
+ */
+struct np_layout_part {
+	char *name;		/* res_name=res_val */
+	int res_i;		/* index of the resource in resnames */
+	char *res_val;		/* value of the resource */
+	int *members;		/* indices of the member vnodes, ascending */
+	int num_members;
+	int size;		/* allocated size of members */
+	int first_val;		/* position of res_val in the first member's values */
+};
+
+struct np_layout {
+	char **resnames;	/* resource names the vnodes are partitioned on */
+	unsigned int flags;	/* flags passed to create_node_partitions() */
+	int num_nodes;
+	int num_res;
+	char **node_names;	/* names of the vnodes in the node array */
+	char ***node_vals;	/* values of vnode n for resource r at n * num_res + r */
+	struct np_layout_part **parts;	/* partitions in the order they are created */
+	int num_parts;
+	int parts_size;		/* allocated size of parts */
+	void *part_idx;		/* partitions by name */
+};
+
+static void *np_layout_cache = NULL;		/* current generation */
+static void *np_layout_cache_prev = NULL;	/* previous generation */
+
+/* value of vnodes without the partition resource (NP_CREATE_REST) */
+static char *np_unset_vals[] = {"\"\"", NULL};
+
+/**
+ * @brief
+ *		free a placement set layout partition
+ *
+ * @param[in]	part	-	partition to free
+ *
+ * @return	void
+ */
+static void
+free_np_layout_part(struct np_layout_part *part)
+{
+	if (part == NULL)
+		return;
+
+	free(part->name);
+	free(part->res_val);
+	free(part->members);
+	free(part);
+}
+
+/**
+ * @brief
+ *		entlim free function for partitions removed from a layout's index.
+ *		The partitions are freed by the layout.
+ *
+ * @param[in]	part	-	partition being removed
+ *
+ * @return	void
+ */
+static void
+keep_np_layout_part(void *part)
+{
+	return;
+}
+
+/**
+ * @brief
+ *		free a placement set layout
+ *
+ * @param[in]	layout	-	layout to free
+ *
+ * @return	void
+ */
+static void
+free_np_layout(void *layout)
+{
+	struct np_layout *lay = layout;
+	int i;
+
+	if (lay == NULL)
+		return;
+
+	if (lay->node_names != NULL) {
+		for (i = 0; i < lay->num_nodes; i++)
+			free(lay->node_names[i]);
+		free(lay->node_names);
+	}
+	if (lay->node_vals != NULL) {
+		for (i = 0; i < lay->num_nodes * lay->num_res; i++)
+			free_string_array(lay->node_vals[i]);
+		free(lay->node_vals);
+	}
+	if (lay->parts != NULL) {
+		for (i = 0; i < lay->num_parts; i++)
+			free_np_layout_part(lay->parts[i]);
+		free(lay->parts);
+	}
+	if (lay->part_idx != NULL)
+		entlim_free_ctx(lay->part_idx, keep_np_layout_part);
+	free_string_array(lay->resnames);
+	free(lay);
+}
+
+/**
+ * @brief
+ *		entlim free function used when a layout is moved between generations
+ *
+ * @param[in]	layout	-	layout being moved
+ *
+ * @return	void
+ */
+static void
+keep_np_layout(void *layout)
+{
+	return;
+}
+
+/**
+ * @brief
+ *		compare two NULL terminated string arrays, in order
+ *
+ * @param[in]	arr1	-	first array (may be NULL)
+ * @param[in]	arr2	-	second array (may be NULL)
+ *
+ * @return	int
+ * @retval	1	: the arrays are the same
+ * @retval	0	: the arrays differ
+ */
+static int
+same_string_array(char **arr1, char **arr2)
+{
+	int i;
+
+	if (arr1 == NULL || arr2 == NULL)
+		return arr1 == arr2;
+
+	for (i = 0; arr1[i] != NULL && arr2[i] != NULL; i++)
+		if (strcmp(arr1[i], arr2[i]))
+			return 0;
+
+	return arr1[i] == arr2[i];
+}
+
+/**
+ * @brief
+ *		create an empty placement set layout for a node array
+ *
+ * @param[in]	nodes	-	the node array
+ * @param[in]	num_nodes	-	number of nodes in nodes
+ * @param[in]	resnames	-	node grouping resource names
+ * @param[in]	flags	-	create_node_partitions() flags
+ *
+ * @return	struct np_layout *
+ * @retval	new layout
+ * @retval	NULL	: on error
+ */
+static struct np_layout *
+new_np_layout(node_info **nodes, int num_nodes, char **resnames, unsigned int flags)
+{
+	struct np_layout *lay;
+	int i;
+
+	if ((lay = calloc(1, sizeof(struct np_layout))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	lay->flags = flags;
+	lay->num_nodes = num_nodes;
+	lay->num_res = count_array((void **) resnames);
+	if ((lay->resnames = dup_string_array(resnames)) == NULL) {
+		free_np_layout(lay);
+		return NULL;
+	}
+
+	lay->node_names = calloc(num_nodes + 1, sizeof(char *));
+	lay->node_vals = calloc(num_nodes * lay->num_res + 1, sizeof(char **));
+	lay->part_idx = entlim_initialize_ctx();
+	if (lay->node_names == NULL || lay->node_vals == NULL || lay->part_idx == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_np_layout(lay);
+		return NULL;
+	}
+
+	for (i = 0; i < num_nodes; i++) {
+		if ((lay->node_names[i] = string_dup(nodes[i]->name)) == NULL) {
+			free_np_layout(lay);
+			return NULL;
+		}
+	}
+
+	return lay;
+}
+
+/**
+ * @brief
+ *		find the placement set layout for a node array, or create an empty
+ *		one if there is none
+ *
+ * @param[in]	nodes	-	the node array
+ * @param[in]	num_nodes	-	number of nodes in nodes
+ * @param[in]	resnames	-	node grouping resource names
+ * @param[in]	flags	-	create_node_partitions() flags
+ *
+ * @return	struct np_layout *
+ * @retval	the layout
+ * @retval	NULL	: on error
+ */
+static struct np_layout *
+find_alloc_np_layout(node_info **nodes, int num_nodes, char **resnames, unsigned int flags)
+{
+	struct np_layout *lay = NULL;
+	unsigned long long sig;
+	char key[64];
+	int i;
+
+	if (np_layout_cache == NULL) {
+		if ((np_layout_cache = entlim_initialize_ctx()) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return NULL;
+		}
+	}
+
+	sig = HASH_INIT;
+	for (i = 0; resnames[i] != NULL; i++)
+		sig = hash_str(sig, resnames[i]);
+	for (i = 0; i < num_nodes; i++)
+		sig = hash_str(sig, nodes[i]->name);
+	snprintf(key, sizeof(key), "%u:%d:%llx", flags, num_nodes, sig);
+
+	if ((lay = entlim_get(key, np_layout_cache)) == NULL &&
+		np_layout_cache_prev != NULL &&
+		(lay = entlim_get(key, np_layout_cache_prev)) != NULL) {
+		entlim_delete(key, np_layout_cache_prev, keep_np_layout);
+		if (entlim_add(key, lay, np_layout_cache) != 0) {
+			free_np_layout(lay);
+			return NULL;
+		}
+	}
+
+	/* make sure the layout is for the same vnodes and not a hash collision */
+	if (lay != NULL) {
+		if (same_string_array(lay->resnames, resnames)) {
+			for (i = 0; i < num_nodes; i++)
+				if (strcmp(lay->node_names[i], nodes[i]->name))
+					break;
+			if (i == num_nodes)
+				return lay;
+		}
+		entlim_delete(key, np_layout_cache, free_np_layout);
+	}
+
+	if ((lay = new_np_layout(nodes, num_nodes, resnames, flags)) == NULL)
+		return NULL;
+
+	if (entlim_add(key, lay, np_layout_cache) != 0) {
+		free_np_layout(lay);
+		return NULL;
+	}
+
+	return lay;
+}
+
+/**
+ * @brief
+ *		find a partition of a placement set layout by resource value and
+ *		create it if it does not exist
+ *
+ * @param[in]	lay	-	the layout
+ * @param[in]	res_i	-	index of the resource in the layout's resnames
+ * @param[in]	val	-	value of the resource
+ * @param[in]	create	-	create the partition if it does not exist
+ *
+ * @return	struct np_layout_part *
+ * @retval	the partition
+ * @retval	NULL	: not found or on error
+ */
+static struct np_layout_part *
+find_np_layout_part(struct np_layout *lay, int res_i, char *val, int create)
+{
+	struct np_layout_part *part;
+	struct np_layout_part **tmp_parts;
+	char buf[1024];
+	char *str;
+	int free_str = 0;
+
+	/* a key too long for buf is built on the heap instead */
+	if (snprintf(buf, sizeof(buf), "%s=%s", lay->resnames[res_i], val) < (int) sizeof(buf))
+		str = buf;
+	else {
+		if ((str = concat_str(lay->resnames[res_i], "=", val, 0)) == NULL)
+			return NULL;
+		free_str = 1;
+	}
+
+	if ((part = entlim_get(str, lay->part_idx)) != NULL || !create) {
+		if (free_str)
+			free(str);
+		return part;
+	}
+
+	if (lay->num_parts >= lay->parts_size) {
+		tmp_parts = realloc(lay->parts,
+			(lay->parts_size * 2 + 1) * sizeof(struct np_layout_part *));
+		if (tmp_parts == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			if (free_str)
+				free(str);
+			return NULL;
+		}
+		lay->parts = tmp_parts;
+		lay->parts_size = lay->parts_size * 2 + 1;
+	}
+
+	if ((part = calloc(1, sizeof(struct np_layout_part))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		if (free_str)
+			free(str);
+		return NULL;
+	}
+
+	part->name = free_str ? str : string_dup(str);
+	part->res_i = res_i;
+	part->res_val = string_dup(val);
+	if (part->name == NULL || part->res_val == NULL ||
+		entlim_add(part->name, part, lay->part_idx) != 0) {
+		free_np_layout_part(part);
+		return NULL;
+	}
+	lay->parts[lay->num_parts++] = part;
+
+	return part;
+}
+
+/**
+ * @brief
+ *		find the position of a vnode in a partition's members
+ *
+ * @param[in]	part	-	the partition
+ * @param[in]	node_i	-	index of the vnode
+ *
+ * @return	int
+ * @retval	position of the vnode or where it would be inserted
+ */
+static int
+np_layout_member_pos(struct np_layout_part *part, int node_i)
+{
+	int lo = 0;
+	int hi = part->num_members;
+	int mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (part->members[mid] < node_i)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/**
+ * @brief
+ *		add a vnode to a placement set layout partition
+ *
+ * @param[in]	part	-	the partition
+ * @param[in]	node_i	-	index of the vnode
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: on error
+ */
+static int
+add_np_layout_member(struct np_layout_part *part, int node_i)
+{
+	int *tmp_members;
+	int pos;
+
+	/* vnodes are usually added in order */
+	if (part->num_members == 0 || part->members[part->num_members - 1] < node_i)
+		pos = part->num_members;
+	else {
+		pos = np_layout_member_pos(part, node_i);
+		if (part->members[pos] == node_i)
+			return 1;
+	}
+
+	if (part->num_members >= part->size) {
+		tmp_members = realloc(part->members, (part->size * 2 + 1) * sizeof(int));
+		if (tmp_members == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return 0;
+		}
+		part->members = tmp_members;
+		part->size = part->size * 2 + 1;
+	}
+
+	memmove(&part->members[pos + 1], &part->members[pos],
+		(part->num_members - pos) * sizeof(int));
+	part->members[pos] = node_i;
+	part->num_members++;
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		remove a vnode from a placement set layout partition
+ *
+ * @param[in]	part	-	the partition
+ * @param[in]	node_i	-	index of the vnode
+ *
+ * @return	void
+ */
+static void
+remove_np_layout_member(struct np_layout_part *part, int node_i)
+{
+	int pos;
+
+	pos = np_layout_member_pos(part, node_i);
+	if (pos == part->num_members || part->members[pos] != node_i)
+		return;
+
+	part->num_members--;
+	memmove(&part->members[pos], &part->members[pos + 1],
+		(part->num_members - pos) * sizeof(int));
+}
+
+/**
+ * @brief
+ *		sort placement set layout partitions in the order a full
+ *		partitioning of the vnodes creates them: by resource, then by the
+ *		first vnode with the value, then by the value's position on that vnode
+ *
+ * @param[in]	v1	-	first partition
+ * @param[in]	v2	-	second partition
+ *
+ * @return	int
+ * @retval	-1, 0, 1	: qsort order
+ */
+static int
+cmp_np_layout_parts(const void *v1, const void *v2)
+{
+	struct np_layout_part *p1 = *(struct np_layout_part **) v1;
+	struct np_layout_part *p2 = *(struct np_layout_part **) v2;
+
+	if (p1->res_i != p2->res_i)
+		return p1->res_i < p2->res_i ? -1 : 1;
+	if (p1->members[0] != p2->members[0])
+		return p1->members[0] < p2->members[0] ? -1 : 1;
+	if (p1->first_val != p2->first_val)
+		return p1->first_val < p2->first_val ? -1 : 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *		bring a placement set layout up to date with the vnodes' partition
+ *		resource values.  Only the vnodes whose values have changed since
+ *		the layout was last used are moved between partitions.
+ *
+ * @param[in]	lay	-	the layout
+ * @param[in]	nodes	-	the node array of the layout
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: on error
+ */
+static int
+update_np_layout(struct np_layout *lay, node_info **nodes)
+{
+	struct np_layout_part *part;
+	resdef **defs;
+	resource *res;
+	char **vals;
+	char ***pvals;
+	int changed = 0;
+	int node_i;
+	int res_i;
+	int val_i;
+	int i, j;
+
+	if ((defs = malloc((lay->num_res + 1) * sizeof(resdef *))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+	for (res_i = 0; res_i < lay->num_res; res_i++)
+		defs[res_i] = find_resdef(allres, lay->resnames[res_i]);
+
+	for (node_i = 0; node_i < lay->num_nodes; node_i++) {
+		for (res_i = 0; res_i < lay->num_res; res_i++) {
+			vals = NULL;
+			if (!nodes[node_i]->is_stale) {
+				res = find_resource(nodes[node_i]->res, defs[res_i]);
+				if (res != NULL)
+					vals = res->str_avail;
+				else if (lay->flags & NP_CREATE_REST)
+					vals = np_unset_vals;
+			}
+
+			pvals = &lay->node_vals[node_i * lay->num_res + res_i];
+			if (same_string_array(*pvals, vals))
+				continue;
+
+			changed = 1;
+			if (*pvals != NULL) {
+				for (val_i = 0; (*pvals)[val_i] != NULL; val_i++) {
+					part = find_np_layout_part(lay, res_i, (*pvals)[val_i], 0);
+					if (part != NULL)
+						remove_np_layout_member(part, node_i);
+				}
+				free_string_array(*pvals);
+				*pvals = NULL;
+			}
+
+			if (vals != NULL) {
+				for (val_i = 0; vals[val_i] != NULL; val_i++) {
+					part = find_np_layout_part(lay, res_i, vals[val_i], 1);
+					if (part == NULL || !add_np_layout_member(part, node_i)) {
+						free(defs);
+						return 0;
+					}
+				}
+				if ((*pvals = dup_string_array(vals)) == NULL) {
+					free(defs);
+					return 0;
+				}
+			}
+		}
+	}
+	free(defs);
+
+	if (!changed)
+		return 1;
+
+	/* drop the partitions which no longer have any vnodes and put the
+	 * rest back in the order they would have been created in
+	 */
+	for (i = 0, j = 0; i < lay->num_parts; i++) {
+		part = lay->parts[i];
+		if (part->num_members == 0) {
+			entlim_delete(part->name, lay->part_idx, keep_np_layout_part);
+			free_np_layout_part(part);
+			continue;
+		}
+		vals = lay->node_vals[part->members[0] * lay->num_res + part->res_i];
+		for (val_i = 0; vals[val_i] != NULL; val_i++)
+			if (!strcmp(vals[val_i], part->res_val))
+				break;
+		part->first_val = val_i;
+		lay->parts[j++] = part;
+	}
+	lay->num_parts = j;
+
+	qsort(lay->parts, lay->num_parts, sizeof(struct np_layout_part *),
+		cmp_np_layout_parts);
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		start a new generation of the placement set layout cache.  Layouts
+ *		not used since the last generation began are freed.
+ *
+ * @return	void
+ */
+static void
+begin_np_layout_cache(void)
+{
+	if (np_layout_cache_prev != NULL)
+		entlim_free_ctx(np_layout_cache_prev, free_np_layout);
+	np_layout_cache_prev = np_layout_cache;
+	np_layout_cache = NULL;
+}
+
+/**
+ * @brief
+ *		free the placement set layout cache
+ *
+ * @return	void
+ */
+void
+free_np_layout_cache(void)
+{
+	if (np_layout_cache != NULL) {
+		entlim_free_ctx(np_layout_cache, free_np_layout);
+		np_layout_cache = NULL;
+	}
+	if (np_layout_cache_prev != NULL) {
+		entlim_free_ctx(np_layout_cache_prev, free_np_layout);
+		np_layout_cache_prev = NULL;
+	}
+}
+
 /**
  * @brief
  * 		break apart nodes into partitions
@@ -364,6 +976,11 @@ need_to_partition(node_info **ninfo_arr, char *resname)
  *		away due to the fact that the node partition has insufficient
  *		resources.
  *
+ * @par
+ *		Which vnodes are in which partition is kept in the placement set
+ *		layout cache between cycles.  Only vnodes whose partition resource
+ *		values have changed are re-partitioned.
+ *
  * @param[in]	policy	-	policy info
  * @param[in]	nodes	-	the nodes which to create partitions from
  * @param[in]	resnames	-	node grouping resource names
@@ -382,199 +999,77 @@ create_node_partitions(status *policy, node_info **nodes, char **resnames, unsig
 {
 	node_partition **np_arr;
 	node_partition *np;
-	node_partition **tmp_arr;
-	char buf[1024];
-	char *str;
-	int free_str = 0;
-	int np_arr_size = 0;
-	resource *res;
-
+	struct np_layout *lay;
+	struct np_layout_part *part;
 	int num_nodes;
-	int reslen;
 	int i;
 
 	resource *hostres;
 	resource *tmpres;
 
-	int res_i;		/* index of placement set resource name (resnames) */
-	int val_i;		/* index of placement set resource value */
-	int node_i;		/* index into nodes array */
 	int np_i;		/* index into node partition array we are creating */
 
-	resource unset_res;
-	char *unsetarr[] = {"\"\"", NULL};
-
-	resdef *def;
-
 	if (nodes == NULL || resnames == NULL)
 		return NULL;
 
 	num_nodes = count_array((void **) nodes);
 
+	if ((lay = find_alloc_np_layout(nodes, num_nodes, resnames, flags)) == NULL)
+		return NULL;
+
+	if (!update_np_layout(lay, nodes)) {
+		/* the layout is only partly updated; start over next time */
+		free_np_layout_cache();
+		return NULL;
+	}
+
 	if ((np_arr = (node_partition **)
-		malloc((num_nodes + 1) * sizeof(node_partition *))) == NULL) {
+		malloc((lay->num_parts + 1) * sizeof(node_partition *))) == NULL) {
 		log_err(errno, "create_node_partitions", MEM_ERR_MSG);
 		return NULL;
 	}
-
-	np_arr_size = num_nodes;
-
-	np_i = 0;
 	np_arr[0] = NULL;
 
-	if (flags & NP_CREATE_REST) {
-		memset(&unset_res, 0, sizeof(unset_res));
-		unset_res.str_avail = (char **) unsetarr;
-		unset_res.type.is_non_consumable = 1;
-		unset_res.type.is_string = 1;
-	}
-
-	for (res_i = 0; resnames[res_i] != NULL; res_i++) {
-		def = find_resdef(allres, resnames[res_i]);
-		reslen = strlen(resnames[res_i]);
-		for (node_i = 0; nodes[node_i] != NULL; node_i++) {
-			if (nodes[node_i]->is_stale)
-				continue;
-
-			res = find_resource(nodes[node_i]->res, def);
+	for (np_i = 0; np_i < lay->num_parts; np_i++) {
+		part = lay->parts[np_i];
 
-			if (res == NULL && (flags & NP_CREATE_REST)) {
-				unset_res.name = resnames[res_i];
-				res = &unset_res;
-			}
-			if (res != NULL) {
-				for (val_i = 0; res->str_avail[val_i] != NULL; val_i++) {
-					/* 2: 1 for '=' 1 for '\0' */
-					if (reslen + strlen(res->str_avail[val_i]) + 2 < 1024) {
-						sprintf(buf, "%s=%s", resnames[res_i], res->str_avail[val_i]);
-						str = buf;
-					}
-					else {
-						str = concat_str(resnames[res_i], "=", res->str_avail[val_i], 0);
-						free_str = 1;
-					}
-					/* If we find the partition, we've already created it - add the node
-					 * to the existing partition.  If we don't find it, we create it.
-					 */
-					np = find_node_partition(np_arr, str);
-					if (np == NULL) {
-						if (np_i >= np_arr_size) {
-							tmp_arr = realloc(np_arr,
-								(np_arr_size * 2 + 1) * sizeof(node_partition *));
-							if (tmp_arr == NULL) {
-								log_err(errno, "create_node_partitions", MEM_ERR_MSG);
-								free_node_partition_array(np_arr);
-								if (free_str == 1)
-									free(str);
-
-								return NULL;
-							}
-							np_arr = tmp_arr;
-							np_arr_size *= 2;
-						}
-
-						np_arr[np_i] = new_node_partition();
-						if (np_arr[np_i] != NULL) {
-							if (free_str) {
-								np_arr[np_i]->name = str;
-								free_str = 0;
-							}
-							else
-								np_arr[np_i]->name = string_dup(str);
-
-							np_arr[np_i]->def = def;
-							np_arr[np_i]->res_val = string_dup(res->str_avail[val_i]);
-							np_arr[np_i]->tot_nodes = 1;
-							if (nodes[node_i]->is_free)
-								np_arr[np_i]->free_nodes = 1;
-							np_arr[np_i]->rank = get_sched_rank();
-
-							if (np_arr[np_i]->res_val == NULL) {
-								np_arr[np_i+1] = NULL;
-								free_node_partition_array(np_arr);
-								return NULL;
-							}
-
-							np_i++;
-							np_arr[np_i] = NULL;
-						}
-						else {
-							free_node_partition_array(np_arr);
-							return NULL;
-						}
-					}
-					else {
-						np->tot_nodes++;
-						if (nodes[node_i]->is_free)
-							np->free_nodes++;
-					}
-					if (free_str) {
-						free(str);
-						free_str = 0;
-					}
-
-				}
-			}
-			/* else we ignore nodes without the node partition resource set
-			 * unless the NP_CREATE_REST flag is set
-			 */
+		if ((np = new_node_partition()) == NULL) {
+			free_node_partition_array(np_arr);
+			return NULL;
 		}
-	}
-
-
-	/* now that we have a list of node partitions and number of nodes in each
-	 * lets allocate a node array and fill it
-	 */
-
-	for (np_i = 0; np_arr[np_i] != NULL; np_i++) {
-		i = 0;
-		np_arr[np_i]->ok_break = 1;
-		hostres = NULL;
-
-		np_arr[np_i]->ninfo_arr =
-			malloc((np_arr[np_i]->tot_nodes + 1) * sizeof(node_info *));
-
-		if (np_arr[np_i]->ninfo_arr == NULL) {
+		np_arr[np_i] = np;
+		np_arr[np_i + 1] = NULL;
+
+		np->name = string_dup(part->name);
+		np->def = find_resdef(allres, resnames[part->res_i]);
+		np->res_val = string_dup(part->res_val);
+		np->rank = get_sched_rank();
+		np->ninfo_arr = malloc((part->num_members + 1) * sizeof(node_info *));
+		if (np->name == NULL || np->res_val == NULL || np->ninfo_arr == NULL) {
+			log_err(errno, "create_node_partitions", MEM_ERR_MSG);
 			free_node_partition_array(np_arr);
 			return NULL;
 		}
 
-		np_arr[np_i]->ninfo_arr[0] = NULL;
-
-		for (node_i = 0; nodes[node_i] != NULL &&
-			i < np_arr[np_i]->tot_nodes; node_i++) {
-			if (nodes[node_i]->is_stale)
-				continue;
-
-			res = find_resource(nodes[node_i]->res, np_arr[np_i]->def);
-			if (res == NULL && (flags & NP_CREATE_REST)) {
-				unset_res.name = resnames[res_i];
-				res = &unset_res;
-			}
-			if (res != NULL) {
-				if (compare_res_to_str(res, np_arr[np_i]->res_val, CMP_CASE)) {
-					if (np_arr[np_i]->ok_break) {
-						tmpres = find_resource(nodes[node_i]->res, getallres(RES_HOST));
-						if (tmpres != NULL) {
-							if (hostres == NULL)
-								hostres = tmpres;
-							else {
-								if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
-									np_arr[np_i]->ok_break = 0;
-							}
-						}
+		np->ok_break = 1;
+		hostres = NULL;
+		for (i = 0; i < part->num_members; i++) {
+			np->ninfo_arr[i] = nodes[part->members[i]];
+			if (np->ok_break) {
+				tmpres = find_resource(np->ninfo_arr[i]->res, getallres(RES_HOST));
+				if (tmpres != NULL) {
+					if (hostres == NULL)
+						hostres = tmpres;
+					else {
+						if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
+							np->ok_break = 0;
 					}
-					np_arr[np_i]->ninfo_arr[i] = nodes[node_i];
-					i++;
-					np_arr[np_i]->ninfo_arr[i] = NULL;
 				}
 			}
 		}
-		/* if multiple resource values are present, tot_nodes may be incorrect.
-		 * recalculating tot_nodes for each node partition.
-		 */
-		np_arr[np_i]->tot_nodes = count_array((void**) np_arr[np_i]->ninfo_arr);
-		node_partition_update(policy, np_arr[np_i]);
+		np->ninfo_arr[i] = NULL;
+		np->tot_nodes = i;
+		node_partition_update(policy, np);
 	}
 
 	*num_parts = np_i;
@@ -1135,6 +1630,11 @@ create_placement_sets(status *policy, server_info *sinfo)
 	int is_success = 1;
 	char *resstr[] = {"host", NULL};
 	int num;
+	obj_index *hostsets_idx;
+	void *hset;
+
+	/* layouts not used since the last placement sets were created are freed */
+	begin_np_layout_cache();
 
 	sinfo->allpart = create_specific_nodepart(policy, "all",
 		sinfo->unassoc_nodes);
@@ -1143,22 +1643,27 @@ create_placement_sets(status *policy, server_info *sinfo)
 			resstr, NP_CREATE_REST, &num);
 		if (sinfo->hostsets != NULL) {
 			sinfo->num_hostsets = num;
+			/* there is a host set per host, so look them up by name with an index */
+			hostsets_idx = new_obj_index(offsetof(node_partition, name),
+				offsetof(node_partition, rank));
 			for (i = 0; sinfo->nodes[i] != NULL; i++) {
 				resource *hostres;
 				char hostbuf[256];
 
 				hostres = find_resource(sinfo->nodes[i]->res, getallres(RES_HOST));
-				if (hostres != NULL) {
+				if (hostres != NULL)
 					snprintf(hostbuf, sizeof(hostbuf), "host=%s", hostres->str_avail[0]);
-					sinfo->nodes[i]->hostset =
-						find_node_partition(sinfo->hostsets, hostbuf);
-				}
-				else {
+				else
 					snprintf(hostbuf, sizeof(hostbuf), "host=\"\"");
+
+				if (find_obj_index_by_name(hostsets_idx, (void **) sinfo->hostsets,
+					hostbuf, &hset))
+					sinfo->nodes[i]->hostset = hset;
+				else
 					sinfo->nodes[i]->hostset =
 						find_node_partition(sinfo->hostsets, hostbuf);
-				}
 			}
+			free_obj_index(hostsets_idx);
 		}
 		else {
 			schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, LOG_DEBUG, "",
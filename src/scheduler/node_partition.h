@@ -241,6 +241,11 @@ node_partition *create_specific_nodepart(status *policy, char *name, node_info *
 /* create the placement sets for the server and queues */
 int create_placement_sets(status *policy, server_info *sinfo);
 
+/*
+ *	free_np_layout_cache - free the placement set layouts kept between cycles
+ */
+void free_np_layout_cache(void);
+
 /* Update placement sets and allparts */
 void update_all_nodepart(status *policy, server_info *sinfo, resource_resv *resresv);
 
@@ -0,0 +1,593 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    node_res_index.c
+ *
+ * @brief
+ * 	node_res_index.c - columnar index of the resources on the server's
+ *	vnodes.  It is built once a cycle after the nodes are queried and is
+ *	shared by all the duplicated servers of the cycle.  Each resource has
+ *	a column with the amount available on every vnode (consumable), or
+ *	bitsets of the vnodes with each value (boolean and string).  This lets
+ *	a chunk be matched against all the vnodes at once rather than
+ *	searching each vnode's resource list.
+ *
+ *	The index only holds values which don't change during a cycle.  It is
+ *	used as a filter: a vnode not in the filter can't satisfy the chunk,
+ *	a vnode in the filter still needs to be checked.
+ *
+ * Functions included are:
+ * 	add_node_res_col_value()
+ * 	new_node_res_index()
+ * 	free_node_res_index()
+ * 	share_node_res_index()
+ * 	find_node_res_col()
+ * 	find_node_res_col_value()
+ * 	node_res_index_filter()
+ * 	chunk_node_filter()
+ * 	node_in_node_filter()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <log.h>
+#include <pbs_ifl.h>
+#include "constant.h"
+#include "config.h"
+#include "data_types.h"
+#include "globals.h"
+#include "misc.h"
+#include "node_res_index.h"
+
+/* the last seq handed out to a node_res_index */
+static int node_res_index_seq = 0;
+
+/**
+ * @brief
+ * 		add a vnode to the bitset of a string value in a column.  The
+ *		value is added to the column if this is the first vnode with it.
+ *
+ * @param[in]	col	-	the column
+ * @param[in]	val	-	the string value
+ * @param[in]	ind	-	node_ind of the vnode
+ * @param[in]	num_words	-	number of words in a bitset
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+add_node_res_col_value(node_res_col *col, char *val, int ind, int num_words)
+{
+	unsigned long *bits;
+	unsigned long **tmp_bits;
+	char **tmp_vals;
+
+	bits = find_node_res_col_value(col, val);
+	if (bits == NULL) {
+		tmp_vals = realloc(col->vals, (col->num_vals + 1) * sizeof(char *));
+		if (tmp_vals == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return 0;
+		}
+		col->vals = tmp_vals;
+
+		tmp_bits = realloc(col->val_bits,
+			(col->num_vals + 1) * sizeof(unsigned long *));
+		if (tmp_bits == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return 0;
+		}
+		col->val_bits = tmp_bits;
+
+		bits = calloc(num_words, sizeof(unsigned long));
+		if (bits == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			return 0;
+		}
+		col->vals[col->num_vals] = string_dup(val);
+		if (col->vals[col->num_vals] == NULL) {
+			free(bits);
+			return 0;
+		}
+		col->val_bits[col->num_vals] = bits;
+		col->num_vals++;
+	}
+
+	NODE_RES_SET(bits, ind);
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		build the node resource index of an array of vnodes.  Each
+ *		vnode's node_ind is set to its position in the array.
+ *
+ * @param[in]	nodes	-	the server's vnodes
+ *
+ * @return	node_res_index *
+ * @retval	the new index
+ * @retval	NULL	: on error
+ *
+ * @par MT-safe: No
+ */
+node_res_index *
+new_node_res_index(node_info **nodes)
+{
+	node_res_index *idx;
+	node_res_col *col;
+	resource *res;
+	int num_nodes;
+	int ignored;
+	int i;
+	int k;
+	int v;
+	int n;
+
+	if (nodes == NULL || allres == NULL)
+		return NULL;
+
+	if ((idx = calloc(1, sizeof(node_res_index))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	num_nodes = count_array((void **) nodes);
+	idx->refcount = 1;
+	idx->seq = ++node_res_index_seq;
+	idx->num_nodes = num_nodes;
+	idx->num_words = (num_nodes + NODE_RES_WORD_BITS - 1) / NODE_RES_WORD_BITS;
+	if (idx->num_words == 0)
+		idx->num_words = 1;
+	idx->num_cols = count_array((void **) allres);
+
+	if ((idx->cols = calloc(idx->num_cols, sizeof(node_res_col))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free(idx);
+		return NULL;
+	}
+
+	for (k = 0; k < idx->num_cols; k++) {
+		col = &idx->cols[k];
+		col->def = allres[k];
+		if (col->def->type.is_consumable || col->def->type.is_boolean ||
+			col->def->type.is_string)
+			col->indexed = 1;
+		else
+			continue;
+
+		col->unset = malloc(idx->num_words * sizeof(unsigned long));
+		col->unknown = calloc(idx->num_words, sizeof(unsigned long));
+		if (col->unset == NULL || col->unknown == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free_node_res_index(idx);
+			return NULL;
+		}
+		memset(col->unset, 0xff, idx->num_words * sizeof(unsigned long));
+
+		if (col->def->type.is_consumable) {
+			col->avail = malloc((num_nodes + 1) * sizeof(sch_resource_t));
+			if (col->avail == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				free_node_res_index(idx);
+				return NULL;
+			}
+		}
+		else if (col->def->type.is_boolean) {
+			col->bool_true = calloc(idx->num_words, sizeof(unsigned long));
+			col->bool_false = calloc(idx->num_words, sizeof(unsigned long));
+			if (col->bool_true == NULL || col->bool_false == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				free_node_res_index(idx);
+				return NULL;
+			}
+		}
+	}
+
+	k = 0;
+	for (n = 0; n < num_nodes; n++) {
+		nodes[n]->node_ind = n;
+
+		for (res = nodes[n]->res; res != NULL; res = res->next) {
+			/* vnodes usually have their resources in the same order, so
+			 * start looking after the column we found last
+			 */
+			for (i = 0; i < idx->num_cols; i++, k++) {
+				if (k >= idx->num_cols)
+					k = 0;
+				if (idx->cols[k].def == res->def)
+					break;
+			}
+			if (i == idx->num_cols)
+				continue;
+
+			col = &idx->cols[k];
+			k++;
+			if (!col->indexed)
+				continue;
+
+			NODE_RES_CLEAR(col->unset, n);
+			ignored = match_string_to_array(res->name, conf.ignore_res) != SA_NO_MATCH;
+
+			/* the checks treat these specially, leave them to the checks */
+			if (res->indirect_res != NULL ||
+				(res->orig_str_avail == NULL && ignored) ||
+				res->type.is_consumable != col->def->type.is_consumable ||
+				res->type.is_boolean != col->def->type.is_boolean ||
+				res->type.is_string != col->def->type.is_string) {
+				NODE_RES_SET(col->unknown, n);
+				continue;
+			}
+
+			if (col->avail != NULL)
+				col->avail[n] = res->avail;
+			else if (col->bool_true != NULL) {
+				if (res->avail == TRUE_FALSE || res->avail)
+					NODE_RES_SET(col->bool_true, n);
+				if (res->avail == TRUE_FALSE || !res->avail)
+					NODE_RES_SET(col->bool_false, n);
+			}
+			else if (res->str_avail != NULL) {
+				for (v = 0; res->str_avail[v] != NULL; v++) {
+					if (!add_node_res_col_value(col, res->str_avail[v], n,
+						idx->num_words)) {
+						free_node_res_index(idx);
+						return NULL;
+					}
+				}
+			}
+		}
+	}
+
+	/* Now fill in the vnodes without the resource.  The checks treat an
+	 * unset resource as False or 0, unless the resource is ignored
+	 * (resource_unset_infinite), in which case it always matches.
+	 */
+	for (k = 0; k < idx->num_cols; k++) {
+		col = &idx->cols[k];
+		if (!col->indexed)
+			continue;
+
+		ignored = match_string_to_array(col->def->name, conf.ignore_res) != SA_NO_MATCH;
+		for (n = 0; n < num_nodes; n++) {
+			if (!NODE_RES_TEST(col->unset, n))
+				continue;
+
+			if (ignored)
+				NODE_RES_SET(col->unknown, n);
+			else if (col->avail != NULL)
+				col->avail[n] = 0;
+			else if (col->bool_false != NULL)
+				NODE_RES_SET(col->bool_false, n);
+		}
+
+		if (col->avail != NULL) {
+			for (n = 0; n < num_nodes; n++) {
+				if (NODE_RES_TEST(col->unknown, n))
+					col->avail[n] = SCHD_INFINITY;
+			}
+		}
+		else if (col->bool_true != NULL) {
+			for (i = 0; i < idx->num_words; i++) {
+				col->bool_true[i] |= col->unknown[i];
+				col->bool_false[i] |= col->unknown[i];
+			}
+		}
+	}
+
+	return idx;
+}
+
+/**
+ * @brief
+ * 		node_res_index destructor.  The index is shared between the
+ *		duplicated servers, so it is only freed when the last reference
+ *		is released.
+ *
+ * @param[in]	idx	-	the index to free
+ *
+ * @return	void
+ */
+void
+free_node_res_index(node_res_index *idx)
+{
+	node_res_col *col;
+	int k;
+	int v;
+
+	if (idx == NULL)
+		return;
+
+	if (--idx->refcount > 0)
+		return;
+
+	if (idx->cols != NULL) {
+		for (k = 0; k < idx->num_cols; k++) {
+			col = &idx->cols[k];
+			free(col->unset);
+			free(col->unknown);
+			free(col->avail);
+			free(col->bool_true);
+			free(col->bool_false);
+			for (v = 0; v < col->num_vals; v++) {
+				free(col->vals[v]);
+				free(col->val_bits[v]);
+			}
+			free(col->vals);
+			free(col->val_bits);
+		}
+		free(idx->cols);
+	}
+
+	free(idx);
+}
+
+/**
+ * @brief
+ * 		add a reference to a node_res_index.  The index only holds
+ *		values which don't change in a cycle, so a duplicated server can
+ *		use the same index as the original.
+ *
+ * @param[in]	idx	-	the index to share
+ *
+ * @return	node_res_index *
+ * @retval	idx
+ */
+node_res_index *
+share_node_res_index(node_res_index *idx)
+{
+	if (idx != NULL)
+		idx->refcount++;
+
+	return idx;
+}
+
+/**
+ * @brief
+ * 		find the column of a resource in a node_res_index
+ *
+ * @param[in]	idx	-	the index
+ * @param[in]	def	-	the resource definition
+ *
+ * @return	node_res_col *
+ * @retval	the column
+ * @retval	NULL	: if the resource is not indexed
+ */
+node_res_col *
+find_node_res_col(node_res_index *idx, resdef *def)
+{
+	int k;
+
+	if (idx == NULL || def == NULL)
+		return NULL;
+
+	for (k = 0; k < idx->num_cols; k++) {
+		if (idx->cols[k].def == def) {
+			if (idx->cols[k].indexed)
+				return &idx->cols[k];
+			return NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		find the bitset of vnodes which have a string value in a column
+ *
+ * @param[in]	col	-	the column
+ * @param[in]	val	-	the value (case sensitive)
+ *
+ * @return	unsigned long *
+ * @retval	bitset of vnodes with the value
+ * @retval	NULL	: if no vnode has the value
+ */
+unsigned long *
+find_node_res_col_value(node_res_col *col, char *val)
+{
+	int v;
+
+	if (col == NULL || val == NULL)
+		return NULL;
+
+	for (v = 0; v < col->num_vals; v++) {
+		if (!strcmp(col->vals[v], val))
+			return col->val_bits[v];
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		clear the bits of the vnodes which can't satisfy a list of
+ *		requested resources.  This follows the checks done by
+ *		is_vnode_eligible_chunk() for the non-consumable resources and
+ *		check_resources_for_node() for the consumable resources, but
+ *		against the total amount available.
+ *
+ * @param[in]	idx	-	the index
+ * @param[in]	reqlist	-	the requested resources
+ * @param[in,out]	bits	-	the vnodes to filter
+ *
+ * @return	void
+ */
+void
+node_res_index_filter(node_res_index *idx, resource_req *reqlist,
+	unsigned long *bits)
+{
+	resource_req *req;
+	node_res_col *col;
+	unsigned long *keep;
+	unsigned long **match;
+	unsigned long mask;
+	sch_resource_t amount;
+	int num_match;
+	int caseless;
+	int i;
+	int n;
+	int v;
+
+	if (idx == NULL || bits == NULL)
+		return;
+
+	for (req = reqlist; req != NULL; req = req->next) {
+		col = find_node_res_col(idx, req->def);
+		if (col == NULL)
+			continue;
+
+		if (col->avail != NULL && req->type.is_consumable) {
+			amount = req->amount;
+			if (amount == 0)
+				continue;
+			for (n = 0; n < idx->num_nodes; n++) {
+				if (col->avail[n] != SCHD_INFINITY && col->avail[n] < amount)
+					NODE_RES_CLEAR(bits, n);
+			}
+		}
+		else if (col->bool_true != NULL && req->type.is_boolean) {
+			keep = req->amount ? col->bool_true : col->bool_false;
+			for (i = 0; i < idx->num_words; i++)
+				bits[i] &= keep[i];
+		}
+		else if (col->def->type.is_string && req->type.is_string &&
+			req->res_str != NULL) {
+			match = NULL;
+			num_match = 0;
+			if (col->num_vals > 0) {
+				match = malloc(col->num_vals * sizeof(unsigned long *));
+				if (match == NULL) {
+					log_err(errno, __func__, MEM_ERR_MSG);
+					continue;
+				}
+			}
+
+			/* 'host' is case insensitive, see compare_non_consumable() */
+			caseless = !strcmp(col->def->name, "host");
+			for (v = 0; v < col->num_vals; v++) {
+				if (caseless ? !strcasecmp(col->vals[v], req->res_str) :
+					!strcmp(col->vals[v], req->res_str))
+					match[num_match++] = col->val_bits[v];
+			}
+
+			for (i = 0; i < idx->num_words; i++) {
+				mask = col->unknown[i];
+				/* an unset string resource is treated as "" */
+				if (req->res_str[0] == '\0')
+					mask |= col->unset[i];
+				for (v = 0; v < num_match; v++)
+					mask |= match[v][i];
+				bits[i] &= mask;
+			}
+			free(match);
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		return the bitset of vnodes which may satisfy a chunk.  The
+ *		result is cached on the chunk, so it is only computed once per
+ *		index.
+ *
+ * @param[in,out]	chk	-	the chunk
+ * @param[in]	idx	-	the index of the vnodes being searched
+ *
+ * @return	unsigned long *
+ * @retval	bitset of vnodes (owned by the chunk)
+ * @retval	NULL	: on error
+ */
+unsigned long *
+chunk_node_filter(chunk *chk, node_res_index *idx)
+{
+	unsigned long *bits;
+
+	if (chk == NULL || idx == NULL)
+		return NULL;
+
+	if (chk->node_filter != NULL && chk->node_filter_seq == idx->seq)
+		return chk->node_filter;
+
+	free(chk->node_filter);
+	chk->node_filter = NULL;
+
+	if ((bits = malloc(idx->num_words * sizeof(unsigned long))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+	memset(bits, 0xff, idx->num_words * sizeof(unsigned long));
+
+	node_res_index_filter(idx, chk->req, bits);
+
+	chk->node_filter = bits;
+	chk->node_filter_seq = idx->seq;
+
+	return bits;
+}
+
+/**
+ * @brief
+ * 		check if a vnode is in a filter returned by chunk_node_filter().
+ *		Vnodes which aren't part of the index (e.g. reservation vnodes)
+ *		are always in the filter.
+ *
+ * @param[in]	bits	-	the filter
+ * @param[in]	node	-	the vnode
+ *
+ * @return	int
+ * @retval	1	: the vnode may satisfy the chunk
+ * @retval	0	: the vnode can't satisfy the chunk
+ */
+int
+node_in_node_filter(unsigned long *bits, node_info *node)
+{
+	if (bits == NULL || node == NULL || node->node_ind < 0)
+		return 1;
+
+	if (NODE_RES_TEST(bits, node->node_ind))
+		return 1;
+
+	return 0;
+}
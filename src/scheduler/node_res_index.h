@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+#ifndef	_NODE_RES_INDEX_H
+#define	_NODE_RES_INDEX_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <limits.h>
+#include "data_types.h"
+
+/* bitset helpers for the node_res_index bitsets (indexed by node_ind) */
+#define NODE_RES_WORD_BITS	(sizeof(unsigned long) * CHAR_BIT)
+#define NODE_RES_TEST(bits, ind) \
+	((bits)[(ind) / NODE_RES_WORD_BITS] & (1UL << ((ind) % NODE_RES_WORD_BITS)))
+#define NODE_RES_SET(bits, ind) \
+	((bits)[(ind) / NODE_RES_WORD_BITS] |= (1UL << ((ind) % NODE_RES_WORD_BITS)))
+#define NODE_RES_CLEAR(bits, ind) \
+	((bits)[(ind) / NODE_RES_WORD_BITS] &= ~(1UL << ((ind) % NODE_RES_WORD_BITS)))
+
+/*
+ *	new_node_res_index - build the node resource index of an array of
+ *			     vnodes and set each vnode's node_ind
+ */
+node_res_index *new_node_res_index(node_info **nodes);
+
+/* node_res_index destructor - only frees when the last reference is gone */
+void free_node_res_index(node_res_index *idx);
+
+/* add a reference to a node_res_index for a duplicated server */
+node_res_index *share_node_res_index(node_res_index *idx);
+
+/* find the column of a resource in a node_res_index */
+node_res_col *find_node_res_col(node_res_index *idx, resdef *def);
+
+/* find the bitset of vnodes which have a string value in a column */
+unsigned long *find_node_res_col_value(node_res_col *col, char *val);
+
+/*
+ *	node_res_index_filter - clear the bits of the vnodes which can't
+ *				satisfy a list of requested resources
+ */
+void node_res_index_filter(node_res_index *idx, resource_req *reqlist,
+	unsigned long *bits);
+
+/* return the vnodes which may satisfy a chunk - cached on the chunk */
+unsigned long *chunk_node_filter(chunk *chk, node_res_index *idx);
+
+/* check if a vnode is in a filter returned by chunk_node_filter() */
+int node_in_node_filter(unsigned long *bits, node_info *node);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _NODE_RES_INDEX_H */
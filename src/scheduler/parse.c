@@ -307,6 +307,25 @@ parse_config(char *fname)
 					conf.enforce_no_shares = num ? 1 : 0;
 				else if (!strcmp(config_name, PARSE_ALLOW_AOE_CALENDAR))
 					conf.allow_aoe_calendar = 1;
+				else if (!strcmp(config_name, PARSE_INCREMENTAL_JOB_QUERY))
+					conf.incremental_job_query = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_JOB_QUERY_RESYNC_TIME)) {
+					conf.job_query_resync_time = res_to_num(config_value, &type);
+					if (!type.is_time && !type.is_num)
+						error = 1;
+				}
+				else if (!strcmp(config_name, PARSE_CYCLE_PROFILE))
+					conf.cycle_profile = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_CANT_RUN_CACHE))
+					conf.cant_run_cache = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_DECISION_TRACE))
+					conf.decision_trace = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_NODE_EVAL_THREADS)) {
+					if (num < 0 || num > NODE_EVAL_MAX_THREADS)
+						error = 1;
+					else
+						conf.node_eval_threads = num;
+				}
 				else if (!strcmp(config_name, PARSE_PRIME_SPILL)) {
 					if (prime == PRIME || prime == ALL)
 						conf.prime_spill = res_to_num(config_value, &type);
@@ -1050,6 +1069,9 @@ init_config()
 	conf.preempt_order[0].order[1] = PREEMPT_METHOD_CHECKPOINT;
 	conf.preempt_order[0].order[2] = PREEMPT_METHOD_REQUEUE;
 	conf.dflt_opt_backfill_fuzzy = BF_DEFAULT;
+	conf.job_query_resync_time = JOB_QUERY_RESYNC_TIME;
+	conf.cant_run_cache = 1;
+	conf.decision_trace = 1;
 
 
 	/* if preempt_prio is not specified, then keep backwards compatibility
@@ -51,6 +51,8 @@
  *	restart()
  *	soft_cycle_interrupt()
  *	hard_cycle_interrupt()
+ *	request_snapshot()
+ *	request_trace()
  *	badconn()
  *	server_command()
  *	engage_authentication()
@@ -143,6 +145,13 @@ extern int do_soft_cycle_interrupt;
 extern int do_hard_cycle_interrupt;
 #endif /* localmod 030 */
 
+/* set to snapshot the input of the next scheduling cycle */
+extern int snapshot_requested;
+
+/* set to write the decision trace */
+extern int trace_requested;
+extern int trace_dump(void);
+
 int		schedreq();
 static int	engage_authentication(struct connect_handle *);
 
@@ -472,6 +481,32 @@ hard_cycle_interrupt(int sig)
 	do_hard_cycle_interrupt = 1;
 }
 #endif /* localmod 030 */
+
+/**
+ * @brief
+ * 		write a snapshot of the input of the next scheduling cycle
+ *		for pbs_sched_replay
+ *
+ * @param[in]	sig	-	signal
+ */
+void
+request_snapshot(int sig)
+{
+	snapshot_requested = 1;
+}
+
+/**
+ * @brief
+ * 		write the trace of the decisions made on jobs to TRACE_FILE
+ *
+ * @param[in]	sig	-	signal
+ */
+void
+request_trace(int sig)
+{
+	trace_requested = 1;
+}
+
 /**
  * @brief
  * 		log the bad connection message
@@ -1260,6 +1295,11 @@ main(int argc, char *argv[])
 	act.sa_handler = hard_cycle_interrupt; /* do a cycle interrupt on */
 					       /* SIGUSR2                 */
 	sigaction(SIGUSR2, &act, NULL);
+#else
+	act.sa_handler = request_snapshot;	/* snapshot the next cycle on SIGUSR1 */
+	sigaction(SIGUSR1, &act, NULL);
+	act.sa_handler = request_trace;		/* write the decision trace on SIGUSR2 */
+	sigaction(SIGUSR2, &act, NULL);
 #endif /* localmod 030 */
 
 	act.sa_handler = die;           /* bite the biscuit for all following */
@@ -1395,6 +1435,11 @@ main(int argc, char *argv[])
 	for (go=1; go;) {
 		int	cmd;
 
+		if (trace_requested) {
+			trace_requested = 0;
+			(void) trace_dump();
+		}
+
 		/*
 		 * with TPP, we don't need to drive rpp_io(), so
 		 * no need to add it to be monitored
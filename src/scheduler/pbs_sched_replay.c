@@ -0,0 +1,624 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    pbs_sched_replay.c
+ *
+ * @brief
+ * 		pbs_sched_replay.c - run scheduling cycles against a snapshot
+ *		written by pbs_sched (see snapshot.c) with no server.  The IFL
+ *		calls the scheduler makes are replaced with ones which return the
+ *		replies in the snapshot and report the scheduler's decisions.
+ *
+ * Functions included are:
+ * 	replay_decision()
+ * 	pbs_statserver()
+ * 	pbs_statsched()
+ * 	pbs_statque()
+ * 	pbs_statvnode()
+ * 	pbs_statresv()
+ * 	pbs_statrsc()
+ * 	pbs_selstat()
+ * 	pbs_statjob()
+ * 	pbs_runjob()
+ * 	pbs_asyrunjob()
+ * 	pbs_asyrunjobs()
+ * 	pbs_movejob()
+ * 	pbs_sigjob()
+ * 	pbs_holdjob()
+ * 	pbs_rlsjob()
+ * 	pbs_rerunjob()
+ * 	pbs_deljob()
+ * 	pbs_alterjob()
+ * 	pbs_alterjobs()
+ * 	pbs_confirmresv()
+ * 	pbs_defschreply()
+ * 	pbs_manager()
+ * 	pbs_geterrmsg()
+ * 	cmp_replay_time()
+ * 	replay_timediff()
+ * 	bench_formula()
+ * 	main()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <libpbs.h>
+#include <pbs_ifl.h>
+#include <pbs_error.h>
+#include <pbs_internal.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "config.h"
+#include "globals.h"
+#include "fifo.h"
+#include "profile.h"
+#include "snapshot.h"
+#include "server_info.h"
+#include "job_info.h"
+#include "formula.h"
+#include "misc.h"
+#include "pbs_version.h"
+
+/* the connection handed to scheduling_cycle() - never used for I/O */
+#define REPLAY_SD 0
+
+/* to make references happy */
+int pbs_rm_port;
+int got_sigpipe;
+int second_connection = -1;
+
+static int replay_cycle = 0;	/* which replayed cycle we're on */
+static int replay_verbose = 0;	/* report job attribute updates too */
+
+/* number of each kind of decision made in the first replayed cycle */
+static int num_run = 0;
+static int num_preempt = 0;
+static int num_confirm = 0;
+static int num_other = 0;
+
+/**
+ * @brief
+ * 		report a decision of the scheduler.  Only the decisions of the
+ *		first replayed cycle are reported; the rest are the same.
+ *
+ * @param[in]	action	-	what the scheduler did
+ * @param[in]	id	-	the job or reservation
+ * @param[in]	detail	-	more about the decision (may be NULL)
+ *
+ * @return	void
+ */
+static void
+replay_decision(char *action, char *id, char *detail)
+{
+	if (replay_cycle != 1)
+		return;
+
+	printf("%s %s%s%s\n", action, id == NULL ? "" : id,
+		detail == NULL ? "" : " ", detail == NULL ? "" : detail);
+}
+
+/*
+ *	The status calls return the replies in the snapshot.
+ */
+struct batch_status *
+pbs_statserver(int c, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_SERVER, NULL);
+}
+
+struct batch_status *
+pbs_statsched(int c, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_SCHED, NULL);
+}
+
+struct batch_status *
+pbs_statque(int c, char *id, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_QUEUE, NULL);
+}
+
+struct batch_status *
+pbs_statvnode(int c, char *id, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_VNODE, NULL);
+}
+
+struct batch_status *
+pbs_statresv(int c, char *id, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_RESV, NULL);
+}
+
+struct batch_status *
+pbs_statrsc(int c, char *id, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return snapshot_get(SNAP_RESOURCE, NULL);
+}
+
+/**
+ * @brief
+ * 		return the jobs in the snapshot for the queue in the select list
+ */
+struct batch_status *
+pbs_selstat(int c, struct attropl *attrib, struct attrl *rattrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	for (; attrib != NULL; attrib = attrib->next)
+		if (strcmp(attrib->name, ATTR_q) == 0)
+			return snapshot_get(SNAP_JOB, attrib->value);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		only used to check if a job was checkpointed when preempted.
+ *		Say it was: it is held after being requeued.
+ */
+struct batch_status *
+pbs_statjob(int c, char *id, struct attrl *attrib, char *extend)
+{
+	struct batch_status *bs;
+
+	pbs_errno = PBSE_NONE;
+	if ((bs = calloc(1, sizeof(struct batch_status))) == NULL)
+		return NULL;
+	if ((bs->attribs = calloc(1, sizeof(struct attrl))) == NULL) {
+		free(bs);
+		return NULL;
+	}
+	bs->name = strdup(id);
+	bs->attribs->name = strdup(ATTR_state);
+	bs->attribs->value = strdup("H");
+
+	return bs;
+}
+
+/*
+ *	The calls which change things on the server report the decision and
+ *	succeed.
+ */
+int
+pbs_runjob(int c, char *jobid, char *location, char *extend)
+{
+	num_run++;
+	replay_decision("run", jobid, location);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_asyrunjob(int c, char *jobid, char *location, char *extend)
+{
+	return pbs_runjob(c, jobid, location, extend);
+}
+
+int
+pbs_asyrunjobs(int c, struct attrl *jobs, struct batch_status **failed, char *extend)
+{
+	if (failed != NULL)
+		*failed = NULL;
+	for (; jobs != NULL; jobs = jobs->next)
+		pbs_runjob(c, jobs->name, jobs->value, extend);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_movejob(int c, char *jobid, char *destin, char *extend)
+{
+	num_run++;
+	replay_decision("move", jobid, destin);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_sigjob(int c, char *jobid, char *signal, char *extend)
+{
+	if (strcmp(signal, "suspend") == 0)
+		num_preempt++;
+	else
+		num_other++;
+	replay_decision(signal, jobid, NULL);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_holdjob(int c, char *jobid, char *holdtype, char *extend)
+{
+	num_preempt++;
+	replay_decision("checkpoint", jobid, NULL);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_rlsjob(int c, char *jobid, char *holdtype, char *extend)
+{
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_rerunjob(int c, char *jobid, char *extend)
+{
+	num_preempt++;
+	replay_decision("requeue", jobid, NULL);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_deljob(int c, char *jobid, char *extend)
+{
+	num_other++;
+	replay_decision("delete", jobid, extend);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_alterjob(int c, char *jobid, struct attrl *attrib, char *extend)
+{
+	char buf[MAX_LOG_SIZE];
+
+	if (replay_verbose) {
+		for (; attrib != NULL; attrib = attrib->next) {
+			snprintf(buf, sizeof(buf), "%s%s%s=%s", attrib->name,
+				attrib->resource == NULL ? "" : ".",
+				attrib->resource == NULL ? "" : attrib->resource,
+				attrib->value == NULL ? "" : attrib->value);
+			replay_decision("alter", jobid, buf);
+		}
+	}
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_alterjobs(int c, struct batch_status *jobs, struct batch_status **failed, char *extend)
+{
+	if (failed != NULL)
+		*failed = NULL;
+	for (; jobs != NULL; jobs = jobs->next)
+		pbs_alterjob(c, jobs->name, jobs->attribs, extend);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_confirmresv(int c, char *rid, char *location, unsigned long start,
+	char *extend)
+{
+	num_confirm++;
+	replay_decision(strcmp(location, "null") == 0 ? "deny" : "confirm",
+		rid, location);
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_defschreply(int c, int cmd, char *id, int err, char *txt, char *extend)
+{
+	return (pbs_errno = PBSE_NONE);
+}
+
+int
+pbs_manager(int c, int command, int objtype, char *objname,
+	struct attropl *attrib, char *extend)
+{
+	return (pbs_errno = PBSE_NONE);
+}
+
+char *
+pbs_geterrmsg(int c)
+{
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		qsort() compare function for cycle times in ascending order
+ *
+ * @return	int
+ * @retval	-1	: t1 < t2
+ * @retval	0	: t1 == t2
+ * @retval	1	: t1 > t2
+ */
+static int
+cmp_replay_time(const void *t1, const void *t2)
+{
+	double v1 = *(const double *) t1;
+	double v2 = *(const double *) t2;
+
+	if (v1 < v2)
+		return -1;
+	if (v1 > v2)
+		return 1;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		milliseconds between two times
+ *
+ * @param[in]	start	-	start time
+ * @param[in]	end	-	end time
+ *
+ * @return	double
+ */
+static double
+replay_timediff(struct timeval *start, struct timeval *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000.0 +
+		(end->tv_usec - start->tv_usec) / 1000.0;
+}
+
+/**
+ * @brief
+ * 		time evaluating the job_sort_formula for the snapshot's jobs
+ *		natively and through python, and count the jobs they disagree on
+ *
+ * @return	void
+ */
+static void
+bench_formula(void)
+{
+	server_info *sinfo;
+	sch_resource_t *native;
+	sch_resource_t ans;
+	struct timeval start;
+	struct timeval end;
+	double tnative;
+	double tpython;
+	int num_jobs;
+	int num_python = 0;
+	int num_differ = 0;
+	int i;
+
+	snapshot_rewind();
+	update_cycle_status(&cstat, snapshot_time());
+	if ((sinfo = query_server(&cstat, REPLAY_SD)) == NULL) {
+		fprintf(stderr, "Unable to query the snapshot's server\n");
+		return;
+	}
+	if (sinfo->job_formula == NULL || sinfo->jobs == NULL) {
+		printf("Formula: no job_sort_formula set\n");
+		free_server(sinfo, 1);
+		return;
+	}
+
+	num_jobs = count_array((void **) sinfo->jobs);
+	if ((native = malloc((num_jobs + 1) * sizeof(sch_resource_t))) == NULL) {
+		fprintf(stderr, "Unable to allocate memory\n");
+		free_server(sinfo, 1);
+		return;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < num_jobs; i++) {
+		if (!formula_evaluate_native(sinfo->job_formula, sinfo->jobs[i],
+			sinfo->jobs[i]->resreq, &native[i])) {
+			native[i] = formula_evaluate_python(sinfo->job_formula,
+				sinfo->jobs[i], sinfo->jobs[i]->resreq);
+			num_python++;
+		}
+	}
+	gettimeofday(&end, NULL);
+	tnative = replay_timediff(&start, &end);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < num_jobs; i++) {
+		ans = formula_evaluate_python(sinfo->job_formula, sinfo->jobs[i],
+			sinfo->jobs[i]->resreq);
+		if (ans != native[i])
+			num_differ++;
+	}
+	gettimeofday(&end, NULL);
+	tpython = replay_timediff(&start, &end);
+
+	printf("Formula: %s\n", sinfo->job_formula);
+	printf("Formula: %d jobs  native %.3f ms (%d left to python)  python %.3f ms  %d differ\n",
+		num_jobs, tnative, num_python, tpython, num_differ);
+
+	free(native);
+	free_server(sinfo, 1);
+}
+
+/**
+ * @brief
+ * 		replay a snapshot of a scheduling cycle
+ *
+ * @par	Usage:
+ *		pbs_sched_replay [-n cycles] [-d dir] [-f] [-p] [-v] snapshot
+ *
+ *		-n	run the cycle this many times and report the times
+ *		-d	directory to replay in (default: a new directory in /tmp)
+ *		-f	compare evaluating the job_sort_formula natively and in python
+ *		-p	write the cycle profile (see cycle_profile) into the directory
+ *		-v	log to stderr and report job attribute updates
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+int
+main(int argc, char *argv[])
+{
+	char snapfile[MAXPATHLEN + 1];
+	char workdir[MAXPATHLEN + 1];
+	char logfile[MAXPATHLEN + sizeof("/replay.log")];
+	char *dir = NULL;
+	int num_cycles = 1;
+	int profile = 0;
+	int formula = 0;
+	int errflg = 0;
+	double *times;
+	double total = 0;
+	struct timeval start;
+	struct timeval end;
+	int c;
+	int i;
+
+	/*the real deal or output version and exit?*/
+	execution_mode(argc, argv);
+	set_msgdaemonname("pbs_sched_replay");
+
+	while ((c = getopt(argc, argv, "n:d:fpv")) != -1) {
+		switch (c) {
+			case 'n':
+				num_cycles = atoi(optarg);
+				if (num_cycles <= 0)
+					errflg = 1;
+				break;
+			case 'd':
+				dir = optarg;
+				break;
+			case 'f':
+				formula = 1;
+				break;
+			case 'p':
+				profile = 1;
+				break;
+			case 'v':
+				replay_verbose = 1;
+				break;
+			default:
+				errflg = 1;
+		}
+	}
+	if (errflg || (argc - optind) != 1) {
+		fprintf(stderr, "Usage: pbs_sched_replay [-n cycles] [-d dir] [-f] [-p] [-v] snapshot\n");
+		fprintf(stderr, "       pbs_sched_replay --version\n");
+		exit(1);
+	}
+
+	/* pbs.conf is only needed for the zoneinfo and python paths */
+	if (pbs_loadconf(0) <= 0)
+		fprintf(stderr, "Unable to read pbs.conf, continuing without it\n");
+	if (pbs_conf.pbs_exec_path == NULL)
+		pbs_conf.pbs_exec_path = "";
+
+	if (argv[optind][0] == '/' || getcwd(snapfile, sizeof(snapfile)) == NULL)
+		snprintf(snapfile, sizeof(snapfile), "%s", argv[optind]);
+	else {
+		strncat(snapfile, "/", sizeof(snapfile) - strlen(snapfile) - 1);
+		strncat(snapfile, argv[optind], sizeof(snapfile) - strlen(snapfile) - 1);
+	}
+
+	if (dir == NULL) {
+		snprintf(workdir, sizeof(workdir), "/tmp/pbs_sched_replay.XXXXXX");
+		if (mkdtemp(workdir) == NULL) {
+			perror("mkdtemp");
+			exit(1);
+		}
+		dir = workdir;
+	}
+	if (chdir(dir) == -1) {
+		perror(dir);
+		exit(1);
+	}
+	if (getcwd(workdir, sizeof(workdir)) == NULL) {
+		perror("getcwd");
+		exit(1);
+	}
+
+	snprintf(logfile, sizeof(logfile), "%s/replay.log", workdir);
+	if (log_open(logfile, workdir) == -1) {
+		fprintf(stderr, "Unable to open log file %s\n", logfile);
+		exit(1);
+	}
+
+	if (!snapshot_load(snapfile)) {
+		fprintf(stderr, "Unable to read snapshot %s (see %s)\n", snapfile, logfile);
+		exit(1);
+	}
+
+	if (schedinit(0, NULL) != 0) {
+		fprintf(stderr, "Unable to initialize the scheduler\n");
+		exit(1);
+	}
+
+	/* the snapshot holds full job statuses and the replies for remote peer
+	 * queues, so query everything through the one replayed connection
+	 */
+	conf.incremental_job_query = 0;
+	for (i = 0; i < NUM_PEERS && conf.peer_queues[i].local_queue != NULL; i++)
+		conf.peer_queues[i].remote_server = NULL;
+	conf.cycle_profile = profile;
+	conf.logstderr = replay_verbose;
+
+	if ((times = malloc(num_cycles * sizeof(double))) == NULL) {
+		fprintf(stderr, "Unable to allocate memory\n");
+		exit(1);
+	}
+
+	printf("Replaying %s in %s\n", snapfile, workdir);
+	for (replay_cycle = 1; replay_cycle <= num_cycles; replay_cycle++) {
+		snapshot_rewind();
+		prof_cycle_start();
+		gettimeofday(&start, NULL);
+		scheduling_cycle(REPLAY_SD, NULL);
+		gettimeofday(&end, NULL);
+		prof_cycle_end(REPLAY_SD);
+
+		times[replay_cycle - 1] = replay_timediff(&start, &end);
+		total += times[replay_cycle - 1];
+	}
+
+	qsort(times, num_cycles, sizeof(double), cmp_replay_time);
+	printf("Decisions: %d run, %d preempted, %d reservations, %d other\n",
+		num_run, num_preempt, num_confirm, num_other);
+	printf("Cycles: %d  min %.3f ms  median %.3f ms  mean %.3f ms  max %.3f ms\n",
+		num_cycles, times[0], times[num_cycles / 2], total / num_cycles,
+		times[num_cycles - 1]);
+
+	if (formula)
+		bench_formula();
+
+	free(times);
+	free_snapshot();
+	log_close(0);
+
+	return 0;
+}
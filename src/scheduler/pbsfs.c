@@ -172,7 +172,7 @@ main(int argc, char *argv[])
 		fprintf(stderr, "Error in preloading fairshare information\n");
 		return 1;
 	}
-	if (parse_group(RESGROUP_FILE, conf.fairshare->root) == 0)
+	if (parse_group(RESGROUP_FILE, conf.fairshare) == 0)
 		return 1;
 
 	if (flags & FS_TRIM_TREE) {
@@ -194,14 +194,14 @@ main(int argc, char *argv[])
 	else if (flags & FS_DECAY)
 		decay_fairshare_tree(conf.fairshare->root);
 	else if (flags & (FS_GET | FS_SET | FS_ADD | FS_COMP)) {
-		ginfo = find_group_info(argv[2], conf.fairshare->root);
+		ginfo = find_group_info(argv[2], conf.fairshare);
 
 		if (ginfo == NULL) {
 			fprintf(stderr, "Fairshare Entity %s does not exist.\n", argv[2]);
 			return 1;
 		}
 		if (flags & FS_COMP) {
-			ginfo2 = find_group_info(argv[3], conf.fairshare->root);
+			ginfo2 = find_group_info(argv[3], conf.fairshare);
 
 			if (ginfo2 == NULL) {
 				fprintf(stderr, "Fairshare Entity %s does not exist.\n", argv[3]);
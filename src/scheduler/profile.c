@@ -0,0 +1,516 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    profile.c
+ *
+ * @brief
+ * 	profile.c - profiler of the phases of a scheduling cycle.  When
+ *	cycle_profile is set, the wall time, CPU time and heap growth of each
+ *	phase are added up over the cycle, along with the time spent on each
+ *	job considered.  At the end of the cycle a JSON line is appended to
+ *	PROFILE_FILE and the phase times are added to a rolling history whose
+ *	percentiles are sent to the server in the sched_cycle_profile
+ *	scheduler attribute.
+ *
+ * Functions included are:
+ * 	prof_wall_now()
+ * 	prof_cpu_now()
+ * 	prof_heap_now()
+ * 	prof_cmp_double()
+ * 	prof_percentile()
+ * 	prof_history_percentiles()
+ * 	prof_write_cycle()
+ * 	prof_update_attr()
+ * 	prof_cycle_start()
+ * 	prof_cycle_end()
+ * 	prof_start()
+ * 	prof_stop()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <log.h>
+#include <pbs_ifl.h>
+#include "constant.h"
+#include "config.h"
+#include "data_types.h"
+#include "globals.h"
+#include "misc.h"
+#include "profile.h"
+
+/* the totals of one phase over a cycle, and its rolling history */
+struct prof_stat {
+	int depth;			/* nesting of prof_start() calls */
+	int count;			/* number of times the phase ran */
+	double start_wall;		/* when the outermost prof_start() was */
+	double start_cpu;
+	long start_heap;
+	double wall;			/* total wall time in the cycle (ms) */
+	double cpu;			/* total CPU time in the cycle (ms) */
+	double max_wall;		/* longest single run of the phase (ms) */
+	long heap;			/* heap growth in the cycle (bytes) */
+	double history[PROF_HISTORY];	/* wall time of the last cycles */
+};
+
+/* name of each phase and if its heap growth is measured.  The heap is not
+ * measured for the phases which run many times a cycle, because reading
+ * the malloc statistics walks the heap's free lists.
+ */
+static struct {
+	char *name;
+	int heap;
+} prof_phase_info[PROF_PHASE_LAST] = {
+	{"query_server", 1},
+	{"create_placement_sets", 1},
+	{"sort_jobs", 0},
+	{"job", 0},
+	{"add_job_to_calendar", 0},
+	{"find_and_preempt_jobs", 0},
+	{"update_jobs_cant_run", 0}
+};
+
+static struct prof_stat prof_stats[PROF_PHASE_LAST];
+static struct prof_stat prof_cycle;	/* the whole cycle */
+static int prof_active = 0;		/* profiling the current cycle */
+static long prof_num_cycles = 0;	/* cycles profiled */
+static int prof_hist_ind = 0;		/* next slot in the histories */
+static int prof_hist_size = 0;		/* valid slots in the histories */
+static time_t prof_attr_time = 0;	/* last time the attribute was sent */
+
+/* wall time of each job considered in the cycle */
+static double *prof_job_times = NULL;
+static int prof_num_jobs = 0;
+static int prof_job_times_size = 0;
+
+/**
+ * @brief
+ * 		the current wall clock time in milliseconds
+ *
+ * @return	double
+ */
+static double
+prof_wall_now(void)
+{
+#ifdef WIN32
+	return (double) GetTickCount();
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#endif
+}
+
+/**
+ * @brief
+ * 		the CPU time used by the scheduler in milliseconds
+ *
+ * @return	double
+ */
+static double
+prof_cpu_now(void)
+{
+	return (double) clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief
+ * 		the number of bytes allocated from the heap
+ *
+ * @return	long
+ * @retval	0	: not available on this platform
+ */
+static long
+prof_heap_now(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 mi;
+
+	mi = mallinfo2();
+	return (long) mi.uordblks + (long) mi.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo mi;
+
+	mi = mallinfo();
+	return (long) mi.uordblks + (long) mi.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief
+ * 		qsort() compare function for doubles in ascending order
+ *
+ * @return	int
+ * @retval	-1	: d1 < d2
+ * @retval	0	: d1 == d2
+ * @retval	1	: d1 > d2
+ */
+static int
+prof_cmp_double(const void *d1, const void *d2)
+{
+	double v1 = *(const double *) d1;
+	double v2 = *(const double *) d2;
+
+	if (v1 < v2)
+		return -1;
+	if (v1 > v2)
+		return 1;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		find a percentile of a sorted array (nearest rank)
+ *
+ * @param[in]	sorted	-	values sorted in ascending order
+ * @param[in]	num	-	number of values
+ * @param[in]	pct	-	the percentile (1-100)
+ *
+ * @return	double
+ * @retval	0	: no values
+ */
+static double
+prof_percentile(double *sorted, int num, int pct)
+{
+	int ind;
+
+	if (sorted == NULL || num <= 0)
+		return 0;
+
+	ind = (num * pct + 99) / 100 - 1;
+	if (ind < 0)
+		ind = 0;
+	if (ind >= num)
+		ind = num - 1;
+
+	return sorted[ind];
+}
+
+/**
+ * @brief
+ * 		calculate the 50th, 90th and 99th percentiles of a phase's history
+ *
+ * @param[in]	stat	-	the phase
+ * @param[out]	pcts	-	the three percentiles
+ *
+ * @return	void
+ */
+static void
+prof_history_percentiles(struct prof_stat *stat, double pcts[3])
+{
+	double sorted[PROF_HISTORY];
+
+	memcpy(sorted, stat->history, prof_hist_size * sizeof(double));
+	qsort(sorted, prof_hist_size, sizeof(double), prof_cmp_double);
+
+	pcts[0] = prof_percentile(sorted, prof_hist_size, 50);
+	pcts[1] = prof_percentile(sorted, prof_hist_size, 90);
+	pcts[2] = prof_percentile(sorted, prof_hist_size, 99);
+}
+
+/**
+ * @brief
+ * 		append the profile of the cycle to PROFILE_FILE as a JSON line
+ *
+ * @param[in]	cycle_time	-	the time the cycle started
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+prof_write_cycle(time_t cycle_time)
+{
+	FILE *fp;
+	struct prof_stat *stat;
+	int i;
+
+	if ((fp = fopen(PROFILE_FILE, "a")) == NULL) {
+		sprintf(log_buffer, "Error opening file %s", PROFILE_FILE);
+		log_err(errno, __func__, log_buffer);
+		return 0;
+	}
+
+	/* prof_job_times was sorted by the caller */
+	fprintf(fp, "{\"time\": %ld, \"cycle\": %ld, \"wall_ms\": %.3f, "
+		"\"cpu_ms\": %.3f, \"heap_bytes\": %ld, \"jobs_considered\": %d, "
+		"\"job_ms\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+		"\"max\": %.3f}, \"phases\": {",
+		(long) cycle_time, prof_num_cycles, prof_cycle.wall,
+		prof_cycle.cpu, prof_cycle.heap, prof_num_jobs,
+		prof_percentile(prof_job_times, prof_num_jobs, 50),
+		prof_percentile(prof_job_times, prof_num_jobs, 90),
+		prof_percentile(prof_job_times, prof_num_jobs, 99),
+		prof_percentile(prof_job_times, prof_num_jobs, 100));
+
+	for (i = 0; i < PROF_PHASE_LAST; i++) {
+		stat = &prof_stats[i];
+		fprintf(fp, "%s\"%s\": {\"count\": %d, \"wall_ms\": %.3f, "
+			"\"cpu_ms\": %.3f, \"max_ms\": %.3f",
+			i == 0 ? "" : ", ", prof_phase_info[i].name,
+			stat->count, stat->wall, stat->cpu, stat->max_wall);
+		if (prof_phase_info[i].heap)
+			fprintf(fp, ", \"heap_bytes\": %ld", stat->heap);
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "}}\n");
+
+	fclose(fp);
+	return 1;
+}
+
+/**
+ * @brief
+ * 		send the rolling percentiles of the phases to the server in the
+ *		sched_cycle_profile attribute.  The value is a list of
+ *		phase=p50/p90/p99 in milliseconds.
+ *
+ * @param[in]	pbs_sd	-	connection descriptor to the pbs server
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+prof_update_attr(int pbs_sd)
+{
+	char buf[1024];
+	double pcts[3];
+	struct attropl attr;
+	int len;
+	int i;
+
+	len = snprintf(buf, sizeof(buf), "cycles=%d", prof_hist_size);
+
+	prof_history_percentiles(&prof_cycle, pcts);
+	len += snprintf(buf + len, sizeof(buf) - len, " cycle=%.1f/%.1f/%.1f",
+		pcts[0], pcts[1], pcts[2]);
+
+	for (i = 0; i < PROF_PHASE_LAST && len < (int) sizeof(buf); i++) {
+		prof_history_percentiles(&prof_stats[i], pcts);
+		len += snprintf(buf + len, sizeof(buf) - len, " %s=%.1f/%.1f/%.1f",
+			prof_phase_info[i].name, pcts[0], pcts[1], pcts[2]);
+	}
+
+	attr.name = ATTR_sched_cycle_profile;
+	attr.resource = NULL;
+	attr.value = buf;
+	attr.op = SET;
+	attr.next = NULL;
+
+	if (pbs_manager(pbs_sd, MGR_CMD_SET, MGR_OBJ_SCHED, "scheduler",
+		&attr, NULL) != 0) {
+		schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			"Unable to update the sched_cycle_profile attribute");
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		start profiling a scheduling cycle.  Nothing is profiled unless
+ *		cycle_profile is set in the scheduler's config.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+prof_cycle_start(void)
+{
+	int i;
+
+	prof_active = conf.cycle_profile;
+	if (!prof_active)
+		return;
+
+	for (i = 0; i < PROF_PHASE_LAST; i++) {
+		prof_stats[i].depth = 0;
+		prof_stats[i].count = 0;
+		prof_stats[i].wall = 0;
+		prof_stats[i].cpu = 0;
+		prof_stats[i].max_wall = 0;
+		prof_stats[i].heap = 0;
+	}
+	prof_num_jobs = 0;
+
+	prof_cycle.start_wall = prof_wall_now();
+	prof_cycle.start_cpu = prof_cpu_now();
+	prof_cycle.start_heap = prof_heap_now();
+}
+
+/**
+ * @brief
+ * 		finish profiling a scheduling cycle.  The cycle is written to
+ *		PROFILE_FILE and added to the rolling history.  The history's
+ *		percentiles are sent to the server at most every
+ *		PROF_ATTR_UPDATE_TIME seconds.
+ *
+ * @param[in]	pbs_sd	-	connection descriptor to the pbs server
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+prof_cycle_end(int pbs_sd)
+{
+	time_t now;
+	int i;
+
+	if (!prof_active)
+		return;
+	prof_active = 0;
+	prof_num_cycles++;
+
+	prof_cycle.wall = prof_wall_now() - prof_cycle.start_wall;
+	prof_cycle.cpu = prof_cpu_now() - prof_cycle.start_cpu;
+	prof_cycle.heap = prof_heap_now() - prof_cycle.start_heap;
+
+	prof_cycle.history[prof_hist_ind] = prof_cycle.wall;
+	for (i = 0; i < PROF_PHASE_LAST; i++)
+		prof_stats[i].history[prof_hist_ind] = prof_stats[i].wall;
+	prof_hist_ind = (prof_hist_ind + 1) % PROF_HISTORY;
+	if (prof_hist_size < PROF_HISTORY)
+		prof_hist_size++;
+
+	if (prof_num_jobs > 0)
+		qsort(prof_job_times, prof_num_jobs, sizeof(double), prof_cmp_double);
+
+	time(&now);
+	prof_write_cycle(now);
+
+	if (pbs_sd >= 0 && !got_sigpipe &&
+		now - prof_attr_time >= PROF_ATTR_UPDATE_TIME) {
+		if (prof_update_attr(pbs_sd))
+			prof_attr_time = now;
+	}
+}
+
+/**
+ * @brief
+ * 		start timing a phase of the cycle.  Nested calls for the same
+ *		phase are only timed once.
+ *
+ * @param[in]	phase	-	the phase
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+prof_start(enum prof_phase phase)
+{
+	struct prof_stat *stat;
+
+	if (!prof_active)
+		return;
+
+	stat = &prof_stats[phase];
+	if (stat->depth++ > 0)
+		return;
+
+	stat->start_wall = prof_wall_now();
+	stat->start_cpu = prof_cpu_now();
+	if (prof_phase_info[phase].heap)
+		stat->start_heap = prof_heap_now();
+}
+
+/**
+ * @brief
+ * 		stop timing a phase of the cycle and add it to the cycle's totals
+ *
+ * @param[in]	phase	-	the phase
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+prof_stop(enum prof_phase phase)
+{
+	struct prof_stat *stat;
+	double *tmp_times;
+	double wall;
+
+	if (!prof_active)
+		return;
+
+	stat = &prof_stats[phase];
+	if (stat->depth == 0 || --stat->depth > 0)
+		return;
+
+	wall = prof_wall_now() - stat->start_wall;
+	stat->wall += wall;
+	stat->cpu += prof_cpu_now() - stat->start_cpu;
+	if (prof_phase_info[phase].heap)
+		stat->heap += prof_heap_now() - stat->start_heap;
+	if (wall > stat->max_wall)
+		stat->max_wall = wall;
+	stat->count++;
+
+	if (phase == PROF_JOB) {
+		if (prof_num_jobs == prof_job_times_size) {
+			tmp_times = realloc(prof_job_times,
+				(prof_job_times_size * 2 + 64) * sizeof(double));
+			if (tmp_times == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				return;
+			}
+			prof_job_times = tmp_times;
+			prof_job_times_size = prof_job_times_size * 2 + 64;
+		}
+		prof_job_times[prof_num_jobs++] = wall;
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+#ifndef	_PROFILE_H
+#define	_PROFILE_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* the phases of a scheduling cycle which are profiled */
+enum prof_phase {
+	PROF_QUERY_SERVER,
+	PROF_PLACEMENT_SETS,
+	PROF_SORT_JOBS,
+	PROF_JOB,			/* one job considered in main_sched_loop() */
+	PROF_CALENDAR,
+	PROF_PREEMPT,
+	PROF_CANT_RUN,
+	PROF_PHASE_LAST
+};
+
+/* start profiling a scheduling cycle if cycle_profile is set */
+void prof_cycle_start(void);
+
+/*
+ *	prof_cycle_end - write the cycle's profile to PROFILE_FILE and
+ *			 update the sched_cycle_profile attribute
+ */
+void prof_cycle_end(int pbs_sd);
+
+/* start timing a phase of the cycle */
+void prof_start(enum prof_phase phase);
+
+/* stop timing a phase of the cycle */
+void prof_stop(enum prof_phase phase);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _PROFILE_H */
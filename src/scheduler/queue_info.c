@@ -85,6 +85,7 @@
 #include "node_partition.h"
 #include "limits_if.h"
 #include "pbs_internal.h"
+#include "snapshot.h"
 
 
 /**
@@ -148,7 +149,9 @@ query_queues(status *policy, int pbs_sd, server_info *sinfo)
 		return NULL;
 
 	/* get queue info from PBS server */
-	if ((queues = pbs_statque(pbs_sd, NULL, NULL, NULL)) == NULL) {
+	queues = pbs_statque(pbs_sd, NULL, NULL, NULL);
+	snapshot_put(SNAP_QUEUE, NULL, queues);
+	if (queues == NULL) {
 		errmsg = pbs_geterrmsg(pbs_sd);
 		if (errmsg == NULL)
 			errmsg = "";
@@ -952,10 +955,18 @@ queue_info *
 find_queue_info(queue_info **qinfo_arr, char *name)
 {
 	int i;
+	void *qinfo;
 
 	if (qinfo_arr == NULL)
 		return NULL;
 
+	/* the server's queues are indexed by name */
+	if (qinfo_arr[0] != NULL && qinfo_arr[0]->server != NULL &&
+		qinfo_arr == qinfo_arr[0]->server->queues &&
+		find_obj_index_by_name(qinfo_arr[0]->server->queues_idx,
+		(void **) qinfo_arr, name, &qinfo))
+		return qinfo;
+
 	for (i = 0; qinfo_arr[i] != NULL && strcmp(name, qinfo_arr[i]->name); i++)
 		;
 
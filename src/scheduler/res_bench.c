@@ -0,0 +1,300 @@
+/**
+ * @file    res_bench.c
+ *
+ * @brief
+ * 		res_bench.c - microbenchmark of check_avail_resources() on a
+ *		synthetic site with many custom resources.  Each run is done twice:
+ *		once searching the resource lists linearly (the resdef indexes are
+ *		cleared so find_resource() can't use the lookup table) and once
+ *		with the lookup table.
+ *
+ *	Build by linking against libpbs_sched.a and the PBS libraries, e.g.
+ *	cc -I../include res_bench.c libpbs_sched.a ../lib/Libutil/libutil.a ...
+ *
+ *	usage: res_bench [num_resources [num_requested [iterations]]]
+ *
+ * Functions included are:
+ * 	main()
+ * 	create_bench_resdefs()
+ * 	create_bench_resources()
+ * 	create_bench_request()
+ * 	run_bench()
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "data_types.h"
+#include "globals.h"
+#include "check.h"
+#include "resource.h"
+#include "resource_resv.h"
+#include "server_info.h"
+#include "misc.h"
+
+/* 
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/* to make references happy */
+int pbs_rm_port;
+int got_sigpipe;
+char *msg_daemonname = "res_bench";
+
+#define BENCH_NUM_RES	200
+#define BENCH_NUM_REQ	10
+#define BENCH_ITERATIONS	1000000
+
+/* Prototypes */
+resdef **create_bench_resdefs(int num_res);
+resource *create_bench_resources(resdef **defs);
+resource_req *create_bench_request(resdef **defs, int num_req);
+double run_bench(resource *reslist, resource_req *reqlist, int iterations);
+
+/**
+ * @brief
+ * 		entry point to res_bench.c
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: error
+ */
+int
+main(int argc, char *argv[])
+{
+	resource *reslist;
+	resource_req *reqlist;
+	int num_res = BENCH_NUM_RES;
+	int num_req = BENCH_NUM_REQ;
+	int iterations = BENCH_ITERATIONS;
+	double linear;
+	double indexed;
+	int i;
+
+	if (argc > 1)
+		num_res = atoi(argv[1]);
+	if (argc > 2)
+		num_req = atoi(argv[2]);
+	if (argc > 3)
+		iterations = atoi(argv[3]);
+
+	if (num_res <= 0 || num_req <= 0 || num_req > num_res || iterations <= 0) {
+		fprintf(stderr, "usage: %s [num_resources [num_requested [iterations]]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	if ((allres = create_bench_resdefs(num_res)) == NULL)
+		return 1;
+
+	/* linear search: find_resource() only uses the table for indexed resdefs */
+	for (i = 0; allres[i] != NULL; i++)
+		allres[i]->index = -1;
+
+	reslist = create_bench_resources(allres);
+	reqlist = create_bench_request(allres, num_req);
+	if (reslist == NULL || reqlist == NULL)
+		return 1;
+
+	linear = run_bench(reslist, reqlist, iterations);
+
+	for (i = 0; allres[i] != NULL; i++)
+		allres[i]->index = i;
+
+	indexed = run_bench(reslist, reqlist, iterations);
+
+	printf("%d resources, %d requested, %d iterations\n",
+		num_res, num_req, iterations);
+	printf("linear search: %12.0f checks/sec\n", linear);
+	printf("lookup table:  %12.0f checks/sec\n", indexed);
+	if (linear > 0)
+		printf("speedup:       %12.2fx\n", indexed / linear);
+
+	free_resource_list(reslist);
+	free_resource_req_list(reqlist);
+	free_resdef_array(allres);
+
+	return 0;
+}
+
+/**
+ * @brief
+ * 		create the resource definitions of the synthetic site.  They are
+ *		all consumable longs named res0 through resN.
+ *
+ * @param[in]	num_res	-	number of resource definitions
+ *
+ * @return	resdef **
+ * @retval	NULL terminated array of resource definitions
+ * @retval	NULL	: on error
+ */
+resdef **
+create_bench_resdefs(int num_res)
+{
+	resdef **defs;
+	char buf[32];
+	int i;
+
+	if ((defs = calloc(num_res + 1, sizeof(resdef *))) == NULL)
+		return NULL;
+
+	for (i = 0; i < num_res; i++) {
+		if ((defs[i] = new_resdef()) == NULL)
+			return NULL;
+		sprintf(buf, "res%d", i);
+		defs[i]->name = string_dup(buf);
+		defs[i]->type.is_consumable = 1;
+		defs[i]->type.is_num = 1;
+		defs[i]->type.is_long = 1;
+		defs[i]->index = i;
+	}
+	defs[num_res] = NULL;
+
+	return defs;
+}
+
+/**
+ * @brief
+ * 		create a vnode's resource list with every resource set
+ *
+ * @param[in]	defs	-	the resource definitions
+ *
+ * @return	resource *
+ * @retval	resource list
+ * @retval	NULL	: on error
+ */
+resource *
+create_bench_resources(resdef **defs)
+{
+	resource *head = NULL;
+	resource *tail = NULL;
+	resource *res;
+	int i;
+
+	for (i = 0; defs[i] != NULL; i++) {
+		if ((res = new_resource()) == NULL)
+			return NULL;
+		res->def = defs[i];
+		res->name = defs[i]->name;
+		res->type = defs[i]->type;
+		res->orig_str_avail = string_dup("100");
+		res->avail = 100;
+		res->assigned = 10;
+
+		if (tail == NULL)
+			head = res;
+		else
+			tail->next = res;
+		tail = res;
+	}
+
+	return head;
+}
+
+/**
+ * @brief
+ * 		create a request for resources spread across the resource list
+ *
+ * @param[in]	defs	-	the resource definitions
+ * @param[in]	num_req	-	number of resources to request
+ *
+ * @return	resource_req *
+ * @retval	request list
+ * @retval	NULL	: on error
+ */
+resource_req *
+create_bench_request(resdef **defs, int num_req)
+{
+	resource_req *head = NULL;
+	resource_req *req;
+	int num_res;
+	int i;
+
+	num_res = count_array((void **) defs);
+
+	for (i = 0; i < num_req; i++) {
+		if ((req = new_resource_req()) == NULL)
+			return NULL;
+		req->def = defs[(i * num_res) / num_req + (num_res / num_req) - 1];
+		req->name = req->def->name;
+		req->type = req->def->type;
+		req->amount = 1;
+		req->next = head;
+		head = req;
+	}
+
+	return head;
+}
+
+/**
+ * @brief
+ * 		time check_avail_resources() of a request against a resource list
+ *
+ * @param[in]	reslist	-	the resource list
+ * @param[in]	reqlist	-	the request
+ * @param[in]	iterations	-	number of times to call check_avail_resources()
+ *
+ * @return	double
+ * @retval	number of checks per second
+ */
+double
+run_bench(resource *reslist, resource_req *reqlist, int iterations)
+{
+	struct timeval start;
+	struct timeval end;
+	double secs;
+	long long chunks = 0;
+	int i;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < iterations; i++)
+		chunks += check_avail_resources(reslist, reqlist,
+			UNSET_RES_ZERO, NULL, INSUFFICIENT_RESOURCE, NULL);
+	gettimeofday(&end, NULL);
+
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+
+	/* use the result so the calls can't be optimized away */
+	if (chunks < 0)
+		printf("check_avail_resources() failed\n");
+
+	if (secs <= 0)
+		return 0;
+
+	return iterations / secs;
+}
@@ -88,6 +88,8 @@
 #include "limits_if.h"
 #include "sort.h"
 #include "parse.h"
+#include "snapshot.h"
+#include "formula.h"
 
 
 
@@ -123,7 +125,9 @@ query_resources(int pbs_sd)
 	char *errmsg;
 	int error = 0;
 
-	if ((bs = pbs_statrsc(pbs_sd, NULL, NULL, "p")) == NULL) {
+	bs = pbs_statrsc(pbs_sd, NULL, NULL, "p");
+	snapshot_put(SNAP_RESOURCE, NULL, bs);
+	if (bs == NULL) {
 		errmsg = pbs_geterrmsg(pbs_sd);
 		if (errmsg == NULL)
 			errmsg = "";
@@ -220,6 +224,11 @@ query_resources(int pbs_sd)
 		free_resdef_array(defarr);
 		return NULL;
 	}
+
+	/* the index is used to find resources in long resource lists */
+	for (i = 0; defarr[i] != NULL; i++)
+		defarr[i]->index = i;
+
 	return defarr;
 }
 
@@ -326,6 +335,7 @@ new_resdef(void)
 	}
 
 	newdef->name = NULL;
+	newdef->index = -1;
 	/* calloc will have zeroed flags and the type structure */
 
 	return newdef;
@@ -576,6 +586,7 @@ reset_global_resource_ptrs(void)
 		boolres = NULL;
 	}
 	update_sorting_defs(SD_FREE);
+	free_formula_cache();
 
 	/* The above references into this array.  We now free the memory */
 	if (allres != NULL) {
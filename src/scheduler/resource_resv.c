@@ -48,6 +48,7 @@
  * 	free_resource_resv()
  * 	dup_resource_resv_array()
  * 	dup_resource_resv()
+ * 	find_resresv_array_index()
  * 	find_resource_resv()
  * 	find_resource_resv_by_rank()
  * 	find_resource_resv_by_time()
@@ -75,6 +76,7 @@
  * 	new_place()
  * 	free_place()
  * 	dup_place()
+ * 	share_place()
  * 	new_chunk()
  * 	dup_chunk_array()
  * 	dup_chunk()
@@ -82,11 +84,17 @@
  * 	free_chunk()
  * 	new_selspec()
  * 	dup_selspec()
+ * 	share_selspec()
  * 	free_selspec()
  * 	compare_res_to_str()
  * 	compare_non_consumable()
  * 	create_select_from_nspec()
  * 	in_runnable_state()
+ * 	resresv_set_key()
+ * 	resresv_set_match()
+ * 	create_resresv_sets()
+ * 	clear_resresv_sets()
+ * 	free_resresv_set_array()
  *
  */
 
@@ -179,6 +187,7 @@ new_resource_resv()
 
 	resresv->node_set_str = NULL;
 	resresv->node_set = NULL;
+	resresv->ec_index = UNSPECIFIED;
 
 	return resresv;
 }
@@ -349,7 +358,10 @@ dup_resource_resv(resource_resv *oresresv,
 	nresresv->project = string_dup(oresresv->project);
 
 	nresresv->nodepart_name = string_dup(oresresv->nodepart_name);
-	nresresv->select = dup_selspec(oresresv->select);
+	/* the select and place specs are not modified once they are queried,
+	 * so they are shared with the original rather than copied
+	 */
+	nresresv->select = share_selspec(oresresv->select);
 
 	nresresv->is_invalid = oresresv->is_invalid;
 	nresresv->can_not_fit = oresresv->can_not_fit;
@@ -361,6 +373,7 @@ dup_resource_resv(resource_resv *oresresv,
 
 	nresresv->sch_priority = oresresv->sch_priority;
 	nresresv->rank = oresresv->rank;
+	nresresv->ec_index = oresresv->ec_index;
 	nresresv->qtime = oresresv->qtime;
 
 	nresresv->start = oresresv->start;
@@ -370,7 +383,7 @@ dup_resource_resv(resource_resv *oresresv,
 
 	nresresv->resreq = dup_resource_req_list(oresresv->resreq);
 
-	nresresv->place_spec = dup_place(oresresv->place_spec);
+	nresresv->place_spec = share_place(oresresv->place_spec);
 
 	nresresv->aoename = string_dup(oresresv->aoename);
 
@@ -445,6 +458,36 @@ dup_resource_resv(resource_resv *oresresv,
 	return nresresv;
 }
 
+/**
+ * @brief
+ * 		find the server's name and rank index of a resource_resv array
+ *
+ * @param[in]	resresv_arr	-	array of resource_resvs
+ *
+ * @return	obj_index *
+ * @retval	the index if resresv_arr is the server's jobs, all_resresv or
+ *		resvs array
+ * @retval	NULL	: resresv_arr has no index
+ */
+static obj_index *
+find_resresv_array_index(resource_resv **resresv_arr)
+{
+	server_info *sinfo;
+
+	if (resresv_arr == NULL || resresv_arr[0] == NULL ||
+		(sinfo = resresv_arr[0]->server) == NULL)
+		return NULL;
+
+	if (resresv_arr == sinfo->jobs)
+		return sinfo->jobs_idx;
+	if (resresv_arr == sinfo->all_resresv)
+		return sinfo->all_resresv_idx;
+	if (resresv_arr == sinfo->resvs)
+		return sinfo->resvs_idx;
+
+	return NULL;
+}
+
 /**
  * @brief
  * 		find a resource_resv by name
@@ -461,9 +504,15 @@ resource_resv *
 find_resource_resv(resource_resv **resresv_arr, char *name)
 {
 	int i;
+	void *resresv;
+
 	if (resresv_arr == NULL || name == NULL)
 		return NULL;
 
+	if (find_obj_index_by_name(find_resresv_array_index(resresv_arr),
+		(void **) resresv_arr, name, &resresv))
+		return resresv;
+
 	for (i = 0; resresv_arr[i] != NULL && strcmp(resresv_arr[i]->name, name);i++)
 		;
 
@@ -486,9 +535,15 @@ resource_resv *
 find_resource_resv_by_rank(resource_resv **resresv_arr, int rank)
 {
 	int i;
+	void *resresv;
+
 	if (resresv_arr == NULL)
 		return NULL;
 
+	if (find_obj_index_by_rank(find_resresv_array_index(resresv_arr),
+		(void **) resresv_arr, rank, &resresv))
+		return resresv;
+
 	for (i = 0; resresv_arr[i] != NULL && resresv_arr[i]->rank != rank; i++)
 		;
 
@@ -1463,6 +1518,7 @@ new_place()
 	pl->exclhost = 0;
 
 	pl->group = NULL;
+	pl->refcount = 1;
 
 	return pl;
 }
@@ -1482,6 +1538,10 @@ free_place(place *pl)
 	if (pl == NULL)
 		return;
 
+	/* still in use by another owner */
+	if (--pl->refcount > 0)
+		return;
+
 	if (pl->group != NULL)
 		free(pl->group);
 
@@ -1523,6 +1583,31 @@ dup_place(place *pl)
 	return newpl;
 }
 
+/**
+ * @brief
+ *		share_place - share a place structure with a new owner.  The
+ *		placement spec is not copied.  Each owner frees it with free_place()
+ *		and it is only freed when the last owner does.
+ *
+ * @note
+ *		A shared placement spec must not be modified.
+ *
+ * @param[in]	pl	-	the place structure to share
+ *
+ * @return	pl
+ *
+ */
+place *
+share_place(place *pl)
+{
+	if (pl == NULL)
+		return NULL;
+
+	pl->refcount++;
+
+	return pl;
+}
+
 /**
  * @brief
  *		new_chunk - constructor for chunk
@@ -1544,6 +1629,8 @@ new_chunk()
 	ch->seq_num = 0;
 	ch->str_chunk = NULL;
 	ch->req = NULL;
+	ch->node_filter = NULL;
+	ch->node_filter_seq = 0;
 
 	return ch;
 }
@@ -1665,6 +1752,9 @@ free_chunk(chunk *ch)
 	if (ch->req != NULL)
 		free_resource_req_list(ch->req);
 
+	if (ch->node_filter != NULL)
+		free(ch->node_filter);
+
 	free(ch);
 }
 
@@ -1689,6 +1779,7 @@ new_selspec()
 	spec->total_cpus = 0;
 	spec->defs = NULL;
 	spec->chunks = NULL;
+	spec->refcount = 1;
 
 	return spec;
 }
@@ -1728,6 +1819,33 @@ dup_selspec(selspec *oldspec)
 	return newspec;
 }
 
+/**
+ * @brief
+ *		share_selspec - share a selspec with a new owner.  The selspec is
+ *		not copied.  Each owner frees it with free_selspec() and it is only
+ *		freed when the last owner does.  This is used when duplicating
+ *		universes for simulation, where the select specs of the jobs and
+ *		reservations are only ever read.
+ *
+ * @note
+ *		A shared selspec must not be modified.  Use dup_selspec() to get a
+ *		private copy.
+ *
+ * @param[in]	spec	-	selspec to share
+ *
+ * @return	spec
+ */
+selspec *
+share_selspec(selspec *spec)
+{
+	if (spec == NULL)
+		return NULL;
+
+	spec->refcount++;
+
+	return spec;
+}
+
 /**
  * @brief
  *		free_selspec - destructor for selspec
@@ -1740,6 +1858,10 @@ free_selspec(selspec *spec)
 	if (spec == NULL)
 		return;
 
+	/* still in use by another owner */
+	if (--spec->refcount > 0)
+		return;
+
 	if (spec->defs != NULL)
 		free(spec->defs);
 
@@ -1954,3 +2076,278 @@ in_runnable_state(resource_resv *resresv)
 
 	return 0;
 }
+
+/**
+ * @brief
+ * 		hash what is checked to see if a job can run into the key
+ *		of its equivalence class.  The resource_req list is folded in
+ *		independent of its order.
+ *
+ * @param[in]	resresv	-	the job
+ *
+ * @return	unsigned long long
+ * @retval	the key
+ */
+unsigned long long
+resresv_set_key(resource_resv *resresv)
+{
+	unsigned long long key;
+	unsigned long long reqkey = 0;
+	resource_req *req;
+	place *pl;
+	int i;
+
+	key = hash_str(HASH_INIT, resresv->job->queue->name);
+	key = hash_str(key, resresv->user);
+	key = hash_str(key, resresv->group);
+	key = hash_str(key, resresv->project);
+	key = hash_str(key, resresv->aoename);
+
+	for (i = 0; resresv->select->chunks[i] != NULL; i++) {
+		key = hash_str(key, resresv->select->chunks[i]->str_chunk);
+		key = hash_bytes(key, &resresv->select->chunks[i]->num_chunks,
+			sizeof(resresv->select->chunks[i]->num_chunks));
+	}
+
+	pl = resresv->place_spec;
+	i = pl->free | pl->pack << 1 | pl->scatter << 2 | pl->vscatter << 3 |
+		pl->excl << 4 | pl->exclhost << 5 | pl->share << 6 |
+		resresv->is_shrink_to_fit << 7 | resresv->job->is_array << 8;
+	key = hash_bytes(key, &i, sizeof(i));
+	key = hash_str(key, pl->group);
+
+	for (req = resresv->resreq; req != NULL; req = req->next) {
+		unsigned long long rkey;
+
+		rkey = hash_str(HASH_INIT, req->name);
+		rkey = hash_bytes(rkey, &req->amount, sizeof(req->amount));
+		rkey = hash_str(rkey, req->res_str);
+		reqkey += rkey;
+	}
+
+	return hash_bytes(key, &reqkey, sizeof(reqkey));
+}
+
+/**
+ * @brief
+ * 		check if two jobs are alike in everything checked to see if
+ *		they can run
+ *
+ * @param[in]	r1	-	job one
+ * @param[in]	r2	-	job two
+ *
+ * @return	int
+ * @retval	1	: if they are
+ * @retval	0	: if not
+ */
+int
+resresv_set_match(resource_resv *r1, resource_resv *r2)
+{
+	place *pl1;
+	place *pl2;
+	resource_req *req1;
+	resource_req *req2;
+	int n1 = 0;
+	int n2 = 0;
+	int i;
+
+	if (r1->job->queue != r2->job->queue ||
+		r1->job->is_array != r2->job->is_array ||
+		r1->is_shrink_to_fit != r2->is_shrink_to_fit)
+		return 0;
+
+	if (cstrcmp(r1->user, r2->user) || cstrcmp(r1->group, r2->group) ||
+		cstrcmp(r1->project, r2->project) ||
+		cstrcmp(r1->aoename, r2->aoename))
+		return 0;
+
+	if (r1->select != r2->select) {
+		for (i = 0; r1->select->chunks[i] != NULL &&
+			r2->select->chunks[i] != NULL; i++) {
+			if (r1->select->chunks[i]->num_chunks !=
+				r2->select->chunks[i]->num_chunks ||
+				strcmp(r1->select->chunks[i]->str_chunk,
+				r2->select->chunks[i]->str_chunk))
+				return 0;
+		}
+		if (r1->select->chunks[i] != NULL || r2->select->chunks[i] != NULL)
+			return 0;
+	}
+
+	pl1 = r1->place_spec;
+	pl2 = r2->place_spec;
+	if (pl1 != pl2) {
+		if (pl1->free != pl2->free || pl1->pack != pl2->pack ||
+			pl1->scatter != pl2->scatter || pl1->vscatter != pl2->vscatter ||
+			pl1->excl != pl2->excl || pl1->exclhost != pl2->exclhost ||
+			pl1->share != pl2->share || cstrcmp(pl1->group, pl2->group))
+			return 0;
+	}
+
+	for (req1 = r1->resreq; req1 != NULL; req1 = req1->next) {
+		req2 = find_resource_req(r2->resreq, req1->def);
+		if (req2 == NULL || req1->amount != req2->amount ||
+			cstrcmp(req1->res_str, req2->res_str))
+			return 0;
+		n1++;
+	}
+	for (req2 = r2->resreq; req2 != NULL; req2 = req2->next)
+		n2++;
+	if (n1 != n2)
+		return 0;
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		sort the queued jobs of the server into equivalence classes.
+ *		Jobs in a class are alike in everything checked to see if they
+ *		can run, so once a member of a class can not run, the rest of
+ *		the class can not either until resources are freed.
+ *		Jobs which can not be put into a class have an ec_index of
+ *		UNSPECIFIED.
+ *
+ * @param[in]	sinfo	-	server to sort jobs of
+ *
+ * @return	resresv_set **
+ * @retval	NULL terminated array of equivalence classes indexed by ec_index
+ * @retval	NULL	: on error
+ *
+ * @par MT-safe: No
+ */
+resresv_set **
+create_resresv_sets(server_info *sinfo)
+{
+	resresv_set **rsets;
+	resresv_set *rset;
+	resource_resv *resresv;
+	char logbuf[MAX_LOG_SIZE];
+	int *slots;
+	int nslots;
+	int num_sets = 0;
+	int num_jobs;
+	int i;
+	int j;
+
+	if (sinfo == NULL || sinfo->jobs == NULL)
+		return NULL;
+
+	num_jobs = count_array((void **) sinfo->jobs);
+
+	/* open addressed hash table of indexes into rsets, a power of two in size */
+	for (nslots = 16; nslots < num_jobs * 2; nslots <<= 1)
+		;
+
+	if ((rsets = malloc((num_jobs + 1) * sizeof(resresv_set *))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+	if ((slots = malloc(nslots * sizeof(int))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free(rsets);
+		return NULL;
+	}
+	for (i = 0; i < nslots; i++)
+		slots[i] = UNSPECIFIED;
+	rsets[0] = NULL;
+
+	for (i = 0; sinfo->jobs[i] != NULL; i++) {
+		unsigned long long key;
+
+		resresv = sinfo->jobs[i];
+		resresv->ec_index = UNSPECIFIED;
+
+		/* jobs which have already run somewhere or which ask for
+		 * specific nodes are left out of the classes
+		 */
+		if (resresv->job == NULL || resresv->job->queue == NULL ||
+			!in_runnable_state(resresv) || resresv->job->is_suspended ||
+			resresv->job->execselect != NULL || resresv->node_set_str != NULL ||
+			resresv->select == NULL || resresv->place_spec == NULL)
+			continue;
+
+		key = resresv_set_key(resresv);
+		for (j = key & (nslots - 1); slots[j] != UNSPECIFIED; j = (j + 1) & (nslots - 1)) {
+			rset = rsets[slots[j]];
+			if (rset->key == key && resresv_set_match(rset->resresv, resresv))
+				break;
+		}
+
+		if (slots[j] == UNSPECIFIED) {
+			if ((rset = malloc(sizeof(resresv_set))) == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				free(slots);
+				free_resresv_set_array(rsets);
+				return NULL;
+			}
+			rset->can_not_run = 0;
+			rset->key = key;
+			rset->resresv = resresv;
+			rset->num_members = 0;
+			rset->err = NULL;
+			slots[j] = num_sets;
+			rsets[num_sets++] = rset;
+			rsets[num_sets] = NULL;
+		}
+
+		rsets[slots[j]]->num_members++;
+		resresv->ec_index = slots[j];
+	}
+
+	free(slots);
+
+	snprintf(logbuf, MAX_LOG_SIZE, "Number of job equivalence classes: %d",
+		num_sets);
+	schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__, logbuf);
+
+	return rsets;
+}
+
+/**
+ * @brief
+ * 		forget which equivalence classes can not run.  Called when
+ *		resources are freed in the middle of a cycle.
+ *
+ * @param[in]	rsets	-	equivalence classes
+ *
+ * @return	void
+ */
+void
+clear_resresv_sets(resresv_set **rsets)
+{
+	int i;
+
+	if (rsets == NULL)
+		return;
+
+	for (i = 0; rsets[i] != NULL; i++) {
+		rsets[i]->can_not_run = 0;
+		free_schd_error(rsets[i]->err);
+		rsets[i]->err = NULL;
+	}
+}
+
+/**
+ * @brief
+ * 		free an array of equivalence classes
+ *
+ * @param[in]	rsets	-	equivalence classes to free
+ *
+ * @return	void
+ */
+void
+free_resresv_set_array(resresv_set **rsets)
+{
+	int i;
+
+	if (rsets == NULL)
+		return;
+
+	for (i = 0; rsets[i] != NULL; i++) {
+		free_schd_error(rsets[i]->err);
+		free(rsets[i]);
+	}
+
+	free(rsets);
+}
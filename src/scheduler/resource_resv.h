@@ -226,6 +226,11 @@ void free_place(place *pl);
  */
 place *dup_place(place *pl);
 
+/*
+ *	share_place - share a place structure without copying it
+ */
+place *share_place(place *pl);
+
 /*
  *	compare_res_to_str - compare a resource structure of type string to
  *			     a character array string
@@ -282,6 +287,11 @@ selspec *new_selspec();
  */
 selspec *dup_selspec(selspec *oldspec);
 
+/*
+ *	share_selspec - share a selspec without copying it
+ */
+selspec *share_selspec(selspec *spec);
+
 /*
  *	free_selspec - destructor for selspec
  */
@@ -326,6 +336,21 @@ char *create_select_from_nspec(nspec **nspec_array);
 /* function returns true if job/resv is in a state which it can be run */
 int in_runnable_state(resource_resv *resresv);
 
+/* hash what is checked to see if a job can run into an equivalence class key */
+unsigned long long resresv_set_key(resource_resv *resresv);
+
+/* check if two jobs belong in the same equivalence class */
+int resresv_set_match(resource_resv *r1, resource_resv *r2);
+
+/* sort the queued jobs of a server into equivalence classes */
+resresv_set **create_resresv_sets(server_info *sinfo);
+
+/* forget which equivalence classes can not run */
+void clear_resresv_sets(resresv_set **rsets);
+
+/* free an array of equivalence classes */
+void free_resresv_set_array(resresv_set **rsets);
+
 #ifdef	__cplusplus
 }
 #endif
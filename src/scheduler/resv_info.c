@@ -84,6 +84,7 @@
 #include "constant.h"
 #include "node_partition.h"
 #include "pbs_internal.h"
+#include "snapshot.h"
 
 
 /**
@@ -102,7 +103,9 @@ stat_resvs(int pbs_sd)
 	char *errmsg;
 
 	/* get the reservation info from the PBS server */
-	if ((resvs = pbs_statresv(pbs_sd, NULL, NULL, NULL)) == NULL) {
+	resvs = pbs_statresv(pbs_sd, NULL, NULL, NULL);
+	snapshot_put(SNAP_RESV, NULL, resvs);
+	if (resvs == NULL) {
 		if (pbs_errno) {
 			errmsg = pbs_geterrmsg(pbs_sd);
 			if (errmsg == NULL)
@@ -1131,7 +1134,7 @@ check_new_reservations(status *policy, int pbs_sd, resource_resv **resvs, server
  * 		mark the timed event associated to a resource reservation at a given time as
  * 		disabled.
  *
- * @param[in]	events	-	the event which to be disabled in the calendar.
+ * @param[in]	calendar	-	the calendar holding the events to disable
  * @param[in]	resv	-	the resource reservation being disabled
  *
  * @return	int
@@ -1139,18 +1142,18 @@ check_new_reservations(status *policy, int pbs_sd, resource_resv **resvs, server
  * @retval	0	: on failure
  */
 static int
-disable_reservation_occurrence(timed_event *events,
+disable_reservation_occurrence(event_list *calendar,
 	resource_resv *resv)
 {
 	timed_event *te;
 
-	te = find_timed_event(events, resv->name, TIMED_RUN_EVENT, resv->start);
+	te = find_calendar_event(calendar, resv->name, TIMED_RUN_EVENT, resv->start);
 	if (te != NULL)
 		set_timed_event_disabled(te, 1);
 	else
 		return 0;
 
-	te = find_timed_event(events, resv->name, TIMED_END_EVENT, resv->end);
+	te = find_calendar_event(calendar, resv->name, TIMED_END_EVENT, resv->end);
 	if (te != NULL)
 		set_timed_event_disabled(te, 1);
 	else
@@ -1395,7 +1398,7 @@ confirm_reservation(status *policy, int pbs_sd, resource_resv *unconf_resv, serv
 				}
 				continue;
 			}
-			if (disable_reservation_occurrence(nsinfo->calendar->events, nresv)
+			if (disable_reservation_occurrence(nsinfo->calendar, nresv)
 				!= 1) {
 				schdlog(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_INFO, nresv->name,
 					"Error determining if reservation can be confirmed: "
@@ -1703,6 +1706,9 @@ create_resv_nodes(nspec **nspec_arr, server_info *sinfo)
 				nodes[i] = dup_node_info(nspec_arr[i]->ninfo, sinfo, DUP_INDIRECT);
 				nodes[i]->svr_node = nspec_arr[i]->ninfo;
 
+				/* the resources below no longer match the server's node index */
+				nodes[i]->node_ind = -1;
+
 				/* reservation nodes in state resv_exclusive can be assigned to jobs
 				 * within the reservation
 				 */
@@ -49,6 +49,8 @@
  * 	find_alloc_resource()
  * 	find_alloc_resource_by_str()
  * 	find_resource_by_str()
+ * 	add_resource_slots()
+ * 	index_resource_list()
  * 	find_resource()
  * 	free_server_info()
  * 	free_resource_list()
@@ -112,6 +114,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <errno.h>
 #include <ctype.h>
 #include <pbs_ifl.h>
@@ -140,6 +143,9 @@
 #include "simulate.h"
 #include "fairshare.h"
 #include "check.h"
+#include "node_res_index.h"
+#include "profile.h"
+#include "snapshot.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -192,7 +198,9 @@ query_server(status *pol, int pbs_sd)
 	}
 
 	/* get server information from pbs server */
-	if ((server = pbs_statserver(pbs_sd, NULL, NULL)) == NULL) {
+	server = pbs_statserver(pbs_sd, NULL, NULL);
+	snapshot_put(SNAP_SERVER, NULL, server);
+	if (server == NULL) {
 		errmsg = pbs_geterrmsg(pbs_sd);
 		if (errmsg == NULL)
 			errmsg = "";
@@ -222,7 +230,9 @@ query_server(status *pol, int pbs_sd)
 	}
 
 
-	if ((sched = pbs_statsched(pbs_sd, NULL, NULL)) == NULL) {
+	sched = pbs_statsched(pbs_sd, NULL, NULL);
+	snapshot_put(SNAP_SCHED, NULL, sched);
+	if (sched == NULL) {
 		errmsg = pbs_geterrmsg(pbs_sd);
 		if (errmsg == NULL)
 			errmsg = "";
@@ -259,8 +269,11 @@ query_server(status *pol, int pbs_sd)
 		qsort(sinfo->nodes, sinfo->num_nodes, sizeof(node_info *),
 			multi_node_sort);
 
-	/* get the queues */
-	if ((sinfo->queues = query_queues(policy, pbs_sd, sinfo)) ==NULL) {
+	/* get the queues.  Jobs are queried along with their queue */
+	begin_job_status_cache(sinfo);
+	sinfo->queues = query_queues(policy, pbs_sd, sinfo);
+	end_job_status_cache();
+	if (sinfo->queues == NULL) {
 		pbs_statfree(server);
 		sinfo->fairshare = NULL;
 		free_server(sinfo, 0);
@@ -414,10 +427,18 @@ query_server(status *pol, int pbs_sd)
 			create_resource_assn_for_node(ninfo);
 
 	}
+	/* Index the resources of the nodes for chunk matching.  This needs to
+	 * be done after the nodes' resources are all set (e.g., dynamic
+	 * resources and booleans)
+	 */
+	sinfo->node_index = new_node_res_index(sinfo->nodes);
+
 	/* Create placement sets  after collecting jobs on nodes because
 	 * we don't want to account for resources consumed by ghost jobs
 	 */
+	prof_start(PROF_PLACEMENT_SETS);
 	create_placement_sets(policy, sinfo);
+	prof_stop(PROF_PLACEMENT_SETS);
 
 	pbs_statfree(server);
 
@@ -629,31 +650,37 @@ query_server_dyn_res(server_info *sinfo)
 				sinfo->res = res;
 
 			pipe_err = errno = 0;
-#ifdef	WIN32
-			/* In Windows, don't use popen() as this crashes if COMSPEC not set */
-			/* also, let's quote command line so that paths with spaces can be */
-			/* executed. */
-			snprintf(cmd_line, sizeof(cmd_line), "\"%s\"",
-				conf.dynamic_res[i].program);
-
-			if (((win_popen(cmd_line, "r", &pio, NULL) == 0) ||
-				((k = win_pread(&pio, buf, 255)) <= 0))) {
-				pipe_err = errno;
-				k = 0;
+			if (snapshot_replaying()) {
+				/* use the program's output from when the snapshot was taken */
+				k = snapshot_get_dyn_res(conf.dynamic_res[i].program, buf, sizeof(buf));
 			}
-			if (pio.hReadPipe_out != INVALID_HANDLE_VALUE) /* did win_popen() succeed? */
-				win_pclose(&pio);
+			else {
+#ifdef	WIN32
+				/* In Windows, don't use popen() as this crashes if COMSPEC not set */
+				/* also, let's quote command line so that paths with spaces can be */
+				/* executed. */
+				snprintf(cmd_line, sizeof(cmd_line), "\"%s\"",
+					conf.dynamic_res[i].program);
+
+				if (((win_popen(cmd_line, "r", &pio, NULL) == 0) ||
+					((k = win_pread(&pio, buf, 255)) <= 0))) {
+					pipe_err = errno;
+					k = 0;
+				}
+				if (pio.hReadPipe_out != INVALID_HANDLE_VALUE) /* did win_popen() succeed? */
+					win_pclose(&pio);
 #else
-			if (((fp = popen(conf.dynamic_res[i].program, "r")) == NULL) ||
-				(fgets(buf, 256, fp) == NULL)) {
-				pipe_err = errno;
-				k = 0;
-			}
-			else
-				k = strlen(buf);
-			if (fp != NULL)
-				pclose(fp);
+				if (((fp = popen(conf.dynamic_res[i].program, "r")) == NULL) ||
+					(fgets(buf, 256, fp) == NULL)) {
+					pipe_err = errno;
+					k = 0;
+				}
+				else
+					k = strlen(buf);
+				if (fp != NULL)
+					pclose(fp);
 #endif
+			}
 			if (k > 0) {
 				buf[k] = '\0';
 				/* chop \r or \n from buf so that is_num() doesn't think it's a str */
@@ -662,6 +689,7 @@ query_server_dyn_res(server_info *sinfo)
 						break;
 					buf[k] = '\0';
 				}
+				snapshot_put_dyn_res(conf.dynamic_res[i].program, buf);
 
 				if (set_resource(res, buf, RF_AVAIL) == 0) {
 					return -1;
@@ -878,10 +906,89 @@ find_resource_by_str(resource *reslist, const char *name)
 
 	return resp;
 }
+
+/**
+ * @brief
+ * 		add resources to the lookup table of a resource list.  If a
+ *		resource is in the list more than once, the first one is kept
+ *		like a search from the head of the list would find.
+ *
+ * @param[in,out]	rs	-	the lookup table
+ * @param[in]	res	-	the first resource to add, the rest of the
+ *				list after it is added too
+ *
+ * @return	void
+ */
+static void
+add_resource_slots(res_slots *rs, resource *res)
+{
+	for (; res != NULL; res = res->next) {
+		if (res->def != NULL && res->def->index >= 0 &&
+			res->def->index < rs->nslots && rs->slot[res->def->index] == NULL)
+			rs->slot[res->def->index] = res;
+		rs->tail = res;
+	}
+}
+
+/**
+ * @brief
+ * 		create the lookup table of a resource list.  Only lists of at
+ *		least RES_SLOTS_MIN_LEN resources (e.g. vnodes) get a table.
+ *		A short list is just as fast to search.
+ *
+ * @par
+ *		The table is kept on the head of the list and freed with it.
+ *		Resources appended to the list later are added the next time
+ *		one isn't found.  Resources are never removed from the middle
+ *		of a list.
+ *
+ * @param[in,out]	reslist	-	the resource list
+ *
+ * @return	res_slots *
+ * @retval	the lookup table
+ * @retval	NULL	: if the list is too short or on error
+ *
+ * @par MT-safe: No, but it may be called from the node eval threads since
+ *		 each thread only searches the resource lists of its own vnodes
+ */
+static res_slots *
+index_resource_list(resource *reslist)
+{
+	res_slots *rs;
+	resource *res;
+	int nslots;
+	int len;
+
+	for (len = 0, res = reslist; res != NULL && len < RES_SLOTS_MIN_LEN;
+		res = res->next)
+		len++;
+
+	if (len < RES_SLOTS_MIN_LEN || allres == NULL)
+		return NULL;
+
+	nslots = count_array((void **) allres);
+
+	/* no logging on failure, we fall back to searching the list */
+	rs = calloc(1, sizeof(res_slots) + nslots * sizeof(resource *));
+	if (rs == NULL)
+		return NULL;
+
+	rs->nslots = nslots;
+	add_resource_slots(rs, reslist);
+	reslist->slots = rs;
+
+	return rs;
+}
+
 /**
  * @brief
  * 		find resource by resource definition
  *
+ * @par
+ *		Long lists are searched with a table indexed by the resdef index.
+ *		Resource definitions not from allres are found by walking the
+ *		list.
+ *
  * @param 	reslist - 	resource list to search
  * @param 	def 	- 	resource definition to search for
  *
@@ -892,10 +999,23 @@ resource *
 find_resource(resource *reslist, resdef *def)
 {
 	resource *resp;
+	res_slots *rs;
 
 	if (reslist == NULL || def == NULL)
 		return NULL;
 
+	if (def->index >= 0) {
+		rs = reslist->slots;
+		if (rs == NULL)
+			rs = index_resource_list(reslist);
+
+		if (rs != NULL && def->index < rs->nslots) {
+			if (rs->slot[def->index] == NULL && rs->tail->next != NULL)
+				add_resource_slots(rs, rs->tail->next);
+			return rs->slot[def->index];
+		}
+	}
+
 	resp = reslist;
 
 	while (resp != NULL && resp->def != def)
@@ -957,6 +1077,13 @@ free_server_info(server_info *sinfo)
 		free_node_partition_array(sinfo->hostsets);
 	if (sinfo->nodesigs)
 		free_string_array(sinfo->nodesigs);
+
+	free_node_res_index(sinfo->node_index);
+	free_obj_index(sinfo->jobs_idx);
+	free_obj_index(sinfo->all_resresv_idx);
+	free_obj_index(sinfo->resvs_idx);
+	free_obj_index(sinfo->nodes_idx);
+	free_obj_index(sinfo->queues_idx);
 	if (sinfo->npc_arr != NULL)
 		free_np_cache_array(sinfo->npc_arr);
 	if (sinfo->node_group_key != NULL)
@@ -1040,6 +1167,9 @@ free_resource(resource *resp)
 	if (resp->str_assigned != NULL)
 		free(resp->str_assigned);
 
+	if (resp->slots != NULL)
+		free(resp->slots);
+
 	free(resp);
 }
 
@@ -1108,6 +1238,7 @@ new_server_info(int limallocflag)
 	sinfo->allpart = NULL;
 	sinfo->hostsets = NULL;
 	sinfo->nodesigs = NULL;
+	sinfo->node_index = NULL;
 	sinfo->node_group_key = NULL;
 	sinfo->preempt_targets_enable = 1; /* enabled by default */
 	sinfo->npc_arr = NULL;
@@ -1122,6 +1253,18 @@ new_server_info(int limallocflag)
 	sinfo->flt_lic = 0;
 	sinfo->server_time = 0;
 
+	/* if an index can't be created, its array is searched without it */
+	sinfo->jobs_idx = new_obj_index(offsetof(resource_resv, name),
+		offsetof(resource_resv, rank));
+	sinfo->all_resresv_idx = new_obj_index(offsetof(resource_resv, name),
+		offsetof(resource_resv, rank));
+	sinfo->resvs_idx = new_obj_index(offsetof(resource_resv, name),
+		offsetof(resource_resv, rank));
+	sinfo->nodes_idx = new_obj_index(offsetof(node_info, name),
+		offsetof(node_info, rank));
+	sinfo->queues_idx = new_obj_index(offsetof(queue_info, name),
+		OBJ_INDEX_NO_RANK);
+
 	if ((limallocflag != 0))
 		sinfo->liminfo = lim_alloc_liminfo();
 	init_state_count(&(sinfo->sc));
@@ -1166,6 +1309,7 @@ new_resource()
 	resp->indirect_res = NULL;
 	resp->str_avail = NULL;
 	resp->str_assigned = NULL;
+	resp->slots = NULL;
 	resp->assigned = RES_DEFAULT_ASSN;
 	resp->avail = RES_DEFAULT_AVAIL;
 
@@ -1867,6 +2011,14 @@ create_server_arrays(server_info *sinfo)
 	sinfo->jobs = job_arr;
 	sinfo->all_resresv = all_arr;
 
+	/* index the new arrays by name and rank */
+	clear_obj_index(sinfo->jobs_idx);
+	clear_obj_index(sinfo->all_resresv_idx);
+	if (sinfo->jobs_idx != NULL)
+		update_obj_index(sinfo->jobs_idx, (void **) sinfo->jobs);
+	if (sinfo->all_resresv_idx != NULL)
+		update_obj_index(sinfo->all_resresv_idx, (void **) sinfo->all_resresv);
+
 	return 1;
 }
 
@@ -2056,6 +2208,7 @@ dup_server_info(server_info *osinfo)
 	nsinfo->node_group_key = dup_string_array(osinfo->node_group_key);
 	nsinfo->job_formula = string_dup(osinfo->job_formula);
 	nsinfo->nodesigs = dup_string_array(osinfo->nodesigs);
+	nsinfo->node_index = share_node_res_index(osinfo->node_index);
 
 	nsinfo->policy = dup_status(osinfo->policy);
 
@@ -3089,6 +3242,8 @@ update_preemption_on_run(server_info *sinfo, resource_resv *resresv)
 							sinfo->jobs[i]->job->queue, sinfo);
 				}
 			}
+			/* the job index has to hold every job before they are reordered */
+			update_obj_index(sinfo->jobs_idx, (void **) sinfo->jobs);
 			qsort(sinfo->jobs, sinfo->sc.total,
 				sizeof(resource_resv *), cmp_sort);
 			for (i = 0; sinfo->queues[i] != NULL; i++) {
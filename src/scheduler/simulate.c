@@ -52,10 +52,22 @@
  * 	find_prev_timed_event()
  * 	set_timed_event_disabled()
  * 	find_timed_event()
+ * 	find_calendar_event()
  * 	perform_event()
  * 	exists_run_event()
  * 	calc_run_time()
  * 	check_events_overlap()
+ * 	set_event_time_key()
+ * 	locate_event_time()
+ * 	set_event_time_first()
+ * 	keep_timed_event()
+ * 	index_event_name()
+ * 	unindex_event_name()
+ * 	event_precedes()
+ * 	link_event()
+ * 	insert_event()
+ * 	unlink_event()
+ * 	index_resresv_by_time()
  * 	create_event_list()
  * 	create_events()
  * 	new_event_list()
@@ -99,6 +111,7 @@
 #include <string.h>
 #include <errno.h>
 #include <log.h>
+#include <pbs_entlim.h>
 
 #include "simulate.h"
 #include "data_types.h"
@@ -138,6 +151,14 @@ static const struct policy_change_func_name policy_change_func_name[] =
 	{NULL, NULL}
 };
 
+/* index of the new universe's resource_resvs by name and start time.
+ * Only set while dup_event_list() is duplicating a calendar so
+ * find_event_ptr() does not have to search all_resresv for every event.
+ */
+static void *resresv_time_idx = NULL;
+
+static int event_precedes(timed_event *e1, timed_event *e2);
+
 
 /**
  * @brief
@@ -529,6 +550,46 @@ find_timed_event(timed_event *te_list, char *name,
 
 	return te;
 }
+
+/**
+ * @brief
+ * 		find a timed_event in a calendar.  Unlike find_timed_event(),
+ *		this uses the calendar's name index rather than searching
+ *		the whole calendar.
+ *
+ * @param[in] calendar 	- calendar to search
+ * @param[in] name 		- name of timed_event to search or NULL to ignore
+ * @param[in] event_type 	- event_type or TIMED_NOEVENT to ignore
+ * @param[in] event_time 	- time or 0 to ignore
+ *
+ * @return	the first matching timed_event in calendar order
+ * @retval	NULL	: not found or on error
+ *
+ */
+timed_event *
+find_calendar_event(event_list *calendar, char *name,
+	enum timed_event_types event_type, time_t event_time)
+{
+	timed_event *te;
+	timed_event *found = NULL;
+
+	if (calendar == NULL)
+		return NULL;
+
+	if (name == NULL || calendar->name_idx == NULL)
+		return find_timed_event(calendar->events, name, event_type, event_time);
+
+	for (te = entlim_get(name, calendar->name_idx); te != NULL; te = te->name_next) {
+		if (event_type != te->event_type && event_type != TIMED_NOEVENT)
+			continue;
+		if (event_time != te->event_time && event_time != 0)
+			continue;
+		if (found == NULL || event_precedes(te, found))
+			found = te;
+	}
+
+	return found;
+}
 /**
  * @brief
  * 		takes a timed_event and performs any actions
@@ -818,6 +879,346 @@ check_events_overlap(time_t e1_start, time_t e1_end, time_t e2_start, time_t e2_
 
 	return 0;
 }
+/**
+ * @brief
+ *		set the key of a calendar time index record.  The time is stored
+ *		big endian with its sign bit flipped so the byte comparison done
+ *		by the index orders keys the same way the times are ordered.
+ *
+ * @param[out]	rec	-	index record to set the key of
+ * @param[in]	t	-	event time
+ *
+ * @return	void
+ */
+static void
+set_event_time_key(AVL_IX_REC *rec, time_t t)
+{
+	unsigned long long ut;
+	int i;
+
+	memset(rec, 0, sizeof(AVL_IX_REC));
+	ut = ((unsigned long long) ((long long) t)) ^ (1ULL << 63);
+	for (i = sizeof(ut) - 1; i >= 0; i--) {
+		rec->key[i] = (char) (ut & 0xff);
+		ut >>= 8;
+	}
+}
+
+/**
+ * @brief
+ *		find the first event in a calendar at a time by using
+ *		the calendar's time index
+ *
+ * @param[in]	calendar	-	calendar to search
+ * @param[in]	t		-	event time
+ * @param[in]	exact		-	only return an event whose event_time is t.
+ *					If 0, return the first event at or after t
+ *
+ * @return	timed_event *
+ * @retval	NULL	: no such event
+ */
+static timed_event *
+locate_event_time(event_list *calendar, time_t t, int exact)
+{
+	AVL_IX_REC rec;
+	int rc;
+
+	if (calendar == NULL || calendar->time_idx == NULL)
+		return NULL;
+
+	set_event_time_key(&rec, t);
+	rc = avl_locate_key(&rec, (AVL_IX_DESC *) calendar->time_idx);
+	if (rc == AVL_IX_OK || (rc == AVL_IX_FAIL && !exact))
+		return (timed_event *) rec.recptr;
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *		set which event is the first event at a time in the
+ *		calendar's time index
+ *
+ * @param[in]	calendar	-	calendar to update
+ * @param[in]	t		-	event time
+ * @param[in]	te		-	first event at t or NULL if there are none
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+set_event_time_first(event_list *calendar, time_t t, timed_event *te)
+{
+	AVL_IX_REC rec;
+
+	set_event_time_key(&rec, t);
+	avl_delete_key(&rec, (AVL_IX_DESC *) calendar->time_idx);
+
+	if (te != NULL) {
+		set_event_time_key(&rec, t);
+		rec.recptr = te;
+		if (avl_add_key(&rec, (AVL_IX_DESC *) calendar->time_idx) != AVL_IX_OK)
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		leaf destructor for the calendar indexes.  The indexes only
+ *		reference the events, they are freed with the event list.
+ *
+ * @param[in]	te	-	timed event (unused)
+ *
+ * @return	void
+ */
+static void
+keep_timed_event(void *te)
+{
+}
+
+/**
+ * @brief
+ *		add an event to the chain of events with its name
+ *
+ * @param[in]	calendar	-	calendar the event is in
+ * @param[in]	te		-	the event
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+index_event_name(event_list *calendar, timed_event *te)
+{
+	timed_event *head;
+
+	te->name_next = NULL;
+	if (te->name == NULL)
+		return 1;
+
+	head = entlim_get(te->name, calendar->name_idx);
+	if (head != NULL) {
+		te->name_next = head->name_next;
+		head->name_next = te;
+		return 1;
+	}
+
+	if (entlim_add(te->name, te, calendar->name_idx) != 0)
+		return 0;
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		remove an event from the chain of events with its name
+ *
+ * @param[in]	calendar	-	calendar the event is in
+ * @param[in]	te		-	the event
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: the event is not in the calendar
+ */
+static int
+unindex_event_name(event_list *calendar, timed_event *te)
+{
+	timed_event *cur;
+	timed_event *prev = NULL;
+
+	if (te->name == NULL)
+		return 0;
+
+	for (cur = entlim_get(te->name, calendar->name_idx); cur != NULL && cur != te;
+		prev = cur, cur = cur->name_next)
+			;
+
+	if (cur == NULL)
+		return 0;
+
+	if (prev != NULL)
+		prev->name_next = te->name_next;
+	else {
+		entlim_delete(te->name, calendar->name_idx, keep_timed_event);
+		if (te->name_next != NULL)
+			entlim_add(te->name, te->name_next, calendar->name_idx);
+	}
+	te->name_next = NULL;
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		does one event come before another in a calendar
+ *
+ * @param[in]	e1	-	first event
+ * @param[in]	e2	-	second event
+ *
+ * @return	int
+ * @retval	1	: e1 comes before e2
+ * @retval	0	: e1 does not come before e2
+ */
+static int
+event_precedes(timed_event *e1, timed_event *e2)
+{
+	timed_event *te;
+
+	if (e1->event_time != e2->event_time)
+		return e1->event_time < e2->event_time;
+
+	for (te = e1->next; te != NULL && te->event_time == e1->event_time; te = te->next)
+		if (te == e2)
+			return 1;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *		link an event into a calendar's list of events
+ *
+ * @param[in]	calendar	-	calendar to link into
+ * @param[in]	te		-	event to link
+ * @param[in]	next		-	event te is linked in front of.
+ *					If NULL, te becomes the last event
+ *
+ * @return	void
+ */
+static void
+link_event(event_list *calendar, timed_event *te, timed_event *next)
+{
+	te->next = next;
+	if (next == NULL) {
+		te->prev = calendar->last_event;
+		calendar->last_event = te;
+	} else {
+		te->prev = next->prev;
+		next->prev = te;
+	}
+
+	if (te->prev == NULL)
+		calendar->events = te;
+	else
+		te->prev->next = te;
+}
+
+/**
+ * @brief
+ *		insert an event into its place in a calendar and its indexes
+ *
+ * @note
+ *		If multiple events are at the same time, end events come first.
+ *		This is the same order add_timed_event() keeps.
+ *
+ * @param[in]	calendar	-	calendar to insert into
+ * @param[in]	te		-	event to insert
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+insert_event(event_list *calendar, timed_event *te)
+{
+	timed_event *first = NULL;
+	timed_event *next;
+
+	next = locate_event_time(calendar, te->event_time, 0);
+	if (next != NULL && next->event_time == te->event_time) {
+		first = next;
+		if (te->event_type != TIMED_END_EVENT)
+			next = locate_event_time(calendar, te->event_time + 1, 0);
+	}
+
+	link_event(calendar, te, next);
+
+	if (first == NULL || te->event_type == TIMED_END_EVENT)
+		if (set_event_time_first(calendar, te->event_time, te) == 0)
+			return 0;
+
+	return index_event_name(calendar, te);
+}
+
+/**
+ * @brief
+ *		unlink an event from a calendar and its indexes
+ *
+ * @param[in]	calendar	-	calendar to unlink from
+ * @param[in]	e		-	event to unlink
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: the event is not in the calendar
+ */
+static int
+unlink_event(event_list *calendar, timed_event *e)
+{
+	if (unindex_event_name(calendar, e) == 0)
+		return 0;
+
+	if (locate_event_time(calendar, e->event_time, 1) == e) {
+		if (e->next != NULL && e->next->event_time == e->event_time)
+			set_event_time_first(calendar, e->event_time, e->next);
+		else
+			set_event_time_first(calendar, e->event_time, NULL);
+	}
+
+	if (e->prev == NULL)
+		calendar->events = e->next;
+	else
+		e->prev->next = e->next;
+
+	if (e->next == NULL)
+		calendar->last_event = e->prev;
+	else
+		e->next->prev = e->prev;
+
+	e->next = NULL;
+	e->prev = NULL;
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		index an array of resource_resvs by name and start time.
+ *		If several share both, the first one is indexed like
+ *		find_resource_resv_by_time() would find it.
+ *
+ * @param[in]	resresv_arr	-	array to index
+ *
+ * @return	index to be freed with entlim_free_ctx()
+ * @retval	NULL	: on error
+ */
+static void *
+index_resresv_by_time(resource_resv **resresv_arr)
+{
+	void *idx;
+	char key[MAX_LOG_SIZE];
+	int i;
+
+	if (resresv_arr == NULL)
+		return NULL;
+
+	if ((idx = entlim_initialize_ctx()) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	for (i = 0; resresv_arr[i] != NULL; i++) {
+		snprintf(key, sizeof(key), "%s@%ld", resresv_arr[i]->name,
+			(long) resresv_arr[i]->start);
+		if (entlim_get(key, idx) == NULL)
+			entlim_add(key, resresv_arr[i], idx);
+	}
+
+	return idx;
+}
+
 /**
  * @brief
  * 		create an event_list from running jobs and confirmed resvs
@@ -836,10 +1237,16 @@ create_event_list(server_info *sinfo)
 	if (elist == NULL)
 		return NULL;
 
-	elist->events = create_events(sinfo);
+	elist->current_time = &sinfo->server_time;
+	if (create_events(sinfo, elist) == 0) {
+		/* start over with an empty calendar */
+		free_event_list(elist);
+		if ((elist = new_event_list()) == NULL)
+			return NULL;
+		elist->current_time = &sinfo->server_time;
+	}
 
 	elist->next_event = elist->events;
-	elist->current_time = &sinfo->server_time;
 	add_dedtime_events(elist, sinfo->policy);
 
 	return elist;
@@ -847,18 +1254,20 @@ create_event_list(server_info *sinfo)
 
 /**
  * @brief
- *		create_events - creates an timed_event list from running jobs
- *			    and confirmed reservations
+ *		create_events - adds timed_events for running jobs
+ *			    and confirmed reservations to an event_list
  *
  * @param[in] sinfo - server universe to act upon
+ * @param[in] elist - event_list to add the events to
  *
- * @return	timed_event list
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
  *
  */
-timed_event *
-create_events(server_info *sinfo)
+int
+create_events(server_info *sinfo, event_list *elist)
 {
-	timed_event *events = NULL;
 	timed_event *te;
 	resource_resv **all;
 	int errflag = 0;
@@ -878,28 +1287,24 @@ create_events(server_info *sinfo)
 		 */
 		if (in_runnable_state(all[i])) {
 			te = create_event(TIMED_RUN_EVENT, all[i]->start, all[i], NULL, NULL);
-			if (te == NULL) {
+			if (te == NULL || add_event(elist, te) == 0) {
 				errflag++;
 				break;
 			}
-			events = add_timed_event(events, te);
 		}
 
 		te = create_event(TIMED_END_EVENT, all[i]->end, all[i], NULL, NULL);
-		if (te == NULL) {
+		if (te == NULL || add_event(elist, te) == 0) {
 			errflag++;
 			break;
 		}
-		events = add_timed_event(events, te);
 	}
 
-	/* A malloc error was encountered, free all allocated memory and return */
-	if (errflag > 0) {
-		free_timed_event_list(events);
+	/* A malloc error was encountered, the caller frees the event_list */
+	if (errflag > 0)
 		return 0;
-	}
 
-	return events;
+	return 1;
 }
 
 /**
@@ -922,7 +1327,23 @@ new_event_list()
 	elist->eol = 0;
 	elist->events = NULL;
 	elist->next_event = NULL;
+	elist->last_event = NULL;
 	elist->current_time = NULL;
+	elist->name_idx = NULL;
+
+	if ((elist->time_idx = malloc(sizeof(AVL_IX_DESC))) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free(elist);
+		return NULL;
+	}
+	avl_create_index((AVL_IX_DESC *) elist->time_idx, AVL_NO_DUP_KEYS,
+		sizeof(unsigned long long));
+
+	if ((elist->name_idx = entlim_initialize_ctx()) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_event_list(elist);
+		return NULL;
+	}
 
 	return elist;
 }
@@ -941,6 +1362,9 @@ event_list *
 dup_event_list(event_list *oelist, server_info *nsinfo)
 {
 	event_list *nelist;
+	timed_event *ote;
+	timed_event *nte;
+	int rc = 1;
 
 	if (oelist == NULL || nsinfo == NULL)
 		return NULL;
@@ -953,19 +1377,35 @@ dup_event_list(event_list *oelist, server_info *nsinfo)
 	nelist->eol = oelist->eol;
 	nelist->current_time = &nsinfo->server_time;
 
-	if (oelist->events != NULL) {
-		nelist->events = dup_timed_event_list(oelist->events, nsinfo);
-		if (nelist->events == NULL) {
-			free_event_list(nelist);
-			return NULL;
-		}
+	/* The events are already in calendar order.  Append each copy to
+	 * the end instead of searching for its place.
+	 */
+	resresv_time_idx = index_resresv_by_time(nsinfo->all_resresv);
+	for (ote = oelist->events; ote != NULL && rc; ote = ote->next) {
+		nte = dup_timed_event(ote, nsinfo);
+		if (nte == NULL)
+			continue;
+
+		link_event(nelist, nte, NULL);
+		if (nte->prev == NULL || nte->prev->event_time != nte->event_time)
+			rc = set_event_time_first(nelist, nte->event_time, nte);
+		if (rc)
+			rc = index_event_name(nelist, nte);
+
+		if (ote == oelist->next_event)
+			nelist->next_event = nte;
+	}
+	if (resresv_time_idx != NULL) {
+		entlim_free_ctx(resresv_time_idx, keep_timed_event);
+		resresv_time_idx = NULL;
+	}
+
+	if (rc == 0) {
+		free_event_list(nelist);
+		return NULL;
 	}
 
 	if (oelist->next_event != NULL) {
-		nelist->next_event = find_timed_event(nelist->events,
-			oelist->next_event->name,
-			oelist->next_event->event_type,
-			oelist->next_event->event_time);
 		if (nelist->next_event == NULL) {
 			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED,
 				LOG_WARNING, oelist->next_event->name,
@@ -991,6 +1431,12 @@ free_event_list(event_list *elist)
 		return;
 
 	free_timed_event_list(elist->events);
+	if (elist->time_idx != NULL) {
+		avl_destroy_index((AVL_IX_DESC *) elist->time_idx);
+		free(elist->time_idx);
+	}
+	if (elist->name_idx != NULL)
+		entlim_free_ctx(elist->name_idx, keep_timed_event);
 	free(elist);
 }
 
@@ -1021,6 +1467,7 @@ new_timed_event()
 	te->event_func_arg = NULL;
 	te->next = NULL;
 	te->prev = NULL;
+	te->name_next = NULL;
 
 	return te;
 }
@@ -1093,9 +1540,15 @@ find_event_ptr(timed_event *ote, server_info *nsinfo)
 		case TIMED_RUN_EVENT:
 		case TIMED_END_EVENT:
 			oep = (resource_resv *) ote->event_ptr;
-			event_ptr =
-				find_resource_resv_by_time(nsinfo->all_resresv,
-				oep->name, oep->start);
+			if (resresv_time_idx != NULL) {
+				char key[MAX_LOG_SIZE];
+
+				snprintf(key, sizeof(key), "%s@%ld", oep->name, (long) oep->start);
+				event_ptr = entlim_get(key, resresv_time_idx);
+			} else
+				event_ptr =
+					find_resource_resv_by_time(nsinfo->all_resresv,
+					oep->name, oep->start);
 
 			if (event_ptr == NULL) {
 				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, ote->name,
@@ -1142,7 +1595,7 @@ dup_timed_event_list(timed_event *ote_list, server_info *nsinfo)
 	timed_event *ote;
 	timed_event *nte = NULL;
 	timed_event *nte_prev = NULL;
-	timed_event *nte_head;
+	timed_event *nte_head = NULL;
 
 	if (ote_list == NULL || nsinfo == NULL)
 		return NULL;
@@ -1152,6 +1605,10 @@ dup_timed_event_list(timed_event *ote_list, server_info *nsinfo)
 #endif /* localmod 005 */
 	for (ote = ote_list; ote != NULL; ote = ote->next) {
 		nte = dup_timed_event(ote, nsinfo);
+		if (nte == NULL)
+			continue;
+
+		nte->prev = nte_prev;
 		if (nte_prev != NULL)
 			nte_prev->next = nte;
 		else
@@ -1227,7 +1684,8 @@ add_event(event_list *calendar, timed_event *te)
 	if (calendar->events == NULL)
 		events_is_null = 1;
 
-	calendar->events = add_timed_event(calendar->events, te);
+	if (insert_event(calendar, te) == 0)
+		return 0;
 
 	/* empty event list - the new event is the only event */
 	if (events_is_null)
@@ -1241,8 +1699,7 @@ add_event(event_list *calendar, timed_event *te)
 				calendar->next_event = te;
 			else if (te->event_time == calendar->next_event->event_time) {
 				calendar->next_event =
-					find_timed_event(calendar->events, NULL,
-					TIMED_NOEVENT, te->event_time);
+					locate_event_time(calendar, te->event_time, 1);
 			}
 		}
 	}
@@ -1298,12 +1755,15 @@ add_timed_event(timed_event *events, timed_event *te)
 	if (eloop_prev == NULL) {
 		te->next = events;
 		te->prev = NULL;
+		events->prev = te;
 		return te;
 	}
 
 	te->next = eloop;
 	eloop_prev->next = te;
 	te->prev = eloop_prev;
+	if (eloop != NULL)
+		eloop->prev = te;
 
 	return events;
 }
@@ -1325,37 +1785,26 @@ add_timed_event(timed_event *events, timed_event *te)
 int
 delete_event(server_info *sinfo, timed_event *e, unsigned int flags)
 {
-	timed_event *cur_e;
-	timed_event *prev_e = NULL;
+	timed_event *next_e;
 	event_list *calendar;
 
-	if (sinfo == NULL || e == NULL)
+	if (sinfo == NULL || sinfo->calendar == NULL || e == NULL)
 		return 0;
 
 	calendar = sinfo->calendar;
+	next_e = e->next;
 
+	/* unlink_event() fails if our event is not in the calendar */
+	if (unlink_event(calendar, e) == 0)
+		return 0;
 
-	for (cur_e = calendar->events; cur_e != e && cur_e != NULL;
-		prev_e = cur_e, cur_e = cur_e->next)
-			;
-
-	/* found our event to delete */
-	if (cur_e != NULL) {
-		if (calendar->next_event == cur_e)
-			calendar->next_event = cur_e->next;
-
-		if (prev_e == NULL)
-			calendar->events = cur_e->next;
-		else
-			prev_e->next = cur_e->next;
+	if (calendar->next_event == e)
+		calendar->next_event = next_e;
 
-		if ((flags & DE_UNLINK) == 0)
-			free_timed_event(cur_e);
+	if ((flags & DE_UNLINK) == 0)
+		free_timed_event(e);
 
-		return 1;
-	}
-
-	return 0;
+	return 1;
 }
 
 
@@ -134,6 +134,16 @@ timed_event *
 find_timed_event(timed_event *te_list, char *name,
 	enum timed_event_types event_type, time_t event_time);
 
+/*
+ *	find_calendar_event - find a timed_event in a calendar using its
+ *			      name index
+ *
+ *	return first matching timed_event in calendar order or NULL
+ */
+timed_event *
+find_calendar_event(event_list *calendar, char *name,
+	enum timed_event_types event_type, time_t event_time);
+
 
 
 
@@ -184,15 +194,15 @@ int exists_run_event(event_list *calendar, time_t end_time);
 
 
 /*
- *      create_events - creates an timed_event list from running jobs
- *                          and confirmed reservations
+ *      create_events - adds timed_events for running jobs
+ *                          and confirmed reservations to an event_list
  *
  *        \param sinfo - server universe to act upon
- *        \param flags -
+ *        \param elist - event_list to add the events to
  *
- *        \return timed_event list
+ *        \return 1 success / 0 failure
  */
-timed_event *create_events(server_info *sinfo);
+int create_events(server_info *sinfo, event_list *elist);
 
 /*
  * new_event_list() - event_list constructor
@@ -1484,6 +1484,7 @@ site_resort_jobs(resource_resv *njob)
 	/*
 	 * Now, redo sorting.
 	 */
+	update_obj_index(sinfo->jobs_idx, (void **) sinfo->jobs);
 	qsort(sinfo->jobs, sinfo->sc.total, sizeof(resource_resv *), cmp_sort);
 	for (i = 0; sinfo->queues[i] != NULL; ++i) {
 		qsort(sinfo->queues[i]->jobs, sinfo->queues[i]->sc.total,
@@ -0,0 +1,840 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    snapshot.c
+ *
+ * @brief
+ * 	snapshot.c - write and read snapshots of the input of a scheduling
+ *	cycle.  A snapshot holds the scheduler's config files, the fairshare
+ *	usage, every status reply from the server and the output of the
+ *	server_dyn_res programs.  pbs_sched writes one when asked to by a
+ *	signal, and pbs_sched_replay reads one to run the cycle again without
+ *	a server.
+ *
+ *	A snapshot is a text file of tab separated lines.  Tabs, newlines and
+ *	backslashes in the fields are escaped, and a NULL field is written
+ *	as \-.  Config files are copied in as-is after a line with their size.
+ *
+ *	SNAPSHOT_MAGIC	version	time
+ *	file	name	size
+ *	stat	object	key
+ *	obj	name
+ *	attr	name	resource	value
+ *	end
+ *	dyn_res	program	output
+ *
+ * Functions included are:
+ * 	snap_write_field()
+ * 	snap_write_file()
+ * 	snap_read_file()
+ * 	snap_split()
+ * 	snap_find_obj()
+ * 	snap_new_entry()
+ * 	snap_dup_status()
+ * 	snapshot_begin()
+ * 	snapshot_end()
+ * 	snapshot_put()
+ * 	snapshot_put_dyn_res()
+ * 	snapshot_load()
+ * 	free_snapshot()
+ * 	snapshot_replaying()
+ * 	snapshot_time()
+ * 	snapshot_rewind()
+ * 	snapshot_get()
+ * 	snapshot_get_dyn_res()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <log.h>
+#include <libutil.h>
+#include <pbs_ifl.h>
+#include "constant.h"
+#include "config.h"
+#include "data_types.h"
+#include "globals.h"
+#include "misc.h"
+#include "fairshare.h"
+#include "job_info.h"
+#include "snapshot.h"
+
+/* the most fields on a line of a snapshot */
+#define SNAP_MAX_FIELDS 4
+
+/* a reply (or server_dyn_res output) read from a snapshot */
+struct snap_entry {
+	enum snap_obj obj;
+	char *key;			/* queue for jobs, program for dyn_res */
+	struct batch_status *bs;
+	char *output;			/* server_dyn_res output */
+	int used;			/* returned by snapshot_get() already */
+};
+
+int snapshot_requested = 0;
+
+static FILE *snap_fp = NULL;		/* snapshot being written */
+static char snap_fname[MAXPATHLEN + 1];	/* name of the snapshot being written */
+
+static struct snap_entry *snap_entries = NULL;	/* snapshot being replayed */
+static int snap_num_entries = 0;
+static int snap_replay = 0;
+static time_t snap_cycle_time = 0;
+
+static char *snap_obj_names[SNAP_OBJ_LAST] = {
+	"server",
+	"sched",
+	"queue",
+	"vnode",
+	"job",
+	"resv",
+	"resource",
+	"dyn_res"
+};
+
+/**
+ * @brief
+ * 		write a tab and an escaped field to a snapshot
+ *
+ * @param[in]	fp	-	the snapshot
+ * @param[in]	str	-	the field (may be NULL)
+ *
+ * @return	void
+ */
+static void
+snap_write_field(FILE *fp, char *str)
+{
+	fputc('\t', fp);
+	if (str == NULL) {
+		fputs("\\-", fp);
+		return;
+	}
+
+	for (; *str != '\0'; str++) {
+		switch (*str) {
+			case '\\':
+				fputs("\\\\", fp);
+				break;
+			case '\t':
+				fputs("\\t", fp);
+				break;
+			case '\n':
+				fputs("\\n", fp);
+				break;
+			default:
+				fputc(*str, fp);
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		copy a file into a snapshot.  A missing file is skipped.
+ *
+ * @param[in]	fp	-	the snapshot
+ * @param[in]	name	-	the name the file is replayed as
+ * @param[in]	path	-	the file to copy
+ *
+ * @return	void
+ */
+static void
+snap_write_file(FILE *fp, char *name, char *path)
+{
+	FILE *in;
+	char buf[4096];
+	long size;
+	size_t len;
+
+	if ((in = fopen(path, "rb")) == NULL)
+		return;
+
+	if (fseek(in, 0L, SEEK_END) != 0 || (size = ftell(in)) < 0) {
+		fclose(in);
+		return;
+	}
+	rewind(in);
+
+	fputs("file", fp);
+	snap_write_field(fp, name);
+	fprintf(fp, "\t%ld\n", size);
+
+	while (size > 0 && (len = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if (len > size)
+			len = size;
+		fwrite(buf, 1, len, fp);
+		size -= len;
+	}
+	/* keep the snapshot readable if the file shrank while we copied it */
+	for (; size > 0; size--)
+		fputc('\n', fp);
+	fputc('\n', fp);
+
+	fclose(in);
+}
+
+/**
+ * @brief
+ * 		copy a file out of a snapshot into the current directory
+ *
+ * @param[in]	fp	-	the snapshot, positioned at the file's data
+ * @param[in]	name	-	the file's name
+ * @param[in]	size	-	the file's size
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+snap_read_file(FILE *fp, char *name, long size)
+{
+	FILE *out;
+	char buf[4096];
+	size_t len;
+	int ret = 1;
+
+	/* only write into the current directory */
+	if (strchr(name, '/') != NULL || strcmp(name, "..") == 0) {
+		sprintf(log_buffer, "Bad file name in snapshot: %s", name);
+		log_err(-1, __func__, log_buffer);
+		return 0;
+	}
+
+	if ((out = fopen(name, "wb")) == NULL) {
+		sprintf(log_buffer, "Error opening file %s", name);
+		log_err(errno, __func__, log_buffer);
+		return 0;
+	}
+
+	while (size > 0) {
+		len = size < sizeof(buf) ? size : sizeof(buf);
+		if (fread(buf, 1, len, fp) != len) {
+			ret = 0;
+			break;
+		}
+		fwrite(buf, 1, len, out);
+		size -= len;
+	}
+	fclose(out);
+
+	/* the newline after the file's data */
+	if (ret)
+		fgetc(fp);
+
+	return ret;
+}
+
+/**
+ * @brief
+ * 		split a line of a snapshot into its fields and unescape them.
+ *		The line is modified in place.
+ *
+ * @param[in,out]	line	-	the line
+ * @param[out]	fields	-	the fields (NULL for \-)
+ * @param[in]	max	-	the size of fields
+ *
+ * @return	int
+ * @retval	the number of fields
+ */
+static int
+snap_split(char *line, char **fields, int max)
+{
+	char *in;
+	char *out;
+	int num = 0;
+
+	in = out = line;
+	fields[num++] = out;
+	for (; *in != '\0' && *in != '\n'; in++) {
+		if (*in == '\t') {
+			*out++ = '\0';
+			if (num == max)
+				return -1;
+			fields[num++] = out;
+		} else if (*in == '\\' && in[1] != '\0') {
+			in++;
+			switch (*in) {
+				case 't':
+					*out++ = '\t';
+					break;
+				case 'n':
+					*out++ = '\n';
+					break;
+				case '-':
+					fields[num - 1] = NULL;
+					break;
+				default:
+					*out++ = *in;
+			}
+		} else
+			*out++ = *in;
+	}
+	*out = '\0';
+
+	return num;
+}
+
+/**
+ * @brief
+ * 		find a snap_obj by name
+ *
+ * @param[in]	name	-	the name of the object
+ *
+ * @return	int
+ * @retval	the snap_obj
+ * @retval	-1	: not found
+ */
+static int
+snap_find_obj(char *name)
+{
+	int i;
+
+	if (name == NULL)
+		return -1;
+
+	for (i = 0; i < SNAP_OBJ_LAST; i++)
+		if (strcmp(snap_obj_names[i], name) == 0)
+			return i;
+
+	return -1;
+}
+
+/**
+ * @brief
+ * 		add an entry to the snapshot being replayed
+ *
+ * @param[in]	obj	-	the kind of entry
+ * @param[in]	key	-	the entry's key (may be NULL)
+ *
+ * @return	struct snap_entry *
+ * @retval	the new entry
+ * @retval	NULL	: on error
+ */
+static struct snap_entry *
+snap_new_entry(enum snap_obj obj, char *key)
+{
+	struct snap_entry *tmp;
+	struct snap_entry *ent;
+
+	tmp = realloc(snap_entries, (snap_num_entries + 1) * sizeof(struct snap_entry));
+	if (tmp == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+	snap_entries = tmp;
+
+	ent = &snap_entries[snap_num_entries];
+	memset(ent, 0, sizeof(struct snap_entry));
+	ent->obj = obj;
+	if (key != NULL && (ent->key = string_dup(key)) == NULL)
+		return NULL;
+	snap_num_entries++;
+
+	return ent;
+}
+
+/**
+ * @brief
+ * 		duplicate a list of batch_status.  The copy is allocated the
+ *		same way as a reply from the server so it can be freed with
+ *		pbs_statfree().
+ *
+ * @param[in]	obs	-	the list to duplicate
+ *
+ * @return	struct batch_status *
+ * @retval	the copy
+ * @retval	NULL	: empty list or on error
+ */
+static struct batch_status *
+snap_dup_status(struct batch_status *obs)
+{
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct batch_status *nbs;
+	struct attrl *oattr;
+	struct attrl *nattr;
+	struct attrl *attr_tail;
+
+	for (; obs != NULL; obs = obs->next) {
+		if ((nbs = calloc(1, sizeof(struct batch_status))) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			pbs_statfree(head);
+			return NULL;
+		}
+		if (tail == NULL)
+			head = nbs;
+		else
+			tail->next = nbs;
+		tail = nbs;
+
+		nbs->name = string_dup(obs->name);
+		nbs->text = string_dup(obs->text);
+
+		attr_tail = NULL;
+		for (oattr = obs->attribs; oattr != NULL; oattr = oattr->next) {
+			if ((nattr = dup_attrl(oattr)) == NULL) {
+				pbs_statfree(head);
+				return NULL;
+			}
+			if (attr_tail == NULL)
+				nbs->attribs = nattr;
+			else
+				attr_tail->next = nattr;
+			attr_tail = nattr;
+		}
+	}
+
+	return head;
+}
+
+/**
+ * @brief
+ * 		start writing a snapshot of a scheduling cycle.  The scheduler's
+ *		config files and the current fairshare usage are copied in
+ *		first; the server's replies are added by snapshot_put() as
+ *		the cycle queries them.
+ *
+ * @param[in]	fname	-	the snapshot file
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ *
+ * @par MT-safe: No
+ */
+int
+snapshot_begin(char *fname)
+{
+	char usage_file[MAXPATHLEN + 1];
+
+	if (fname == NULL)
+		return 0;
+
+	if (snap_fp != NULL)
+		snapshot_end();
+
+	if ((snap_fp = fopen(fname, "w")) == NULL) {
+		sprintf(log_buffer, "Error opening file %s", fname);
+		log_err(errno, __func__, log_buffer);
+		return 0;
+	}
+	snprintf(snap_fname, sizeof(snap_fname), "%s", fname);
+
+	fprintf(snap_fp, "%s\t%d\t%ld\n", SNAPSHOT_MAGIC, SNAPSHOT_VERSION,
+		(long) time(NULL));
+
+	snap_write_file(snap_fp, CONFIG_FILE, CONFIG_FILE);
+	snap_write_file(snap_fp, HOLIDAYS_FILE, HOLIDAYS_FILE);
+	snap_write_file(snap_fp, RESGROUP_FILE, RESGROUP_FILE);
+	snap_write_file(snap_fp, DEDTIME_FILE, DEDTIME_FILE);
+
+	/* the usage file on disk may be behind the usage in memory */
+	if (conf.fairshare != NULL) {
+		snprintf(usage_file, sizeof(usage_file), "%s.%s", fname, USAGE_FILE);
+		if (write_usage(usage_file, conf.fairshare)) {
+			snap_write_file(snap_fp, USAGE_FILE, usage_file);
+			unlink(usage_file);
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		finish writing a snapshot
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+snapshot_end(void)
+{
+	if (snap_fp == NULL)
+		return;
+
+	if (fclose(snap_fp) != 0) {
+		sprintf(log_buffer, "Error writing snapshot %s", snap_fname);
+		log_err(errno, __func__, log_buffer);
+	} else {
+		snprintf(log_buffer, sizeof(log_buffer),
+			"Wrote snapshot of the scheduling cycle to %s", snap_fname);
+		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_FILE, LOG_NOTICE,
+			"snapshot", log_buffer);
+	}
+	snap_fp = NULL;
+}
+
+/**
+ * @brief
+ * 		add a reply from the server to the snapshot being written.
+ *		Does nothing unless a snapshot is being written.
+ *
+ * @param[in]	obj	-	what was queried
+ * @param[in]	key	-	the queue for jobs, otherwise NULL
+ * @param[in]	bs	-	the server's reply (may be empty)
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+snapshot_put(enum snap_obj obj, char *key, struct batch_status *bs)
+{
+	struct attrl *attr;
+
+	if (snap_fp == NULL)
+		return;
+
+	fputs("stat", snap_fp);
+	snap_write_field(snap_fp, snap_obj_names[obj]);
+	snap_write_field(snap_fp, key);
+	fputc('\n', snap_fp);
+
+	for (; bs != NULL; bs = bs->next) {
+		fputs("obj", snap_fp);
+		snap_write_field(snap_fp, bs->name);
+		fputc('\n', snap_fp);
+		for (attr = bs->attribs; attr != NULL; attr = attr->next) {
+			fputs("attr", snap_fp);
+			snap_write_field(snap_fp, attr->name);
+			snap_write_field(snap_fp, attr->resource);
+			snap_write_field(snap_fp, attr->value);
+			fputc('\n', snap_fp);
+		}
+	}
+	fputs("end\n", snap_fp);
+}
+
+/**
+ * @brief
+ * 		add the output of a server_dyn_res program to the snapshot being
+ *		written.  Does nothing unless a snapshot is being written.
+ *
+ * @param[in]	program	-	the server_dyn_res program
+ * @param[in]	output	-	the first line of its output
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+snapshot_put_dyn_res(char *program, char *output)
+{
+	if (snap_fp == NULL)
+		return;
+
+	fputs(snap_obj_names[SNAP_DYN_RES], snap_fp);
+	snap_write_field(snap_fp, program);
+	snap_write_field(snap_fp, output);
+	fputc('\n', snap_fp);
+}
+
+/**
+ * @brief
+ * 		read a snapshot to replay.  The config files in the snapshot are
+ *		written into the current directory so schedinit() will read them,
+ *		and the replies are kept for snapshot_get().
+ *
+ * @param[in]	fname	-	the snapshot file
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ *
+ * @par MT-safe: No
+ */
+int
+snapshot_load(char *fname)
+{
+	FILE *fp;
+	char *buf = NULL;
+	int buf_size = 0;
+	char *fields[SNAP_MAX_FIELDS];
+	int num;
+	int obj;
+	int linenum = 0;
+	struct snap_entry *ent = NULL;
+	struct batch_status *bs;
+	struct batch_status *bs_tail = NULL;
+	struct attrl *attr;
+	struct attrl *attr_tail = NULL;
+	int rc = 1;
+
+	if (fname == NULL)
+		return 0;
+
+	if ((fp = fopen(fname, "rb")) == NULL) {
+		sprintf(log_buffer, "Error opening file %s", fname);
+		log_err(errno, __func__, log_buffer);
+		return 0;
+	}
+
+	free_snapshot();
+
+	if (pbs_fgets(&buf, &buf_size, fp) == NULL ||
+		snap_split(buf, fields, SNAP_MAX_FIELDS) != 3 || fields[0] == NULL ||
+		strcmp(fields[0], SNAPSHOT_MAGIC) != 0 || fields[1] == NULL ||
+		atoi(fields[1]) != SNAPSHOT_VERSION || fields[2] == NULL) {
+		sprintf(log_buffer, "%s is not a version %d snapshot", fname,
+			SNAPSHOT_VERSION);
+		log_err(-1, __func__, log_buffer);
+		free(buf);
+		fclose(fp);
+		return 0;
+	}
+	snap_cycle_time = (time_t) atol(fields[2]);
+	linenum++;
+
+	while (rc && pbs_fgets(&buf, &buf_size, fp) != NULL) {
+		linenum++;
+		num = snap_split(buf, fields, SNAP_MAX_FIELDS);
+		if (num < 1 || fields[0] == NULL) {
+			rc = 0;
+			break;
+		}
+
+		if (strcmp(fields[0], "file") == 0 && num == 3 && fields[1] != NULL &&
+			fields[2] != NULL)
+			rc = snap_read_file(fp, fields[1], atol(fields[2]));
+		else if (strcmp(fields[0], "stat") == 0 && num == 3 &&
+			(obj = snap_find_obj(fields[1])) >= 0) {
+			if ((ent = snap_new_entry(obj, fields[2])) == NULL)
+				rc = 0;
+			bs_tail = NULL;
+		}
+		else if (strcmp(fields[0], "obj") == 0 && num == 2 && ent != NULL) {
+			if ((bs = calloc(1, sizeof(struct batch_status))) == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				rc = 0;
+				break;
+			}
+			bs->name = string_dup(fields[1]);
+			if (bs_tail == NULL)
+				ent->bs = bs;
+			else
+				bs_tail->next = bs;
+			bs_tail = bs;
+			attr_tail = NULL;
+		}
+		else if (strcmp(fields[0], "attr") == 0 && num == 4 && bs_tail != NULL) {
+			if ((attr = new_attrl()) == NULL) {
+				rc = 0;
+				break;
+			}
+			attr->name = string_dup(fields[1]);
+			attr->resource = string_dup(fields[2]);
+			attr->value = string_dup(fields[3]);
+			if (attr_tail == NULL)
+				bs_tail->attribs = attr;
+			else
+				attr_tail->next = attr;
+			attr_tail = attr;
+		}
+		else if (strcmp(fields[0], "end") == 0 && num == 1) {
+			ent = NULL;
+			bs_tail = NULL;
+		}
+		else if (strcmp(fields[0], snap_obj_names[SNAP_DYN_RES]) == 0 &&
+			num == 3 && fields[1] != NULL) {
+			if ((ent = snap_new_entry(SNAP_DYN_RES, fields[1])) == NULL)
+				rc = 0;
+			else if (fields[2] != NULL)
+				ent->output = string_dup(fields[2]);
+			ent = NULL;
+		}
+		else
+			rc = 0;
+	}
+
+	if (!rc) {
+		sprintf(log_buffer, "Error reading snapshot %s at line %d",
+			fname, linenum);
+		log_err(-1, __func__, log_buffer);
+		free_snapshot();
+	}
+	else
+		snap_replay = 1;
+
+	free(buf);
+	fclose(fp);
+
+	return rc;
+}
+
+/**
+ * @brief
+ * 		free a snapshot read by snapshot_load() and stop replaying it
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+free_snapshot(void)
+{
+	int i;
+
+	for (i = 0; i < snap_num_entries; i++) {
+		free(snap_entries[i].key);
+		free(snap_entries[i].output);
+		pbs_statfree(snap_entries[i].bs);
+	}
+	free(snap_entries);
+	snap_entries = NULL;
+	snap_num_entries = 0;
+	snap_replay = 0;
+	snap_cycle_time = 0;
+}
+
+/**
+ * @brief
+ * 		are we replaying a snapshot instead of talking to a server?
+ *
+ * @return	int
+ * @retval	1	: replaying
+ * @retval	0	: not replaying
+ */
+int
+snapshot_replaying(void)
+{
+	return snap_replay;
+}
+
+/**
+ * @brief
+ * 		the time a snapshot being replayed was taken.  The replayed
+ *		cycle runs at this time so it makes the same decisions.
+ *
+ * @return	time_t
+ * @retval	0	: not replaying
+ */
+time_t
+snapshot_time(void)
+{
+	return snap_cycle_time;
+}
+
+/**
+ * @brief
+ * 		allow all the replies of a snapshot to be returned again.
+ *		Called before each replayed cycle.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+snapshot_rewind(void)
+{
+	int i;
+
+	for (i = 0; i < snap_num_entries; i++)
+		snap_entries[i].used = 0;
+}
+
+/**
+ * @brief
+ * 		return a copy of the next reply in a snapshot.  If the same query
+ *		was made more than once in the cycle, the replies are returned in
+ *		the order they were made.
+ *
+ * @param[in]	obj	-	what is being queried
+ * @param[in]	key	-	the queue for jobs, otherwise NULL
+ *
+ * @return	struct batch_status *
+ * @retval	copy of the reply - free with pbs_statfree()
+ * @retval	NULL	: no reply, an empty reply or on error
+ *
+ * @par MT-safe: No
+ */
+struct batch_status *
+snapshot_get(enum snap_obj obj, char *key)
+{
+	int i;
+
+	for (i = 0; i < snap_num_entries; i++) {
+		if (snap_entries[i].obj != obj || snap_entries[i].used)
+			continue;
+		if (key != NULL && (snap_entries[i].key == NULL ||
+			strcmp(snap_entries[i].key, key) != 0))
+			continue;
+
+		snap_entries[i].used = 1;
+		return snap_dup_status(snap_entries[i].bs);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		find the output of a server_dyn_res program in a snapshot
+ *
+ * @param[in]	program	-	the server_dyn_res program
+ * @param[out]	buf	-	buffer for the output
+ * @param[in]	len	-	size of buf
+ *
+ * @return	int
+ * @retval	length of the output
+ * @retval	0	: program's output is not in the snapshot
+ */
+int
+snapshot_get_dyn_res(char *program, char *buf, int len)
+{
+	int i;
+
+	if (program == NULL || buf == NULL || len <= 0)
+		return 0;
+
+	for (i = 0; i < snap_num_entries; i++) {
+		if (snap_entries[i].obj == SNAP_DYN_RES &&
+			snap_entries[i].output != NULL &&
+			strcmp(snap_entries[i].key, program) == 0) {
+			snprintf(buf, len, "%s", snap_entries[i].output);
+			return strlen(buf);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+#ifndef	_SNAPSHOT_H
+#define	_SNAPSHOT_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <time.h>
+#include <pbs_ifl.h>
+
+/* the kinds of server replies kept in a snapshot */
+enum snap_obj {
+	SNAP_SERVER,
+	SNAP_SCHED,
+	SNAP_QUEUE,
+	SNAP_VNODE,
+	SNAP_JOB,			/* keyed by queue name */
+	SNAP_RESV,
+	SNAP_RESOURCE,
+	SNAP_DYN_RES,			/* server_dyn_res output, keyed by program */
+	SNAP_OBJ_LAST
+};
+
+/* set by a signal to snapshot the next scheduling cycle */
+extern int snapshot_requested;
+
+/*
+ *	snapshot_begin - start writing a snapshot of a scheduling cycle,
+ *			 starting with the scheduler's config files
+ */
+int snapshot_begin(char *fname);
+
+/* finish writing the snapshot started by snapshot_begin() */
+void snapshot_end(void);
+
+/* add a reply from the server to the snapshot being written */
+void snapshot_put(enum snap_obj obj, char *key, struct batch_status *bs);
+
+/* add the output of a server_dyn_res program to the snapshot being written */
+void snapshot_put_dyn_res(char *program, char *output);
+
+/*
+ *	snapshot_load - read a snapshot to be replayed and write its config
+ *			files into the current directory
+ */
+int snapshot_load(char *fname);
+
+/* free a snapshot read by snapshot_load() */
+void free_snapshot(void);
+
+/* are we replaying a snapshot instead of talking to a server? */
+int snapshot_replaying(void);
+
+/* the time the snapshot was taken or 0 if we're not replaying */
+time_t snapshot_time(void);
+
+/* allow the replies of a snapshot to be returned again for the next cycle */
+void snapshot_rewind(void);
+
+/* return a copy of the next reply in a snapshot (free with pbs_statfree()) */
+struct batch_status *snapshot_get(enum snap_obj obj, char *key);
+
+/* find the output of a server_dyn_res program in a snapshot */
+int snapshot_get_dyn_res(char *program, char *buf, int len);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _SNAPSHOT_H */
@@ -1519,6 +1519,9 @@ sort_jobs(status *policy, server_info *sinfo)
 	int index = 0;
 	int count = 0;
 
+	/* the job index has to hold every job before the jobs are reordered */
+	update_obj_index(sinfo->jobs_idx, (void **) sinfo->jobs);
+
 	/** sort jobs in such a way that Higher Priority jobs come on top
 	 * followed by preempted jobs and then starving jobs and normal jobs
 	 */
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    trace.c
+ *
+ * @brief
+ * 	trace.c - in-memory trace of the decisions made on jobs.  When
+ *	decision_trace is set, a fixed size ring holds a record of each job
+ *	considered in main_sched_loop(): how its fate was decided, the error
+ *	why it could not run and the number of vnodes checked for it.  The
+ *	records are kept in binary form and only turned into text when the
+ *	trace is written to TRACE_FILE, which pbs_sched does on SIGUSR2.  This
+ *	tells why a job did not run without raising the log_events level.
+ *
+ * Functions included are:
+ * 	trace_copy()
+ * 	trace_cycle_start()
+ * 	trace_job_start()
+ * 	trace_decision()
+ * 	trace_dump()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <log.h>
+#include <pbs_ifl.h>
+#include "constant.h"
+#include "config.h"
+#include "data_types.h"
+#include "globals.h"
+#include "misc.h"
+#include "job_info.h"
+#include "resource.h"
+#include "trace.h"
+
+/* one decision on a job.  The strings of its error are copied so the
+ * record outlives the cycle's jobs and resource definitions.
+ */
+struct trace_rec {
+	time_t time;			/* when the decision was made */
+	long cycle;			/* the cycle the decision was made in */
+	enum trace_phase phase;
+	int nodes_tested;		/* vnodes checked for the job */
+	enum sched_error error_code;
+	enum schd_err_status status_code;
+	char name[PBS_MAXSVRJOBID + 1];	/* the job */
+	char res[TRACE_ARG_SIZE];	/* name of the error's resource */
+	char arg1[TRACE_ARG_SIZE];
+	char arg2[TRACE_ARG_SIZE];
+	char arg3[TRACE_ARG_SIZE];
+	char specmsg[TRACE_ARG_SIZE];
+};
+
+static char *trace_phase_names[TRACE_PHASE_LAST] = {
+	"run",
+	"run_by_preemption",
+	"not_run",
+	"equiv_class_not_run",
+	"top_job"
+};
+
+int trace_requested = 0;
+int trace_nodes_tested = 0;
+
+static struct trace_rec *trace_ring = NULL;
+static int trace_next = 0;		/* next record to write */
+static int trace_full = 0;		/* the ring has wrapped */
+static long trace_cycle = 0;		/* cycles traced */
+static int trace_active = 0;		/* tracing the current cycle */
+
+/**
+ * @brief
+ * 		copy a string into a fixed size buffer of a trace record,
+ *		truncating it if needed
+ *
+ * @param[out]	dst	-	the buffer
+ * @param[in]	src	-	the string, may be NULL
+ * @param[in]	size	-	the size of dst
+ *
+ * @return	void
+ */
+static void
+trace_copy(char *dst, const char *src, size_t size)
+{
+	if (src == NULL) {
+		dst[0] = '\0';
+		return;
+	}
+	strncpy(dst, src, size - 1);
+	dst[size - 1] = '\0';
+}
+
+/**
+ * @brief
+ * 		start tracing a scheduling cycle.  Nothing is traced unless
+ *		decision_trace is set in the scheduler's config.  The ring is
+ *		allocated the first time it is needed.
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+trace_cycle_start(void)
+{
+	trace_active = conf.decision_trace;
+	if (!trace_active)
+		return;
+
+	if (trace_ring == NULL) {
+		trace_ring = calloc(TRACE_RING_SIZE, sizeof(struct trace_rec));
+		if (trace_ring == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			trace_active = 0;
+			return;
+		}
+	}
+	trace_cycle++;
+}
+
+/**
+ * @brief
+ * 		start tracing the decision on a job
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+trace_job_start(void)
+{
+	trace_nodes_tested = 0;
+}
+
+/**
+ * @brief
+ * 		record the decision made on a job in the ring, overwriting
+ *		the oldest record once the ring is full
+ *
+ * @param[in]	resresv	-	the job
+ * @param[in]	phase	-	how the job's fate was decided
+ * @param[in]	err	-	why the job could not run, may be NULL
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+void
+trace_decision(resource_resv *resresv, enum trace_phase phase, schd_error *err)
+{
+	struct trace_rec *rec;
+
+	if (!trace_active || resresv == NULL)
+		return;
+
+	rec = &trace_ring[trace_next];
+	rec->time = cstat.current_time;
+	rec->cycle = trace_cycle;
+	rec->phase = phase;
+	rec->nodes_tested = trace_nodes_tested;
+	trace_copy(rec->name, resresv->name, sizeof(rec->name));
+	if (err != NULL) {
+		rec->error_code = err->error_code;
+		rec->status_code = err->status_code;
+		trace_copy(rec->res, err->rdef != NULL ? err->rdef->name : NULL,
+			sizeof(rec->res));
+		trace_copy(rec->arg1, err->arg1, sizeof(rec->arg1));
+		trace_copy(rec->arg2, err->arg2, sizeof(rec->arg2));
+		trace_copy(rec->arg3, err->arg3, sizeof(rec->arg3));
+		trace_copy(rec->specmsg, err->specmsg, sizeof(rec->specmsg));
+	} else {
+		rec->error_code = SUCCESS;
+		rec->status_code = SCHD_UNKWN;
+		rec->res[0] = '\0';
+		rec->arg1[0] = '\0';
+		rec->arg2[0] = '\0';
+		rec->arg3[0] = '\0';
+		rec->specmsg[0] = '\0';
+	}
+
+	if (++trace_next == TRACE_RING_SIZE) {
+		trace_next = 0;
+		trace_full = 1;
+	}
+}
+
+/**
+ * @brief
+ * 		write the records in the ring to TRACE_FILE, oldest first.  The
+ *		error of each record is translated into its log message here
+ *		rather than when it was recorded.  Each line is
+ *		time;cycle;job;phase;vnodes tested;error code;message
+ *
+ * @return	int
+ * @retval	number of records written
+ * @retval	-1	: failure
+ *
+ * @par MT-safe: No
+ */
+int
+trace_dump(void)
+{
+	FILE *fp;
+	struct trace_rec *rec;
+	schd_error err;
+	char msg[MAX_LOG_SIZE];
+	char timebuf[TIMEBUF_SIZE];
+	struct tm *ptm;
+	int num;
+	int i;
+	int n;
+
+	if ((fp = fopen(TRACE_FILE, "w")) == NULL) {
+		sprintf(log_buffer, "Error opening file %s", TRACE_FILE);
+		log_err(errno, __func__, log_buffer);
+		return -1;
+	}
+
+	num = 0;
+	if (trace_ring != NULL)
+		num = trace_full ? TRACE_RING_SIZE : trace_next;
+
+	for (n = 0; n < num; n++) {
+		i = trace_full ? (trace_next + n) % TRACE_RING_SIZE : n;
+		rec = &trace_ring[i];
+
+		memset(&err, 0, sizeof(err));
+		err.error_code = rec->error_code;
+		err.status_code = rec->status_code;
+		if (rec->res[0] != '\0')
+			err.rdef = find_resdef(allres, rec->res);
+		if (rec->arg1[0] != '\0')
+			err.arg1 = rec->arg1;
+		if (rec->arg2[0] != '\0')
+			err.arg2 = rec->arg2;
+		if (rec->arg3[0] != '\0')
+			err.arg3 = rec->arg3;
+		if (rec->specmsg[0] != '\0')
+			err.specmsg = rec->specmsg;
+		msg[0] = '\0';
+		if (rec->error_code != SUCCESS)
+			translate_fail_code(&err, NULL, msg);
+
+		timebuf[0] = '\0';
+		if ((ptm = localtime(&rec->time)) != NULL)
+			strftime(timebuf, sizeof(timebuf), "%m/%d/%Y %H:%M:%S", ptm);
+
+		fprintf(fp, "%s;%ld;%s;%s;%d;%d;%s\n", timebuf, rec->cycle,
+			rec->name, trace_phase_names[rec->phase], rec->nodes_tested,
+			(int) rec->error_code, msg);
+	}
+	fclose(fp);
+
+	sprintf(log_buffer, "Wrote %d job decisions to %s", num, TRACE_FILE);
+	schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_INFO, __func__,
+		log_buffer);
+
+	return num;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 1994-2016 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *  
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ * 
+ * Open Source License Information:
+ *  
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free 
+ * Software Foundation, either version 3 of the License, or (at your option) any 
+ * later version.
+ *  
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY 
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Affero General Public License for more details.
+ *  
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *  
+ * Commercial License Information: 
+ * 
+ * The PBS Pro software is licensed under the terms of the GNU Affero General 
+ * Public License agreement ("AGPL"), except where a separate commercial license 
+ * agreement for PBS Pro version 14 or later has been executed in writing with Altair.
+ *  
+ * Altair’s dual-license business model allows companies, individuals, and 
+ * organizations to create proprietary derivative works of PBS Pro and distribute 
+ * them - whether embedded or bundled with other software - under a commercial 
+ * license agreement.
+ * 
+ * Use of Altair’s trademarks, including but not limited to "PBS™", 
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's 
+ * trademark licensing policies.
+ *
+ */
+#ifndef	_TRACE_H
+#define	_TRACE_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "data_types.h"
+
+/* how the scheduler decided a job's fate in main_sched_loop() */
+enum trace_phase {
+	TRACE_RUN,			/* the job was run */
+	TRACE_PREEMPT_RUN,		/* the job was run by preempting jobs */
+	TRACE_NOT_RUN,			/* the job could not run */
+	TRACE_EQUIV_CLASS,		/* an alike job could not run, so neither can this one */
+	TRACE_TOP_JOB,			/* the job could not run and was added to the calendar */
+	TRACE_PHASE_LAST
+};
+
+/* set to write the decision trace to TRACE_FILE */
+extern int trace_requested;
+
+/* number of vnodes checked for the job being considered */
+extern int trace_nodes_tested;
+
+/* start tracing a scheduling cycle if decision_trace is set */
+void trace_cycle_start(void);
+
+/* start tracing the decision on a job */
+void trace_job_start(void);
+
+/* record the decision made on a job */
+void trace_decision(resource_resv *resresv, enum trace_phase phase, schd_error *err);
+
+/* write the decision trace to TRACE_FILE */
+int trace_dump(void);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _TRACE_H */
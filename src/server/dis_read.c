@@ -613,6 +613,10 @@ dis_request_read(int sfds, struct batch_request *request)
 			rc = decode_DIS_Manage(sfds, request);
 			break;
 
+		case PBS_BATCH_ModifyJobs:
+			rc = decode_DIS_ModifyJobs(sfds, request);
+			break;
+
 		case PBS_BATCH_MoveJob:
 		case PBS_BATCH_OrderJob:
 			rc = decode_DIS_MoveJob(sfds, request);
@@ -625,6 +629,10 @@ dis_request_read(int sfds, struct batch_request *request)
 			rc = decode_DIS_Run(sfds, request);
 			break;
 
+		case PBS_BATCH_AsyrunJobs:
+			rc = decode_DIS_RunJobs(sfds, request);
+			break;
+
 		case PBS_BATCH_DefSchReply:
 			request->rq_ind.rq_defrpy.rq_cmd = disrsi(sfds, &rc);
 			if (rc) break;
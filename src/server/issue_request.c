@@ -79,7 +79,6 @@
 /* Global Data Items: */
 
 extern struct connect_handle connection[];
-extern pbs_list_head task_list_event;
 extern time_t	time_now;
 extern char	*msg_issuebad;
 extern char     *msg_norelytomom;
@@ -336,6 +335,7 @@ add_mom_deferred_list(int stream, mominfo_t *minfo, void (*func)(), char *msgid,
 	 * and there is no child process whose exit needs to be reaped
 	 */
 	delete_link(&ptask->wt_linkall);
+	delete_link(&ptask->wt_linkevent);
 
 	/* append to the moms deferred command list */
 	append_link(&(((mom_svrinfo_t *) (minfo->mi_data))->msr_deferred_cmds), &ptask->wt_linkobj2, ptask);
@@ -693,6 +693,7 @@ issue_Drequest(int conn,
 			 * caller will add to moms deferred cmd list
 			 */
 			delete_link(&ptask->wt_linkall);
+			delete_link(&ptask->wt_linkevent);
 		}
 		ptask->wt_aux2 = rpp; /* 0 in case of non-TPP */
 		*ppwt = ptask;
@@ -721,10 +722,6 @@ process_Dreply(int sock)
 	int                     i;
 #endif
 
-	/* find the work task for the socket, it will point us to the request */
-
-	ptask = (struct work_task *)GET_NEXT(task_list_event);
-
 #ifdef WIN32
 	handle = -1;
 	for (i=0;i < PBS_MAX_CONNECTIONS; i++) {
@@ -737,12 +734,9 @@ process_Dreply(int sock)
 	handle = svr_conn[sock].cn_handle;
 #endif
 
-	while (ptask) {
-		if ((ptask->wt_type == WORK_Deferred_Reply) &&
-			(ptask->wt_event == handle))
-			break;
-		ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
-	}
+	/* find the work task for the socket, it will point us to the request */
+
+	ptask = find_work_task(WORK_Deferred_Reply, (long)handle, NULL);
 	if (!ptask) {
 		close_conn(sock);
 		return;
@@ -324,6 +324,7 @@ job_alloc(void)
 	CLEAR_LINK(pj->ji_alljobs);
 	CLEAR_LINK(pj->ji_jobque);
 	CLEAR_LINK(pj->ji_unlicjobs);
+	CLEAR_LINK(pj->ji_ownerjobs);
 #ifdef	PBS_CRED_GRIDPROXY
 	pj->ji_gsscontext = GSS_C_NO_CONTEXT;
 #endif
@@ -363,6 +364,8 @@ job_alloc(void)
 	pj->ji_deletehistory = 0;
 	pj->ji_newjob = 0;
 	pj->ji_script = NULL;
+	CLEAR_LINK(pj->ji_dbsavelink);
+	pj->ji_dbsavetype = -1;
 #endif
 	pj->ji_qs.ji_jsversion = JSVERSION;
 	pj->ji_momhandle = -1;		/* mark mom connection invalid */
@@ -494,6 +497,9 @@ job_free(job *pj)
 		struct work_task	*pwt;
 		badplace		*bp;
 
+		/* a job going away must not be saved later */
+		cancel_job_save(pj);
+
 		/*
 		 * Delete any work task entries associated with the job.
 		 * mom deferred tasks via TPP are also hooked into the
@@ -801,6 +807,7 @@ job_purge(job *pjob)
 	}
 #else
 	/* delete job and dependants from database */
+	cancel_job_save(pjob);
 	if (!(pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob)) {
 		obj.pbs_db_obj_type = PBS_DB_JOB;
 		obj.pbs_db_un.pbs_db_job = &dbjob;
@@ -47,6 +47,12 @@
  * Functions included are:
  *
  *	job_save_db()         -	save job to database
+ *	job_save_db_sync()    -	save job to database at once
+ *	job_save_db_defer()   -	save job to database, maybe later
+ *	job_save_db_now()     -	write job to database
+ *	flush_job_saves()     -	write the deferred job saves to database
+ *	flush_job_saves_task() - work task writing the deferred job saves
+ *	cancel_job_save()     -	forget a deferred job save
  *	job_or_resv_save_db() -	save to database (job/reservation)
  *	job_recov_db()        - recover(read) job from database
  *	job_or_resv_recov_db() -	recover(read) job/reservation from database
@@ -99,6 +105,7 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "work_task.h"
 
 
 #define MAX_SAVE_TRIES 3
@@ -127,6 +134,30 @@ extern time_t time_now;
 
 #ifndef PBS_MOM
 
+/*
+ * Saves of jobs to the database which are deferred, indexed by update type.
+ * A deferred save returns at once; the job is written at most
+ * PBS_JOB_SAVE_DELAY seconds later along with the other jobs saved in the
+ * meantime, in one transaction.  Saving a job several times before then
+ * writes it once.  A new job must be in the database before the reply to
+ * its submission, so SAVEJOB_NEW is never deferred, nor is SAVEJOB_FULLFORCE.
+ * Whatever the update type, job_save_db_sync() writes at once; it is used for
+ * a job becoming running, exiting or moved (see svr_setjobstate).
+ */
+static int job_save_deferred[] = {
+	1,	/* SAVEJOB_QUICK */
+	1,	/* SAVEJOB_FULL */
+	0,	/* SAVEJOB_NEW */
+	0	/* SAVEJOB_FULLFORCE */
+};
+
+static pbs_list_head pending_job_saves;	/* jobs with a deferred save */
+static int num_pending_job_saves = 0;
+static struct work_task *job_save_task = NULL;	/* task to write them */
+
+static int job_save_db_defer(job *pjob, int updatetype, int defer);
+static int job_save_db_now(job *pjob, int updatetype);
+
 /**
  * @brief
  *		Load a server job object to a database job object
@@ -356,10 +387,92 @@ db_to_svr_subjob(struct ajtrk *trk, pbs_db_subjob_info_t *psubjob)
 }
 
 
+/**
+ * @brief
+ *		Forget the deferred save of a job, if it has one.  Called when
+ *		the job is saved at once or is going away.
+ *
+ * @param[in]	pjob - The job
+ *
+ * @return void
+ */
+void
+cancel_job_save(job *pjob)
+{
+	if (pjob->ji_dbsavetype == -1)
+		return;
+
+	delete_link(&pjob->ji_dbsavelink);
+	pjob->ji_dbsavetype = -1;
+	num_pending_job_saves--;
+}
+
+/**
+ * @brief
+ *		Write the deferred job saves to the database in one transaction.
+ *
+ * @see
+ * 		job_save_db, flush_job_saves_task
+ *
+ * @return void
+ */
+void
+flush_job_saves(void)
+{
+	job *pjob;
+	int updatetype;
+	int trx;
+
+	if (job_save_task != NULL) {
+		delete_task(job_save_task);
+		job_save_task = NULL;
+	}
+	if (num_pending_job_saves == 0)
+		return;
+
+	/* each job's own transaction nests inside this one */
+	trx = (pbs_db_begin_trx(svr_db_conn, 0, 0) == 0);
+
+	while ((pjob = (job *)GET_NEXT(pending_job_saves)) != NULL) {
+		updatetype = pjob->ji_dbsavetype;
+		cancel_job_save(pjob);
+		(void)job_save_db_now(pjob, updatetype);
+	}
+
+	if (trx && pbs_db_end_trx(svr_db_conn, PBS_DB_COMMIT) != 0) {
+		sprintf(log_buffer, "Failed to save jobs ");
+		if (svr_db_conn->conn_db_err != NULL)
+			strncat(log_buffer, svr_db_conn->conn_db_err,
+				LOG_BUF_SIZE - strlen(log_buffer) - 1);
+		log_err(-1, __func__, log_buffer);
+		panic_stop_db(log_buffer);
+	}
+}
+
+/**
+ * @brief
+ *		Work task to write the deferred job saves to the database.
+ *
+ * @param[in]	ptask - The work task
+ *
+ * @return void
+ */
+static void
+flush_job_saves_task(struct work_task *ptask)
+{
+	job_save_task = NULL;
+	flush_job_saves();
+}
+
 /**
  * @brief
  *		Save job to database
  *
+ * @par
+ *		Update types for which job_save_deferred is set are written later
+ *		by flush_job_saves() unless a transaction is already open, in
+ *		which case the job is saved as part of it.
+ *
  * @param[in]	pjob - The job to save
  * @param[in]   updatetype:
  *				SAVEJOB_QUICK - Quick update, save only quick save area
@@ -375,14 +488,48 @@ db_to_svr_subjob(struct ajtrk *trk, pbs_db_subjob_info_t *psubjob)
 int
 job_save_db(job *pjob, int updatetype)
 {
-	pbs_db_attr_info_t attr_info;
-	pbs_db_job_info_t dbjob;
-	pbs_db_subjob_info_t dbsubjob;
-	int	isarray = 0;
-	pbs_db_obj_info_t obj;
-	pbs_db_conn_t *conn = svr_db_conn;
-	int i;
+	return (job_save_db_defer(pjob, updatetype, 1));
+}
+
+/**
+ * @brief
+ *		Save job to database before returning, whatever the update type.
+ *		Used for changes which must not be lost if the server stops, such
+ *		as the job being sent to execution.
+ *
+ * @param[in]	pjob - The job to save
+ * @param[in]   updatetype - see job_save_db
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ *
+ */
+int
+job_save_db_sync(job *pjob, int updatetype)
+{
+	return (job_save_db_defer(pjob, updatetype, 0));
+}
 
+/**
+ * @brief
+ *		Save job to database, deferring the write if allowed
+ *
+ * @see
+ * 		job_save_db, job_save_db_sync
+ *
+ * @param[in]	pjob - The job to save
+ * @param[in]   updatetype - see job_save_db
+ * @param[in]	defer - the write may be deferred by job_save_deferred
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ *
+ */
+static int
+job_save_db_defer(job *pjob, int updatetype, int defer)
+{
 	/*
 	 * if job has new_job flag set, then updatetype better be SAVEJOB_NEW
 	 * If not, ignore and return success
@@ -412,6 +559,60 @@ job_save_db(job *pjob, int updatetype)
 		updatetype = SAVEJOB_FULLFORCE;
 	}
 
+	if (defer && updatetype >= SAVEJOB_QUICK && updatetype <= SAVEJOB_FULLFORCE &&
+		job_save_deferred[updatetype] && svr_db_conn->conn_trx_nest == 0) {
+		if (pjob->ji_dbsavetype == -1) {
+			if (num_pending_job_saves == 0)
+				CLEAR_HEAD(pending_job_saves);
+			append_link(&pending_job_saves, &pjob->ji_dbsavelink, pjob);
+			pjob->ji_dbsavetype = updatetype;
+			num_pending_job_saves++;
+		} else if (updatetype == SAVEJOB_FULL)
+			pjob->ji_dbsavetype = SAVEJOB_FULL;
+
+		if (num_pending_job_saves >= PBS_JOB_SAVE_MAX_PENDING)
+			flush_job_saves();
+		else if (job_save_task == NULL)
+			job_save_task = set_task(WORK_Timed,
+				time_now + PBS_JOB_SAVE_DELAY, flush_job_saves_task, NULL);
+		return (0);
+	}
+
+	/* a deferred full save is not lost to a quick one */
+	if (pjob->ji_dbsavetype == SAVEJOB_FULL && updatetype == SAVEJOB_QUICK)
+		updatetype = SAVEJOB_FULL;
+	cancel_job_save(pjob);
+
+	return (job_save_db_now(pjob, updatetype));
+}
+
+/**
+ * @brief
+ *		Write job to database
+ *
+ * @see
+ * 		job_save_db, flush_job_saves
+ *
+ * @param[in]	pjob - The job to write
+ * @param[in]   updatetype - SAVEJOB_QUICK, SAVEJOB_FULL, SAVEJOB_NEW or
+ *				SAVEJOB_FULLFORCE (see job_save_db)
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ *
+ */
+static int
+job_save_db_now(job *pjob, int updatetype)
+{
+	pbs_db_attr_info_t attr_info;
+	pbs_db_job_info_t dbjob;
+	pbs_db_subjob_info_t dbsubjob;
+	int	isarray = 0;
+	pbs_db_obj_info_t obj;
+	pbs_db_conn_t *conn = svr_db_conn;
+	int i;
+
 	svr_to_db_job(pjob, &dbjob);
 	obj.pbs_db_obj_type = PBS_DB_JOB;
 	obj.pbs_db_un.pbs_db_job = &dbjob;
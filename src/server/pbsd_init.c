@@ -983,6 +983,11 @@ pbsd_init(int type)
 	}
 	avl_create_index(AVL_jctx, AVL_NO_DUP_KEYS, 0);
 
+	/* index of jobs by owner, used by select; optional, so no error */
+	AVL_jowner = (AVL_IX_DESC *) malloc(sizeof(AVL_IX_DESC));
+	if (AVL_jowner != NULL)
+		avl_create_index(AVL_jowner, AVL_NO_DUP_KEYS, 0);
+
 	had = server.sv_qs.sv_numjobs;
 	server.sv_qs.sv_numjobs = 0;
 
@@ -316,6 +316,7 @@ long		  svr_history_enable = 0; /*disable by default*/
 long		  svr_history_duration = SVR_JOBHIST_DEFAULT; /* default 2 weeks */
 
 AVL_IX_DESC	*AVL_jctx = NULL;
+AVL_IX_DESC	*AVL_jowner = NULL;	/* jobs by owner, see svr_ownerjob_oper() */
 
 #ifdef WIN32
 void WINAPI PbsServerMain(DWORD dwArgc, LPTSTR *rgszArgv);
@@ -2131,7 +2132,8 @@ try_db_again:
 	svr_save_db(&server, SVR_SAVE_FULL);	/* final recording of server */
 	track_save((struct work_task *)0);	/* save tracking data	     */
 
-	/* save any jobs that need saving */
+	/* write any deferred job saves, then save any jobs that need saving */
+	flush_job_saves();
 	for (pjob = (job *)GET_NEXT(svr_alljobs);
 		pjob;
 		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
@@ -2209,6 +2211,11 @@ try_db_again:
 		free(AVL_jctx);
 		AVL_jctx = NULL;
 	}
+	if (AVL_jowner != NULL) {
+		avl_destroy_index(AVL_jowner);
+		free(AVL_jowner);
+		AVL_jowner = NULL;
+	}
 
 	{
 		int csret;
@@ -67,6 +67,8 @@
  *	decode_DIS_PySpawn()
  *	free_br()
  *	freebr_manage()
+ *	freebr_modifyjobs()
+ *	freebr_runjobs()
  *	freebr_cpyfile()
  *	freebr_cpyfile_cred()
  *	parse_servername()
@@ -138,6 +140,10 @@ extern const char libmunge[];
 /* Private functions local to this file */
 
 static void freebr_manage(struct rq_manage *);
+#ifndef PBS_MOM
+static void freebr_modifyjobs(struct rq_modifyjobs *);
+static void freebr_runjobs(struct rq_runjobs *);
+#endif /* PBS_MOM */
 static void freebr_cpyfile(struct rq_cpyfile *);
 static void freebr_cpyfile_cred(struct rq_cpyfile_cred *);
 static void close_quejob(int sfds);
@@ -685,6 +691,7 @@ process_request(int sfds)
 	if (server.sv_attr[(int)SRV_ATR_State].at_val.at_long > SV_STATE_RUN) {
 		switch (request->rq_type) {
 			case PBS_BATCH_AsyrunJob:
+			case PBS_BATCH_AsyrunJobs:
 			case PBS_BATCH_JobCred:
 			case PBS_BATCH_UserCred:
 			case PBS_BATCH_UserMigrate:
@@ -954,6 +961,10 @@ dispatch_request(int sfds, struct batch_request *request)
 		case PBS_BATCH_Manager:
 			req_manager(request);
 			break;
+
+		case PBS_BATCH_ModifyJobs:
+			req_modifyjobs(request);
+			break;
 #endif
 		case PBS_BATCH_MessJob:
 			req_messagejob(request);
@@ -1004,6 +1015,10 @@ dispatch_request(int sfds, struct batch_request *request)
 			req_runjob(request);
 			break;
 
+		case PBS_BATCH_AsyrunJobs:
+			req_asyrunjobs(request);
+			break;
+
 		case PBS_BATCH_DefSchReply:
 			req_defschedreply(request);
 			break;
@@ -1464,6 +1479,11 @@ free_br(struct batch_request *preq)
 		 * decrement the reference count in the parent and when it
 		 * goes to zero,  reply_send() it
 		 */
+#ifndef PBS_MOM
+		/* except for the attributes a Modify Jobs request moved to us */
+		if (preq->rq_parentbr->rq_type == PBS_BATCH_ModifyJobs)
+			freebr_manage(&preq->rq_ind.rq_modify);
+#endif /* PBS_MOM */
 		if (preq->rq_parentbr->rq_refct > 0) {
 			if (--preq->rq_parentbr->rq_refct == 0)
 				reply_send(preq->rq_parentbr);
@@ -1563,6 +1583,12 @@ free_br(struct batch_request *preq)
 		case PBS_BATCH_Manager:
 			freebr_manage(&preq->rq_ind.rq_manager);
 			break;
+		case PBS_BATCH_ModifyJobs:
+			freebr_modifyjobs(&preq->rq_ind.rq_modifyjobs);
+			break;
+		case PBS_BATCH_AsyrunJobs:
+			freebr_runjobs(&preq->rq_ind.rq_runjobs);
+			break;
 		case PBS_BATCH_ReleaseJob:
 			freebr_manage(&preq->rq_ind.rq_release);
 			break;
@@ -1597,6 +1623,49 @@ freebr_manage(struct rq_manage *pmgr)
 {
 	free_attrlist(&pmgr->rq_attr);
 }
+#ifndef PBS_MOM
+/**
+ * @brief
+ * 		free the per job Manage structures of a Modify Jobs request
+ *
+ * @param[in]	pmj - request modify jobs structure.
+ */
+static void
+freebr_modifyjobs(struct rq_modifyjobs *pmj)
+{
+	int i;
+
+	if (pmj->rq_jobs == NULL)
+		return;
+	for (i = 0; i < pmj->rq_count; i++)
+		freebr_manage(&pmj->rq_jobs[i]);
+	free(pmj->rq_jobs);
+	pmj->rq_jobs = NULL;
+	pmj->rq_count = 0;
+}
+
+/**
+ * @brief
+ * 		free the per job destinations of an Asynchronous Run Jobs request
+ *
+ * @param[in]	prj - request run jobs structure.
+ */
+static void
+freebr_runjobs(struct rq_runjobs *prj)
+{
+	int i;
+
+	if (prj->rq_jobs == NULL)
+		return;
+	for (i = 0; i < prj->rq_count; i++) {
+		if (prj->rq_jobs[i].rq_destin)
+			free(prj->rq_jobs[i].rq_destin);
+	}
+	free(prj->rq_jobs);
+	prj->rq_jobs = NULL;
+	prj->rq_count = 0;
+}
+#endif /* PBS_MOM */
 /**
  * @brief
  * 		remove all the rqfpair and free their memory
@@ -50,6 +50,7 @@
  *	set_err_msg() - set a message relating to the error "code"
  *	dis_reply_write()	- reply is sent to a remote client
  *	reply_badattr()	- Create a reject (error) reply for a request including the name of the bad attribute/resource.
+ *	reply_job_error()	- add the error of a child request to the per job status of its parent
  *
  */
 
@@ -82,7 +83,6 @@ extern char *msg_daemonname;
 extern char *msg_system;
 
 #ifndef PBS_MOM
-extern pbs_list_head task_list_event;
 extern pbs_list_head task_list_immed;
 char   *resc_in_err = NULL;
 #endif	/* PBS_MOM */
@@ -208,6 +208,82 @@ dis_reply_write(int sfds, struct batch_request *preq)
 	return rc;
 }
 
+/**
+ * @brief
+ * 		Add the error of a child request to the reply of its parent request,
+ *		for requests made of several jobs (Modify Jobs, Async Run Jobs).
+ *
+ * @par
+ *		The parent reply carries the code of the first error, and a status
+ *		entry for each job which failed with the error code and message of
+ *		that job, so the client can tell which jobs were not done.
+ *
+ * @param[in,out]	parent	- the parent request
+ * @param[in]	child	- the child request which failed
+ *
+ * @return	error code
+ * @retval	0	- success
+ * @retval	PBSE_SYSTEM	- out of memory
+ */
+static int
+reply_job_error(struct batch_request *parent, struct batch_request *child)
+{
+	struct batch_reply *preply = &parent->rq_reply;
+	struct brp_status  *pstat;
+	svrattrl	   *pal;
+	char		   *jobid;
+	char		   *msg;
+	char		    msgbuf[ERR_MSG_SIZE];
+	char		    codebuf[20];
+
+	if (preply->brp_choice != BATCH_REPLY_CHOICE_Status) {
+		if (preply->brp_choice != BATCH_REPLY_CHOICE_NULL)
+			reply_free(preply);
+		preply->brp_choice = BATCH_REPLY_CHOICE_Status;
+		CLEAR_HEAD(preply->brp_un.brp_status);
+	}
+	if (preply->brp_code == 0) {
+		preply->brp_code = child->rq_reply.brp_code;
+		preply->brp_auxcode = child->rq_reply.brp_auxcode;
+	}
+
+	if (child->rq_type == PBS_BATCH_AsyrunJob)
+		jobid = child->rq_ind.rq_run.rq_jid;
+	else
+		jobid = child->rq_ind.rq_modify.rq_objname;
+
+	if ((child->rq_reply.brp_choice == BATCH_REPLY_CHOICE_Text) &&
+		(child->rq_reply.brp_un.brp_txt.brp_str != NULL))
+		msg = child->rq_reply.brp_un.brp_txt.brp_str;
+	else {
+		set_err_msg(child->rq_reply.brp_code, msgbuf, ERR_MSG_SIZE);
+		msg = msgbuf;
+	}
+	sprintf(codebuf, "%d", child->rq_reply.brp_code);
+
+	pstat = (struct brp_status *)malloc(sizeof(struct brp_status));
+	if (pstat == (struct brp_status *)0)
+		return (PBSE_SYSTEM);
+	pstat->brp_objtype = MGR_OBJ_JOB;
+	(void)strncpy(pstat->brp_objname, jobid, sizeof(pstat->brp_objname) - 1);
+	pstat->brp_objname[sizeof(pstat->brp_objname) - 1] = '\0';
+	CLEAR_LINK(pstat->brp_stlink);
+	CLEAR_HEAD(pstat->brp_attr);
+	append_link(&preply->brp_un.brp_status, &pstat->brp_stlink, pstat);
+
+	if ((pal = attrlist_create(ATTR_JOBS_ERRCODE, NULL, strlen(codebuf) + 1)) == NULL)
+		return (PBSE_SYSTEM);
+	(void)strcpy(pal->al_value, codebuf);
+	append_link(&pstat->brp_attr, &pal->al_link, pal);
+
+	if ((pal = attrlist_create(ATTR_JOBS_ERRTEXT, NULL, strlen(msg) + 1)) == NULL)
+		return (PBSE_SYSTEM);
+	(void)strcpy(pal->al_value, msg);
+	append_link(&pstat->brp_attr, &pal->al_link, pal);
+
+	return (0);
+}
+
 /**
  * @brief
  * 		Send a reply to a batch request, reply either goes to a
@@ -239,7 +315,13 @@ reply_send(struct batch_request *request)
 	/* if this is a child request, just move the error to the parent */
 
 	if (request->rq_parentbr) {
-		if ((request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_NULL) && (request->rq_parentbr->rq_reply.brp_code == 0)) {
+		if ((request->rq_parentbr->rq_type == PBS_BATCH_ModifyJobs) ||
+			(request->rq_parentbr->rq_type == PBS_BATCH_AsyrunJobs)) {
+			/* the parent still has the error code if this fails */
+			if ((request->rq_reply.brp_code != 0) &&
+				(reply_job_error(request->rq_parentbr, request) != 0))
+				log_err(-1, "reply_send", "Unable to allocate Memory!\n");
+		} else if ((request->rq_parentbr->rq_reply.brp_choice == BATCH_REPLY_CHOICE_NULL) && (request->rq_parentbr->rq_reply.brp_code == 0)) {
 			request->rq_parentbr->rq_reply.brp_code = request->rq_reply.brp_code;
 			request->rq_parentbr->rq_reply.brp_auxcode = request->rq_reply.brp_auxcode;
 			if (request->rq_reply.brp_choice == BATCH_REPLY_CHOICE_Text) {
@@ -271,16 +353,14 @@ reply_send(struct batch_request *request)
 		 * for freeing the batch_request structure.
 		 */
 
-		ptask = (struct work_task *)GET_NEXT(task_list_event);
-		while (ptask) {
-			if ((ptask->wt_type == WORK_Deferred_Local) &&
-				(ptask->wt_parm1 == (void *)request)) {
-				delete_link(&ptask->wt_linkall);
-				append_link(&task_list_immed,
-					&ptask->wt_linkall, ptask);
-				return (0);
-			}
-			ptask = (struct work_task *)GET_NEXT(ptask->wt_linkall);
+		ptask = find_work_task(WORK_Deferred_Local,
+			(long)PBS_LOCAL_CONNECTION, (void *)request);
+		if (ptask) {
+			delete_link(&ptask->wt_linkall);
+			delete_link(&ptask->wt_linkevent);
+			append_link(&task_list_immed,
+				&ptask->wt_linkall, ptask);
+			return (0);
 		}
 
 		/* Uh Oh, should have found a task and didn't */
@@ -43,12 +43,14 @@
  * Included funtions are:
  *	post_modify_req()
  *	req_modifyjob()
+ *	req_modifyjobs()
  *	find_name_in_svrattrl()
  *	modify_job_attr()
  */
 #include <pbs_config.h>   /* the master config generated by configure */
 
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include "libpbs.h"
 #include <signal.h>
@@ -434,6 +436,67 @@ req_modifyjob(struct batch_request *preq)
 	reply_ack(preq);
 }
 
+/**
+ * @brief
+ * 		Service the Modify Jobs Request, used by the Scheduler to alter
+ *		many jobs at once.
+ *
+ * @par	Functionality:
+ *		Each job in the request is handed to req_modifyjob() as a child
+ *		Modify Job request, in order.  The attribute list of each job is
+ *		moved to its child, which frees it.  The reply to the client is
+ *		sent when the last child has replied; it carries the first error
+ *		any of them returned.
+ *
+ * @param[in] preq - pointer to batch request from client
+ */
+
+void
+req_modifyjobs(struct batch_request *preq)
+{
+	struct rq_modifyjobs	*pmj = &preq->rq_ind.rq_modifyjobs;
+	struct batch_request	*npreq;
+	int			 i;
+
+	++preq->rq_refct;	/* protect the request/reply struct */
+
+	for (i = 0; i < pmj->rq_count; i++) {
+		npreq = alloc_br(PBS_BATCH_ModifyJob);
+		if (npreq == NULL) {
+			if (preq->rq_reply.brp_code == 0)
+				preq->rq_reply.brp_code = PBSE_SYSTEM;
+			break;
+		}
+
+		npreq->rq_perm    = preq->rq_perm;
+		npreq->rq_fromsvr = preq->rq_fromsvr;
+		npreq->rq_conn    = preq->rq_conn;
+		npreq->rq_orgconn = preq->rq_orgconn;
+		npreq->rq_time    = preq->rq_time;
+		strcpy(npreq->rq_user, preq->rq_user);
+		strcpy(npreq->rq_host, preq->rq_host);
+		npreq->rq_extend  = preq->rq_extend;
+		npreq->rq_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+		npreq->rq_refct   = 0;
+
+		npreq->rq_ind.rq_modify.rq_cmd = pmj->rq_jobs[i].rq_cmd;
+		npreq->rq_ind.rq_modify.rq_objtype = pmj->rq_jobs[i].rq_objtype;
+		strcpy(npreq->rq_ind.rq_modify.rq_objname,
+			pmj->rq_jobs[i].rq_objname);
+		CLEAR_HEAD(npreq->rq_ind.rq_modify.rq_attr);
+		list_move(&pmj->rq_jobs[i].rq_attr,
+			&npreq->rq_ind.rq_modify.rq_attr);
+
+		npreq->rq_parentbr = preq;
+		preq->rq_refct++;
+
+		req_modifyjob(npreq);
+	}
+
+	if (--preq->rq_refct == 0)
+		reply_send(preq);
+}
+
 /**
  * @brief
  * 		Returns the svrattrl entry matching attribute 'name', or NULL if not found.
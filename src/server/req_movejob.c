@@ -253,10 +253,19 @@ req_orderjob(struct batch_request *req)
 	} else {
 		swap_link(&pjob1->ji_jobque,  &pjob2->ji_jobque);
 		swap_link(&pjob1->ji_alljobs, &pjob2->ji_alljobs);
+		/* refile both jobs in their owner lists under the new ranks */
+		svr_ownerjob_oper(pjob1, 1);
+		svr_ownerjob_oper(pjob2, 1);
+		svr_ownerjob_oper(pjob1, 0);
+		svr_ownerjob_oper(pjob2, 0);
 	}
 
-	/* need to update disk copy of both jobs to save new order */
+	/* need to update disk copy of both jobs to save new order, and
+	 * bump their mtime so the scheduler sees the new order
+	 */
 
+	pjob1->ji_modified = 1;
+	pjob2->ji_modified = 1;
 	(void)job_save(pjob1, SAVEJOB_FULL);
 	(void)job_save(pjob2, SAVEJOB_FULL);
 
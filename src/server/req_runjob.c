@@ -44,6 +44,7 @@
  *	check_and_provision_job()
  *	clear_from_defr()
  *	req_runjob()
+ *	req_asyrunjobs()
  *	req_runjob2()
  *	clear_exec_on_run_fail()
  *	req_stagein()
@@ -571,6 +572,60 @@ req_runjob(struct batch_request *preq)
 		reply_send(preq);
 	return;
 }
+/**
+ * @brief
+ * 		req_asyrunjobs - service the Asynchronous Run Jobs Request, used by
+ *		the Scheduler to run many jobs at once.
+ *
+ * @par	Functionality:
+ *		Each job in the request is handed to req_runjob() as a child
+ *		Asynchronous Run Job request, in order.  The children share the
+ *		destinations of the parent request, which frees them.  As for any
+ *		asynchronous run, a child replies once its job has been sent on its
+ *		way to the MOMs.  The reply to the client is sent when the last child
+ *		has replied; it carries the first error any of them returned.
+ *
+ * @param[in]	preq	-	Run Jobs Request
+ */
+void
+req_asyrunjobs(struct batch_request *preq)
+{
+	struct rq_runjobs	*prj = &preq->rq_ind.rq_runjobs;
+	struct batch_request	*npreq;
+	int			 i;
+
+	++preq->rq_refct;	/* protect the request/reply struct */
+
+	for (i = 0; i < prj->rq_count; i++) {
+		npreq = alloc_br(PBS_BATCH_AsyrunJob);
+		if (npreq == NULL) {
+			if (preq->rq_reply.brp_code == 0)
+				preq->rq_reply.brp_code = PBSE_SYSTEM;
+			break;
+		}
+
+		npreq->rq_perm    = preq->rq_perm;
+		npreq->rq_fromsvr = preq->rq_fromsvr;
+		npreq->rq_conn    = preq->rq_conn;
+		npreq->rq_orgconn = preq->rq_orgconn;
+		npreq->rq_time    = preq->rq_time;
+		strcpy(npreq->rq_user, preq->rq_user);
+		strcpy(npreq->rq_host, preq->rq_host);
+		npreq->rq_extend  = preq->rq_extend;
+		npreq->rq_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+		npreq->rq_refct   = 0;
+
+		npreq->rq_ind.rq_run = prj->rq_jobs[i];
+
+		npreq->rq_parentbr = preq;
+		preq->rq_refct++;
+
+		req_runjob(npreq);
+	}
+
+	if (--preq->rq_refct == 0)
+		reply_send(preq);
+}
 /**
  * @brief
  * 		req_runjob - service the Run Job and Asyc Run Job Requests
@@ -55,6 +55,7 @@
  * 	build_selentry()
  * 	build_selist()
  * 	select_subjob()
+ * 	sel_single_user()
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
@@ -102,6 +103,7 @@ static void free_sellist(struct select_list *pslist);
 static int  sel_attr(attribute *, struct select_list *);
 static int  select_job(job *, struct select_list *, int, int);
 static int  select_subjob(int, struct select_list *);
+static char *sel_single_user(struct select_list *);
 
 
 /**
@@ -333,6 +335,8 @@ req_selectjobs(struct batch_request *preq)
 	char		   *pstate = NULL;
 	int		    rc;
 	struct select_list *selistp;
+	pbs_list_head	   *pownjobs = NULL;
+	int		    nownjobs;
 
 	/*
 	 * if the letter T (or t) is in the extend string,  select subjobs
@@ -392,14 +396,26 @@ req_selectjobs(struct batch_request *preq)
 	}
 	pselx = &preply->brp_un.brp_select;
 
+	/*
+	 * If selecting on a single user, walk that owner's jobs from the
+	 * owner index rather than every job, unless the queue is smaller.
+	 */
+	pownjobs = find_ownerjobs(sel_single_user(selistp), &nownjobs);
+	if (pownjobs && pque && (pque->qu_numjobs < nownjobs))
+		pownjobs = NULL;
+
 	/* now start checking for jobs that match the selection criteria */
 
-	if (pque)
+	if (pownjobs)
+		pjob = (job *)GET_NEXT(*pownjobs);
+	else if (pque)
 		pjob = (job *)GET_NEXT(pque->qu_jobs);
 	else
 		pjob = (job *)GET_NEXT(svr_alljobs);
 	while (pjob) {
-		if (server.sv_attr[(int)SRV_ATR_query_others].at_val.at_long ||
+		if (pownjobs && pque && (pjob->ji_qhdr != pque))
+			;	/* owner's job in another queue */
+		else if (server.sv_attr[(int)SRV_ATR_query_others].at_val.at_long ||
 			(svr_authorize_jobreq(preq, pjob) == 0)) {
 
 			/* either job owner or has special permission to see job */
@@ -445,7 +461,9 @@ req_selectjobs(struct batch_request *preq)
 				}
 			}
 		}
-		if (pque)
+		if (pownjobs)
+			pjob = (job *)GET_NEXT(pjob->ji_ownerjobs);
+		else if (pque)
 			pjob = (job *)GET_NEXT(pjob->ji_jobque);
 		else
 			pjob = (job *)GET_NEXT(pjob->ji_alljobs);
@@ -829,3 +847,43 @@ select_subjob(int state, struct select_list *psel)
 	}
 	return (1);
 }
+
+/**
+ * @brief
+ *		Find the user named by a select on the user list, if the select
+ *		can only match jobs owned by that one user.
+ *
+ * @par
+ *		Only a plain single entry user list qualifies; a list of several
+ *		users or an entry with a +/- prefix falls back to all jobs.  The
+ *		entry still goes through acl_check() in select_job(), so the host
+ *		part of "user@host" is matched there.
+ *
+ * @param[in]	psel	-	pointer to select list
+ *
+ * @return	char *
+ * @retval	user name from the select list
+ * @retval	NULL	: the select is not limited to one user
+ */
+
+static char *
+sel_single_user(struct select_list *psel)
+{
+	struct array_strings *pas;
+	char		     *pstr;
+
+	for (; psel; psel = psel->sl_next) {
+		if (psel->sl_atindx != (int)JOB_ATR_userlst)
+			continue;
+		if (((psel->sl_attr.at_flags & ATR_VFLAG_SET) == 0) ||
+			((pas = psel->sl_attr.at_val.at_arst) == NULL) ||
+			(pas->as_usedptr != 1))
+			continue;
+		pstr = pas->as_string[0];
+		if ((*pstr == '\0') || (*pstr == '@') ||
+			(*pstr == '+') || (*pstr == '-'))
+			continue;
+		return (pstr);
+	}
+	return (NULL);
+}
@@ -49,6 +49,9 @@
  * 	status_que()
  * 	req_stat_node()
  * 	status_node()
+ * 	free_node_snap()
+ * 	copy_node_snap()
+ * 	find_node_snap()
  * 	req_stat_svr()
  * 	req_stat_sched()
  * 	update_state_ct()
@@ -100,6 +103,7 @@ extern time_t	     time_now;
 extern char	    *msg_init_norerun;
 extern int resc_access_perm;
 extern long svr_history_enable;
+extern int scheduler_sock;
 
 /* Extern Functions */
 
@@ -115,10 +119,24 @@ extern int svr_chk_histjob(job *);
 
 static int bad;
 
+/*
+ * Snapshot of the status of all nodes, one per distinct requester
+ * permission set, reused while younger than node_status_max_age.
+ */
+#define NODE_SNAP_SLOTS 4
+static struct node_snap {
+	int		ns_perm;	/* rq_perm the snapshot was built with */
+	time_t		ns_time;	/* when built, 0 if slot unused */
+	pbs_list_head	ns_status;	/* list of brp_status */
+} node_snap[NODE_SNAP_SLOTS];
+
 /* The following private support functions are included */
 
 static int  status_que(pbs_queue *, struct batch_request *, pbs_list_head *);
 static int status_node(struct pbsnode *, struct batch_request *, pbs_list_head *);
+static void free_node_snap(struct node_snap *);
+static int copy_node_snap(struct node_snap *, pbs_list_head *);
+static struct node_snap *find_node_snap(struct batch_request *);
 static int status_resv(resc_resv *, struct batch_request *, pbs_list_head *);
 
 /**
@@ -543,6 +561,7 @@ req_stat_node(struct batch_request *preq)
 	struct batch_reply  *preply;
 	svrattrl	    *pal;
 	struct pbsnode	    *pnode = (struct pbsnode*)0;
+	struct node_snap    *psnap;
 	int		    rc   = 0;
 	int		    type = 0;
 	int		    i;
@@ -580,6 +599,10 @@ req_stat_node(struct batch_request *preq)
 	if (type == 0) {		/*get status of the named node*/
 		rc = status_node(pnode, preq, &preply->brp_un.brp_status);
 
+	} else if ((psnap = find_node_snap(preq)) != NULL) {
+		/* get status of all nodes from a recent snapshot */
+		rc = copy_node_snap(psnap, &preply->brp_un.brp_status);
+
 	} else {			/*get status of all nodes     */
 
 		for (i=0; i<svr_totnodes; i++) {
@@ -689,6 +712,158 @@ status_node(struct pbsnode *pnode, struct batch_request *preq, pbs_list_head *ps
 }
 
 
+/**
+ * @brief
+ * 		free_node_snap - release the status held in a node status snapshot
+ *		and mark the slot unused.
+ *
+ * @param[in,out]	psnap	-	snapshot slot to release
+ */
+
+static void
+free_node_snap(struct node_snap *psnap)
+{
+	struct brp_status *pstat;
+
+	while ((pstat = (struct brp_status *)GET_NEXT(psnap->ns_status)) != NULL) {
+		delete_link(&pstat->brp_stlink);
+		free_attrlist(&pstat->brp_attr);
+		(void)free(pstat);
+	}
+	psnap->ns_time = 0;
+}
+
+/**
+ * @brief
+ * 		copy_node_snap - append a copy of the status held in a snapshot
+ *		to the reply, the reply is freed independently of the snapshot.
+ *
+ * @param[in]	psnap	-	snapshot to copy from
+ * @param[in,out]	pstathd	-	head of list to append status to
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	PBSE_SYSTEM	: out of memory
+ */
+
+static int
+copy_node_snap(struct node_snap *psnap, pbs_list_head *pstathd)
+{
+	struct brp_status *pstat;
+	struct brp_status *pnew;
+	svrattrl	  *pal;
+	svrattrl	  *pnewal;
+
+	pstat = (struct brp_status *)GET_NEXT(psnap->ns_status);
+	while (pstat) {
+		pnew = (struct brp_status *)malloc(sizeof(struct brp_status));
+		if (pnew == (struct brp_status *)0)
+			return (PBSE_SYSTEM);
+		pnew->brp_objtype = pstat->brp_objtype;
+		(void)strcpy(pnew->brp_objname, pstat->brp_objname);
+		CLEAR_LINK(pnew->brp_stlink);
+		CLEAR_HEAD(pnew->brp_attr);
+		append_link(pstathd, &pnew->brp_stlink, pnew);
+
+		pal = (svrattrl *)GET_NEXT(pstat->brp_attr);
+		while (pal) {
+			pnewal = attrlist_alloc(pal->al_nameln, pal->al_rescln,
+				pal->al_valln);
+			if (pnewal == (svrattrl *)0)
+				return (PBSE_SYSTEM);
+			(void)memcpy(pnewal->al_name, pal->al_name,
+				pal->al_nameln + pal->al_rescln + pal->al_valln);
+			pnewal->al_flags = pal->al_flags;
+			pnewal->al_op = pal->al_op;
+			pnewal->al_refct = 1;
+			append_link(&pnew->brp_attr, &pnewal->al_link, pnewal);
+			pal = (svrattrl *)GET_NEXT(pal->al_link);
+		}
+		pstat = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ * 		find_node_snap - find, or rebuild, the snapshot of the status of all
+ *		nodes usable to answer this request.
+ *
+ * @par
+ *		Only requests for all attributes of all nodes are answered from a
+ *		snapshot, and only when the server attribute node_status_max_age
+ *		is set to a non-zero number of seconds.  The Scheduler and local
+ *		requests are always given the current status.  A snapshot is kept
+ *		for each distinct requester permission set as the permissions
+ *		decide which attributes are encoded.
+ *
+ * @param[in]	preq	-	ptr to the decoded request
+ *
+ * @return	struct node_snap *
+ * @retval	snapshot	: to copy the reply from
+ * @retval	NULL	: build the reply from the nodes
+ */
+
+static struct node_snap *
+find_node_snap(struct batch_request *preq)
+{
+	long		  max_age = 0;
+	int		  i;
+	int		  rc = 0;
+	struct node_snap *psnap = NULL;
+
+	if (server.sv_attr[(int)SVR_ATR_node_status_max_age].at_flags & ATR_VFLAG_SET)
+		max_age = server.sv_attr[(int)SVR_ATR_node_status_max_age].at_val.at_long;
+
+	if (max_age <= 0) {
+		for (i = 0; i < NODE_SNAP_SLOTS; i++) {
+			if (node_snap[i].ns_time != 0)
+				free_node_snap(&node_snap[i]);
+		}
+		return (NULL);
+	}
+
+	if ((preq->rq_conn == scheduler_sock) ||
+		(preq->rq_conn == PBS_LOCAL_CONNECTION) ||
+		((preq->rq_perm & ATR_DFLAG_RDACC) == 0) ||
+		(GET_NEXT(preq->rq_ind.rq_status.rq_attr) != NULL))
+		return (NULL);
+
+	/* find the slot for these permissions, else reuse the oldest */
+	for (i = 0; i < NODE_SNAP_SLOTS; i++) {
+		if ((node_snap[i].ns_time != 0) &&
+			(node_snap[i].ns_perm == preq->rq_perm)) {
+			psnap = &node_snap[i];
+			break;
+		}
+		if ((psnap == NULL) || (node_snap[i].ns_time < psnap->ns_time))
+			psnap = &node_snap[i];
+	}
+
+	if ((psnap->ns_time != 0) && (psnap->ns_perm == preq->rq_perm) &&
+		(time_now - psnap->ns_time < max_age))
+		return (psnap);
+
+	if (psnap->ns_time == 0)
+		CLEAR_HEAD(psnap->ns_status);
+	else
+		free_node_snap(psnap);
+
+	for (i = 0; i < svr_totnodes; i++) {
+		rc = status_node(pbsndlist[i], preq, &psnap->ns_status);
+		if (rc)
+			break;
+	}
+	if (rc) {
+		free_node_snap(psnap);
+		return (NULL);
+	}
+	psnap->ns_perm = preq->rq_perm;
+	psnap->ns_time = time_now;
+	return (psnap);
+}
+
+
 
 
 /**
@@ -71,6 +71,8 @@
  *		determine_accruetype() - determines accruetype
  *		alter_eligibletime() - resets sampletime of job
  *		eval_chkpnt()	   - insure job checkpoint .ge. queues min. time
+ *		svr_ownerjob_oper() - add/delete a job in the per owner job index
+ *		find_ownerjobs()   - find the jobs of an owner in the job index
  *
  * Private functions
  *		chk_svr_resc_limit() - check job requirements againt queue/server limits
@@ -156,6 +158,16 @@ static void running_jobs_count(struct work_task *);
 
 /** For faster job lookup through AVL tree */
 static void svr_avljob_oper(job *pjob, int delkey);
+static void svr_ownerjobs_disable(void);
+
+/*
+ * The jobs of a single owner, kept in the AVL_jowner index under the
+ * owner's user name and linked through ji_ownerjobs in queue rank order.
+ */
+struct owner_jobs {
+	pbs_list_head	oj_jobs;	/* jobs of this owner */
+	int		oj_numjobs;	/* number of jobs in oj_jobs */
+};
 
 /* Global Data Items: */
 extern char* msg_noloopbackif;
@@ -263,6 +275,7 @@ svr_enquejob(job *pjob)
 				 * faster compared to linked list traverse.
 				 */
 				svr_avljob_oper(pjob, 0);
+				svr_ownerjob_oper(pjob, 0);
 			}
 			server.sv_qs.sv_numjobs++;
 			server.sv_jobstates[pjob->ji_qs.ji_state]++;
@@ -314,6 +327,7 @@ svr_enquejob(job *pjob)
 	 * faster compared to linked list traverse.
 	 */
 	svr_avljob_oper(pjob, 0);
+	svr_ownerjob_oper(pjob, 0);
 
 	server.sv_qs.sv_numjobs++;
 	server.sv_jobstates[pjob->ji_qs.ji_state]++;
@@ -518,6 +532,7 @@ svr_dequejob(job *pjob)
 		 * added for faster job search i.e. find_job().
 		 */
 		svr_avljob_oper(pjob, 1);
+		svr_ownerjob_oper(pjob, 1);
 
 		if (--server.sv_qs.sv_numjobs < 0)
 			bad_ct = 1;
@@ -596,6 +611,7 @@ int
 svr_setjobstate(job *pjob, int newstate, int newsubstate)
 {
 	int    changed = 0;
+	int    sync = 0;
 	int    oldstate;
 	pbs_queue *pque = pjob->ji_qhdr;
 	long newaccruetype;
@@ -616,15 +632,41 @@ svr_setjobstate(job *pjob, int newstate, int newsubstate)
 
 		/* Not a new job, update the counts and save if needed */
 
-		if (pjob->ji_qs.ji_substate != newsubstate)
+		if (pjob->ji_qs.ji_substate != newsubstate) {
 			changed = 1;
 
+			/*
+			 * pbsd_init_job() requeues a job recovered in PRERUN or
+			 * PROVISION, but keeps a RUNNING one on its nodes and
+			 * cleans up an ABORT one.  So a job which leaves them for
+			 * RUNNING, or which is aborted, is recorded at once even
+			 * when its state stays the same.
+			 */
+			if ((newsubstate == JOB_SUBSTATE_RUNNING) ||
+				(newsubstate == JOB_SUBSTATE_ABORT) ||
+				(((pjob->ji_qs.ji_substate == JOB_SUBSTATE_PRERUN) ||
+				(pjob->ji_qs.ji_substate == JOB_SUBSTATE_PROVISION)) &&
+				(newsubstate != JOB_SUBSTATE_PRERUN) &&
+				(newsubstate != JOB_SUBSTATE_PROVISION)))
+				sync = 1;
+		}
+
 		/* if the state is changing, also update the state counts */
 
 		if ((oldstate = pjob->ji_qs.ji_state) != (long)newstate) {
 
 			pjob->ji_modifyct = 0; /* force write to disk */
 			changed = 1;
+
+			/*
+			 * a job sent to execution, ending or moved must be
+			 * recorded before anything else happens to it, else
+			 * a restarted server could run it a second time
+			 */
+			if ((newstate == JOB_STATE_RUNNING) ||
+				(newstate == JOB_STATE_EXITING) ||
+				(newstate == JOB_STATE_MOVED))
+				sync = 1;
 			server.sv_jobstates[oldstate]--;
 			server.sv_jobstates[newstate]++;
 			if (pque != (pbs_queue *)0) {
@@ -698,7 +740,10 @@ svr_setjobstate(job *pjob, int newstate, int newsubstate)
 		set_entity_resc_sum_queued(pjob, pjob->ji_qhdr, NULL, DECR);
 	}
 
-	if (pjob->ji_modified)
+	if (sync)
+		return (job_save_db_sync(pjob,
+			pjob->ji_modified ? SAVEJOB_FULL : SAVEJOB_QUICK));
+	else if (pjob->ji_modified)
 		return (job_save(pjob, SAVEJOB_FULL));
 	else if (changed)
 		return (job_save(pjob, SAVEJOB_QUICK));
@@ -5699,3 +5744,193 @@ AVL_OP_FAIL:
 	}
 }
 
+
+/**
+ * @brief
+ *		Add/Delete the job to/from the per owner job index based on the
+ *		boolean value of "delkey" parameter.
+ *
+ * @par Functionality:
+ *		The index is keyed on the owner's user name (without the @host
+ *		suffix) and each entry holds the list of that owner's jobs in
+ *		queue rank order, the same order as svr_alljobs.  This lets a
+ *		select by user walk only that user's jobs.  If it fails to
+ *		allocate an entry, the index is dropped by svr_ownerjobs_disable()
+ *		and the select falls back to walking all jobs.
+ *
+ * @param[in]	pjob	-	job structure to be operated on.
+ * @param[in]	delkey	-	0 to add the job.
+ *							1 to delete the job.
+ *
+ * @see	svr_enquejob()
+ *		svr_dequejob()
+ *		req_orderjob()
+ *
+ * @return	void
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ *
+ */
+void
+svr_ownerjob_oper(job *pjob, int delkey)
+{
+	AVL_IX_REC *pkey;
+	struct owner_jobs *poj;
+	job	*pjcur;
+	int	linked;
+	char	owner[PBS_MAXUSER+1];
+
+	if ((AVL_jowner == NULL) || (pjob == NULL) ||
+		((pjob->ji_wattr[(int)JOB_ATR_job_owner].at_flags & ATR_VFLAG_SET) == 0))
+		return;
+
+	/* a link pointing back to itself is not on any owner list */
+	linked = (pjob->ji_ownerjobs.ll_next != &pjob->ji_ownerjobs);
+	if (linked != delkey)
+		return;
+
+	get_jobowner(pjob->ji_wattr[(int)JOB_ATR_job_owner].at_val.at_str, owner);
+	pkey = svr_avlkey_create(owner);
+	if (pkey == NULL) {
+		svr_ownerjobs_disable();
+		return;
+	}
+
+	if (avl_find_key(pkey, AVL_jowner) == AVL_IX_OK)
+		poj = (struct owner_jobs *)pkey->recptr;
+	else
+		poj = NULL;
+
+	if (delkey) {
+		delete_link(&pjob->ji_ownerjobs);
+		if ((poj != NULL) && (--poj->oj_numjobs <= 0)) {
+			(void)avl_delete_key(pkey, AVL_jowner);
+			free(poj);
+		}
+		free(pkey);
+		return;
+	}
+
+	if (poj == NULL) {
+		poj = malloc(sizeof(struct owner_jobs));
+		if (poj == NULL) {
+			free(pkey);
+			svr_ownerjobs_disable();
+			return;
+		}
+		CLEAR_HEAD(poj->oj_jobs);
+		poj->oj_numjobs = 0;
+		pkey->recptr = poj;
+		if (avl_add_key(pkey, AVL_jowner) != AVL_IX_OK) {
+			free(poj);
+			free(pkey);
+			svr_ownerjobs_disable();
+			return;
+		}
+	}
+	free(pkey);
+
+	/* place into the owner's list in order of queue rank from the end */
+
+	pjcur = (job *)GET_PRIOR(poj->oj_jobs);
+	while (pjcur) {
+		if ((unsigned long)pjob->ji_wattr[(int)JOB_ATR_qrank].at_val.at_long >=
+			(unsigned long)pjcur->ji_wattr[(int)JOB_ATR_qrank].at_val.at_long)
+			break;
+		pjcur = (job *)GET_PRIOR(pjcur->ji_ownerjobs);
+	}
+	if (pjcur == 0)
+		insert_link(&poj->oj_jobs, &pjob->ji_ownerjobs, pjob,
+			LINK_INSET_AFTER);
+	else
+		insert_link(&pjcur->ji_ownerjobs, &pjob->ji_ownerjobs, pjob,
+			LINK_INSET_AFTER);
+	poj->oj_numjobs++;
+}
+
+/**
+ * @brief
+ *		Drop the per owner job index after a failed update.
+ *
+ * @par Functionality:
+ *		Unlinks every job from its owner list, frees the index entries and
+ *		turns off the global switch AVL_jowner so that select falls back
+ *		to walking all jobs, the same way find_job() falls back when
+ *		AVL_jctx is dropped.
+ *
+ * @par	Linkage scope:
+ *		static (local)
+ *
+ * @return	void
+ */
+static void
+svr_ownerjobs_disable(void)
+{
+	AVL_IX_REC *pe;
+	job	*pjob;
+
+	if (AVL_jowner == NULL)
+		return;
+
+	log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
+		msg_daemonname, "AVL: owner index update failed, using LinkedList.");
+
+	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs))
+		CLEAR_LINK(pjob->ji_ownerjobs);
+
+	pe = malloc(sizeof(AVL_IX_REC) + PBS_MAXUSER + 1);
+	if (pe != NULL) {
+		avl_first_key(AVL_jowner);
+		while (avl_next_key(pe, AVL_jowner) == AVL_IX_OK)
+			free(pe->recptr);
+		free(pe);
+	}
+	avl_destroy_index(AVL_jowner);
+	free(AVL_jowner);
+	AVL_jowner = NULL;
+}
+
+/**
+ * @brief
+ *		Find the jobs of an owner in the per owner job index.
+ *
+ * @param[in]	user	-	user name, an @host suffix is ignored
+ * @param[out]	pnumjobs -	number of jobs on the returned list
+ *
+ * @return	pbs_list_head *
+ * @retval	list of the owner's jobs, linked through ji_ownerjobs
+ * @retval	NULL	: the index is not available, walk svr_alljobs instead
+ *
+ * @par	Reentrancy:
+ *		MT-unsafe
+ */
+pbs_list_head *
+find_ownerjobs(char *user, int *pnumjobs)
+{
+	static pbs_list_head no_jobs;
+	AVL_IX_REC *pkey;
+	struct owner_jobs *poj = NULL;
+	char	owner[PBS_MAXUSER+1];
+
+	if ((AVL_jowner == NULL) || (user == NULL))
+		return (NULL);
+
+	get_jobowner(user, owner);
+	pkey = svr_avlkey_create(owner);
+	if (pkey == NULL)
+		return (NULL);
+	if (avl_find_key(pkey, AVL_jowner) == AVL_IX_OK)
+		poj = (struct owner_jobs *)pkey->recptr;
+	free(pkey);
+
+	if (poj == NULL) {
+		if (no_jobs.ll_next == NULL)
+			CLEAR_HEAD(no_jobs);
+		*pnumjobs = 0;
+		return (&no_jobs);
+	}
+	*pnumjobs = poj->oj_numjobs;
+	return (&poj->oj_jobs);
+}
@@ -314,6 +314,8 @@ local_move(job *jobp, struct batch_request *req)
 
 	jobp->ji_lastdest = 0;	/* reset in case of another route */
 
+	/* queue, rank and reservation changed, bump mtime for the scheduler */
+	jobp->ji_modified = 1;
 	(void)job_save(jobp, SAVEJOB_FULL);
 
 	/* If a scheduling cycle is in progress, then this moved job may have
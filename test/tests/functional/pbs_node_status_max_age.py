@@ -0,0 +1,104 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2016 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# The PBS Pro software is licensed under the terms of the GNU Affero General
+# Public License agreement ("AGPL"), except where a separate commercial license
+# agreement for PBS Pro version 14 or later has been executed in writing with
+# Altair.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software - under
+# a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+
+import os
+from tests.functional import *
+
+
+class TestNodeStatusMaxAge(TestFunctional):
+    """
+    Test the node_status_max_age server attribute, which lets the status of
+    all vnodes be answered from a snapshot of bounded age
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.vn = self.mom.shortname
+
+    def node_comment(self, id=None):
+        """
+        Return the comment of the mom's vnode, from a status of all vnodes
+        or, if id is given, from a status of that vnode alone
+        """
+        for n in self.server.status(NODE, id=id):
+            if n['id'] == self.vn:
+                return n.get('comment')
+        return None
+
+    def test_snapshot_reused(self):
+        """
+        Within node_status_max_age the status of all vnodes is the one
+        built for an earlier request, while the status of a single vnode
+        and the status of all vnodes once the attribute is unset are current
+        """
+        a = {'node_status_max_age': 300}
+        self.server.manager(MGR_CMD_SET, SERVER, a, expect=True)
+        self.node_comment()
+        a = {'comment': 'after snapshot'}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.vn, expect=True)
+        self.assertNotEqual(self.node_comment(), 'after snapshot')
+        self.assertEqual(self.node_comment(id=self.vn), 'after snapshot')
+        self.server.manager(MGR_CMD_UNSET, SERVER, 'node_status_max_age',
+                            expect=True)
+        self.assertEqual(self.node_comment(), 'after snapshot')
+
+    def test_invalid_value(self):
+        """
+        A negative node_status_max_age is rejected and the attribute is
+        left unset
+        """
+        try:
+            self.server.manager(MGR_CMD_SET, SERVER,
+                                {'node_status_max_age': -1})
+        except PbsManagerError, e:
+            self.assertNotEqual(e.rc, 0)
+        self.server.expect(SERVER, 'node_status_max_age', op=UNSET)
+
+    def test_print_server(self):
+        """
+        node_status_max_age is part of the server configuration printed
+        by qmgr
+        """
+        a = {'node_status_max_age': 60}
+        self.server.manager(MGR_CMD_SET, SERVER, a, expect=True)
+        qmgr = os.path.join(self.server.pbs_conf['PBS_EXEC'], 'bin', 'qmgr')
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=[qmgr, '-c', 'print server'], sudo=True)
+        self.assertTrue('set server node_status_max_age = 60' in
+                        '\n'.join(ret['out']))
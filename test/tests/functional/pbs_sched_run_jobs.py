@@ -0,0 +1,105 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2016 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# The PBS Pro software is licensed under the terms of the GNU Affero General
+# Public License agreement ("AGPL"), except where a separate commercial license
+# agreement for PBS Pro version 14 or later has been executed in writing with
+# Altair.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software - under
+# a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestSchedRunJobs(TestFunctional):
+    """
+    Test the run requests the scheduler queues in throughput mode and
+    sends to the server with one pbs_asyrunjobs() request
+    """
+
+    reject_hook = """
+import pbs
+e = pbs.event()
+if e.job.Job_Name == 'reject':
+    e.reject("runs of this job are rejected")
+e.accept()
+"""
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 3}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname,
+                            expect=True)
+        self.server.manager(MGR_CMD_SET, SCHED, {'throughput_mode': 'True'},
+                            expect=True)
+
+    def submit_jobs(self, names):
+        """
+        Submit a job for each of names and run one scheduling cycle for all
+        of them. Return the job ids.
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'},
+                            expect=True)
+        jids = []
+        for name in names:
+            a = {'Resource_List.select': '1:ncpus=1', ATTR_N: name}
+            jids.append(self.server.submit(Job(TEST_USER, attrs=a)))
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'},
+                            expect=True)
+        return jids
+
+    def test_batched_runs(self):
+        """
+        All the jobs run in one cycle are run by the server
+        """
+        jids = self.submit_jobs(['j1', 'j2', 'j3'])
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+
+    def test_partial_failure(self):
+        """
+        A job whose run is rejected stays queued with a comment and is
+        logged by the scheduler with its id, while the other jobs of the
+        same request run
+        """
+        a = {'event': 'runjob', 'enabled': 'True'}
+        rv = self.server.create_import_hook('reject_run', a,
+                                            self.reject_hook,
+                                            overwrite=True)
+        self.assertTrue(rv)
+        jids = self.submit_jobs(['j1', 'reject', 'j3'])
+        self.server.expect(JOB, {'job_state': 'R'}, id=jids[0])
+        self.server.expect(JOB, {'job_state': 'R'}, id=jids[2])
+        a = {'job_state': 'Q', 'comment': (MATCH_RE, 'PBS Error')}
+        self.server.expect(JOB, a, id=jids[1])
+        self.scheduler.log_match(jids[1] + ';Failed to run',
+                                 max_attempts=10)